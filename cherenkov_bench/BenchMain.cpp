@@ -0,0 +1,39 @@
+// BenchMain.cpp
+//
+// Author: Matthew Dutson
+//
+// The entry point for the benchmarks. Usage: cherenkov_bench [output file] [config file] [min seconds] [filter]
+
+#include <TROOT.h>
+
+#include "KernelBench.h"
+#include "ThreadPool.h"
+
+using namespace std;
+using namespace boost::property_tree;
+using namespace cherenkov_simulator;
+
+int main(int argc, const char* argv[])
+{
+    string output_file = argc > 1 ? argv[1] : "Bench.csv";
+    string config_file = argc > 2 ? argv[2] : "Config.xml";
+    double min_time = argc > 3 ? stod(argv[3]) : 1.0;
+    string filter = argc > 4 ? argv[4] : "";
+    try
+    {
+        ptree config = Utility::ParseXMLFile(config_file).get_child("config");
+        auto n_threads = config.get<size_t>("simulation.n_threads");
+        if (n_threads > 1) ROOT::EnableThreadSafety();
+        ThreadPool::SetShared(n_threads);
+
+        Benchmark bench = Benchmark(min_time, filter);
+        KernelBench(config).RunAll(bench);
+        bench.WriteCSV(output_file);
+        return 0;
+    }
+    catch (runtime_error& err)
+    {
+        cout << err.what() << endl;
+        return -1;
+    }
+}
@@ -0,0 +1,78 @@
+// Benchmark.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of Benchmark.h
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "Benchmark.h"
+#include "Random.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+    string Benchmark::Result::Header()
+    {
+        return "Benchmark,Calls,Seconds,SecondsPerCall,ItemsPerSecond";
+    }
+
+    string Benchmark::Result::ToString() const
+    {
+        ostringstream row;
+        row << name << "," << n_calls << "," << seconds << "," << seconds / n_calls << "," << n_items / seconds;
+        return row.str();
+    }
+
+    Benchmark::Benchmark(double min_time, string filter) : min_time(min_time), filter(filter)
+    {
+        cout << Result::Header() << endl;
+    }
+
+    void Benchmark::Run(string name, double items_per_call, const function<void()>& body,
+                        const function<void()>& setup)
+    {
+        if (name.find(filter) == string::npos) return;
+        Random::Shared().SetSeed(bench_seed);
+        if (setup) setup();
+        body();
+
+        // At least three timed calls are made, so that slow benchmarks still give some idea of their spread.
+        Result result = Result();
+        result.name = name;
+        result.n_calls = 0;
+        result.seconds = 0.0;
+        while (result.seconds < min_time || result.n_calls < 3)
+        {
+            if (setup) setup();
+            auto start = chrono::steady_clock::now();
+            body();
+            chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+            result.seconds += elapsed.count();
+            result.n_calls++;
+        }
+        result.n_items = items_per_call * result.n_calls;
+        results.push_back(result);
+        cout << result.ToString() << endl;
+    }
+
+    const vector<Benchmark::Result>& Benchmark::Results() const
+    {
+        return results;
+    }
+
+    void Benchmark::WriteCSV(string filename) const
+    {
+        ofstream file = ofstream(filename);
+        file << Result::Header() << "\n";
+        for (const Result& result : results)
+            file << result.ToString() << "\n";
+        file.flush();
+        if (!file) throw runtime_error("Could not write benchmark results to " + filename);
+    }
+}
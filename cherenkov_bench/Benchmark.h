@@ -0,0 +1,84 @@
+// Benchmark.h
+//
+// Author: Matthew Dutson
+//
+// Definition of Benchmark class
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace cherenkov_simulator
+{
+    /*
+     * A minimal microbenchmark runner. Each benchmark is a body which is called repeatedly until the time spent in it
+     * reaches a minimum, after one untimed warm-up call. An optional setup function is called before every call of
+     * the body and is not timed, so bodies which modify their input can be given a fresh copy each time. The shared
+     * Random is reseeded with a fixed seed before each benchmark, so every run sees the same inputs.
+     */
+    class Benchmark
+    {
+    public:
+
+        /*
+         * The timing of a single benchmark. Items are whatever unit of work the benchmark counts, such as photons.
+         */
+        struct Result
+        {
+            std::string name;
+            uint64_t n_calls;
+            double seconds;
+            double n_items;
+
+            /*
+             * Creates a header for rows of data created with ToString().
+             */
+            static std::string Header();
+
+            /*
+             * Creates a string with comma separated fields: the name, the number of calls, the total time, the time
+             * per call, and the items per second.
+             */
+            std::string ToString() const;
+        };
+
+        /*
+         * Creates a runner which spends at least min_time seconds in each benchmark. Only benchmarks whose names
+         * contain the filter are run.
+         */
+        Benchmark(double min_time, std::string filter = "");
+
+        /*
+         * Runs the body as a benchmark with the specified name, if it passes the filter. Each call of the body counts
+         * items_per_call items. The result is printed as a CSV row as soon as it is finished.
+         */
+        void Run(std::string name, double items_per_call, const std::function<void()>& body,
+                 const std::function<void()>& setup = nullptr);
+
+        /*
+         * Returns the results of all benchmarks run so far.
+         */
+        const std::vector<Result>& Results() const;
+
+        /*
+         * Writes the results of all benchmarks run so far to a CSV file. Throws a runtime_error if the file can't be
+         * written.
+         */
+        void WriteCSV(std::string filename) const;
+
+    private:
+
+        // The seed given to Random::Shared() before each benchmark
+        static const unsigned int bench_seed = 12345;
+
+        double min_time;
+        std::string filter;
+        std::vector<Result> results;
+    };
+}
+
+#endif
@@ -0,0 +1,141 @@
+// KernelBench.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of KernelBench.h
+
+#include "KernelBench.h"
+#include "Random.h"
+
+using namespace std;
+using namespace boost::property_tree;
+
+namespace cherenkov_simulator
+{
+    KernelBench::KernelBench(const ptree& config) : monte_carlo(config), simulator(config), reconstructor(config)
+    {
+        sink = 0.0;
+        Random::Shared().SetSeed(1);
+        shower = monte_carlo.GenerateShower(Vec3(1, 1, -3), 1e6, -0.1, 1e19);
+
+        clean = simulator.SimulateShower(shower);
+        noisy = clean;
+        reconstructor.AddNoise(noisy);
+        subtracted = noisy;
+        reconstructor.SubtractAverageNoise(subtracted);
+        cleared = noisy;
+        triggered = reconstructor.ClearNoise(cleared);
+        has_impact = false;
+        if (triggered)
+        {
+            to_sdp = reconstructor.FitSDPlane(cleared);
+            has_impact = reconstructor.FindGroundImpact(cleared, impact);
+        }
+
+        // Photons are taken from the middle of the track, where the shower is near its maximum.
+        Shower middle = shower;
+        middle.IncrementDepth(500.0);
+        for (size_t i = 0; i < n_batch; i++)
+        {
+            Vec3 lens_impact = simulator.rot_to_world * simulator.RandomStopImpact();
+            Ray photon = simulator.JitteredRay(middle, lens_impact - middle.Position());
+            photon.PropagateToPoint(lens_impact);
+            lens_photons.push_back(photon);
+
+            photon.Transform(simulator.rot_to_world.Inverse());
+            if (!simulator.DeflectFromLens(photon)) continue;
+            mirror_rays.push_back(photon);
+
+            // The rest of SimulateOptics(), recording where the photon is detected.
+            Vec3 point;
+            if (simulator.CameraImpactPoint(photon, point)) continue;
+            if (!simulator.MirrorImpactPoint(photon, point)) continue;
+            photon.PropagateToPoint(point);
+            photon.Reflect(simulator.MirrorNormal(point));
+            if (!simulator.CameraImpactPoint(photon, point)) continue;
+            photon.PropagateToPoint(point);
+            camera_hits.emplace_back(photon.Time(), point);
+        }
+    }
+
+    void KernelBench::RunAll(Benchmark& bench)
+    {
+        PhotonCount data;
+
+        // Simulation kernels
+        bench.Run("SimulateShower", 1, [&]()
+        {
+            data = simulator.SimulateShower(shower);
+        });
+        bench.Run("SimulateOptics", lens_photons.size(), [&]()
+        {
+            for (const Ray& photon : lens_photons)
+                simulator.SimulateOptics(photon, data, 1);
+        }, [&]() { data = EmptyCount(); });
+        bench.Run("NegSphereImpact", mirror_rays.size(), [&]()
+        {
+            Vec3 point;
+            for (const Ray& ray : mirror_rays)
+            {
+                Simulator::NegSphereImpact(ray, point, simulator.mirror_radius);
+                sink += point.Z();
+            }
+        });
+        bench.Run("AddPhoton", camera_hits.size(), [&]()
+        {
+            for (const pair<double, Vec3>& hit : camera_hits)
+                data.AddPhoton(hit.first, hit.second, 1);
+        }, [&]() { data = EmptyCount(); });
+
+        // Noise and triggering kernels
+        bench.Run("AddNoise", 1, [&]()
+        {
+            reconstructor.AddNoise(data);
+        }, [&]() { data = clean; });
+        bench.Run("FindThreshold", 1, [&]()
+        {
+            sink += noisy.FindThreshold(reconstructor.sky_noise, reconstructor.trigr_thresh);
+        });
+        bench.Run("ClearNoise", 1, [&]()
+        {
+            sink += reconstructor.ClearNoise(data);
+        }, [&]() { data = noisy; });
+        bench.Run("GetTriggeringState", 1, [&]()
+        {
+            sink += reconstructor.GetTriggeringState(subtracted).size();
+        });
+
+        // Reconstruction kernels, which need a triggered shower
+        if (!triggered)
+        {
+            cout << "The canonical shower didn't trigger, so the fits weren't run" << endl;
+            return;
+        }
+        bench.Run("FitSDPlane", 1, [&]()
+        {
+            sink += reconstructor.FitSDPlane(cleared).XX();
+        });
+        bench.Run("MonocularFit", 1, [&]()
+        {
+            FitResult fit;
+            sink += reconstructor.MonocularFit(cleared, to_sdp, fit).ImpactParam();
+        });
+        if (has_impact)
+        {
+            bench.Run("HybridFit", 1, [&]()
+            {
+                FitResult fit;
+                sink += reconstructor.HybridFit(cleared, impact, to_sdp, fit).ImpactParam();
+            });
+        }
+        bench.Run("Reconstruct", 1, [&]()
+        {
+            sink += reconstructor.Reconstruct(cleared, triggered).triggered;
+        });
+    }
+
+    PhotonCount KernelBench::EmptyCount() const
+    {
+        return PhotonCount(simulator.count_params, simulator.MinTime(shower), simulator.MaxTime(shower));
+    }
+}
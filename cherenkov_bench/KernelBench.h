@@ -0,0 +1,74 @@
+// KernelBench.h
+//
+// Author: Matthew Dutson
+//
+// Definition of KernelBench class
+
+#ifndef KERNEL_BENCH_H
+#define KERNEL_BENCH_H
+
+#include <utility>
+#include <vector>
+#include <boost/property_tree/ptree.hpp>
+
+#include "Benchmark.h"
+#include "MonteCarlo.h"
+
+namespace cherenkov_simulator
+{
+    /*
+     * Benchmarks of the hot kernels of the simulation and reconstruction, run against a canonical shower: a 10^19 eV
+     * shower with a 10 km impact parameter, the same as the "typical" sample event. The fixtures (the noise-free,
+     * noisy, and cleared photon counts, and batches of photons at the corrector plate) are built once from a fixed
+     * seed. This class is a friend of Simulator and Reconstructor so that private kernels can be timed directly.
+     */
+    class KernelBench
+    {
+    public:
+
+        /*
+         * Builds the Simulator, Reconstructor, and fixtures from the configuration.
+         */
+        explicit KernelBench(const boost::property_tree::ptree& config);
+
+        /*
+         * Runs every benchmark through the runner.
+         */
+        void RunAll(Benchmark& bench);
+
+    private:
+
+        // The number of photons or rays in each batch
+        static const size_t n_batch = 100000;
+
+        MonteCarlo monte_carlo;
+        Simulator simulator;
+        Reconstructor reconstructor;
+
+        Shower shower;
+        PhotonCount clean;
+        PhotonCount noisy;
+        PhotonCount subtracted;
+        PhotonCount cleared;
+        bool triggered;
+        Mat3 to_sdp;
+        bool has_impact;
+        Vec3 impact;
+
+        // Photons at the corrector plate in the world frame, the same photons in the detector frame after passing the
+        // corrector, and arrival times and camera positions of detected photons
+        std::vector<Ray> lens_photons;
+        std::vector<Ray> mirror_rays;
+        std::vector<std::pair<double, Vec3>> camera_hits;
+
+        // Accumulates results so that the compiler can't discard the kernels
+        double sink;
+
+        /*
+         * Returns an empty photon count covering the arrival times of the canonical shower.
+         */
+        PhotonCount EmptyCount() const;
+    };
+}
+
+#endif
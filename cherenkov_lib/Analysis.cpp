@@ -4,12 +4,89 @@
 //
 // Implementation of Analysis.h
 
+#include <algorithm>
+
 #include "Analysis.h"
 
 using namespace std;
 
 namespace cherenkov_simulator
 {
+    Snapshot Analysis::TakeSnapshot(const PhotonCount& data)
+    {
+        Snapshot snapshot = Snapshot();
+        snapshot.valid = data.GetValid();
+        snapshot.pixl_sums = data.PixelSums();
+        SuperimposeTimes(data, snapshot.times, snapshot.counts);
+        return snapshot;
+    }
+
+    TGraph Analysis::MakeTimeProfile(const Snapshot& snapshot, bool crop)
+    {
+        // Keep one empty bin on either side of the signal so the edges of the profile are visible.
+        size_t n_bins = snapshot.counts.size();
+        size_t first = 0;
+        size_t last = n_bins;
+        if (crop)
+        {
+            while (first < n_bins && snapshot.counts[first] == 0.0) first++;
+            while (last > first && snapshot.counts[last - 1] == 0.0) last--;
+            if (first > 0) first--;
+            if (last < n_bins) last++;
+            if (last == first) last = min(first + 1, n_bins);
+        }
+
+        TGraph output = TGraph((int) (last - first), snapshot.times.data() + first, snapshot.counts.data() + first);
+        output.SetTitle("Detector Time Profile");
+        output.GetXaxis()->SetTitle("Time (s)");
+        output.GetYaxis()->SetTitle("Total Photons Seen");
+        return output;
+    }
+
+    TH2I Analysis::MakePixlProfile(const Snapshot& snapshot, string name, bool reverse_y, bool crop)
+    {
+        auto size = (int) snapshot.pixl_sums.size();
+        if (!crop)
+        {
+            TH2I histo = TH2I(name.c_str(), "Bin Signal Sums", size, 0, size, size, 0, size);
+            histo.SetXTitle("x Bin");
+            histo.SetYTitle("y Bin");
+            for (int x = 0; x < size; x++)
+                for (int y = 0; y < size; y++)
+                    if (snapshot.valid[x][y]) histo.Fill(x, reverse_y ? size - y - 1 : y, snapshot.pixl_sums[x][y]);
+            return histo;
+        }
+
+        int x_min = size, x_max = -1, y_min = size, y_max = -1;
+        for (int x = 0; x < size; x++)
+        {
+            for (int y = 0; y < size; y++)
+            {
+                if (snapshot.pixl_sums[x][y] == 0) continue;
+                int y_plot = reverse_y ? size - y - 1 : y;
+                x_min = min(x_min, x);
+                x_max = max(x_max, x);
+                y_min = min(y_min, y_plot);
+                y_max = max(y_max, y_plot);
+            }
+        }
+        if (x_max < 0) x_min = x_max = y_min = y_max = 0;
+
+        TH2I histo = TH2I(name.c_str(), "Bin Signal Sums", x_max - x_min + 1, x_min, x_max + 1, y_max - y_min + 1,
+                          y_min, y_max + 1);
+        histo.SetXTitle("x Bin");
+        histo.SetYTitle("y Bin");
+        for (int x = x_min; x <= x_max && x < size; x++)
+        {
+            for (int y_plot = y_min; y_plot <= y_max && y_plot < size; y_plot++)
+            {
+                int y = reverse_y ? size - y_plot - 1 : y_plot;
+                if (snapshot.pixl_sums[x][y] != 0) histo.Fill(x, y_plot, snapshot.pixl_sums[x][y]);
+            }
+        }
+        return histo;
+    }
+
     TGraph Analysis::MakeTimeProfile(const PhotonCount& data)
     {
         Double1D times, counts;
@@ -55,6 +132,15 @@ namespace cherenkov_simulator
         return histo;
     }
 
+    TGraphErrors Analysis::MakeFitGraph(const FitPoints& points)
+    {
+        Double1D angles = points.angles;
+        Double1D times = points.times;
+        Double1D time_err = points.time_err;
+        Double1D angle_err = Double1D(angles.size(), 0.0);
+        return TGraphErrors((int) angles.size(), angles.data(), times.data(), angle_err.data(), time_err.data());
+    }
+
     void Analysis::SuperimposeTimes(const PhotonCount& data, Double1D& times, Double1D& counts)
     {
         times = Double1D();
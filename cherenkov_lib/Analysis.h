@@ -10,14 +10,28 @@
 
 #include <vector>
 #include <TGraph.h>
+#include <TGraphErrors.h>
 #include <TH2.h>
 
 #include "DataStructures.h"
 #include "Geometric.h"
+#include "ProfileFitter.h"
 #include "Utility.h"
 
 namespace cherenkov_simulator
 {
+    /*
+     * The pixel sums and collapsed time profile of the data at one stage of processing. This is much smaller than the
+     * PhotonCount it was taken from, so it can be kept until it's known whether plots of that stage are needed.
+     */
+    struct Snapshot
+    {
+        Bool2D valid;
+        Int2D pixl_sums;
+        Double1D times;
+        Double1D counts;
+    };
+
     /*
      * Defines miscellaneous static methods for visualizing the results of a simulation.
      */
@@ -25,6 +39,25 @@ namespace cherenkov_simulator
     {
     public:
 
+        /*
+         * Records the pixel sums and time profile of the data.
+         */
+        static Snapshot TakeSnapshot(const PhotonCount& data);
+
+        /*
+         * Makes a TGraph of the collapsed time profile in the snapshot. If crop is true, only the bins around the
+         * nonzero counts are kept. Otherwise, the graph is the same as MakeTimeProfile() of the original data.
+         */
+        static TGraph MakeTimeProfile(const Snapshot& snapshot, bool crop = true);
+
+        /*
+         * Makes a 2D histogram of the pixel sums in the snapshot. If crop is true, the histogram is cropped to the
+         * smallest rectangle containing all nonzero pixels, with the same bin coordinates as the uncropped histogram.
+         * Otherwise, the histogram is the same as MakePixlProfile() of the original data.
+         */
+        static TH2I MakePixlProfile(const Snapshot& snapshot, std::string name, bool reverse_y = true,
+                                    bool crop = true);
+
         /*
          * Makes a TGraph of the collapsed time profile for the simulation.
          */
@@ -45,6 +78,12 @@ namespace cherenkov_simulator
          */
         static TH2C GetBooleanMap(const Bool2D& valid);
 
+        /*
+         * Makes a TGraphErrors of the time of each fit point against its angle in the shower-detector plane, with the
+         * time errors as error bars.
+         */
+        static TGraphErrors MakeFitGraph(const FitPoints& points);
+
     private:
 
         /*
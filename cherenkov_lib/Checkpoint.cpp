@@ -0,0 +1,91 @@
+// Checkpoint.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of Checkpoint.h
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <boost/property_tree/xml_parser.hpp>
+
+#include "Checkpoint.h"
+#include "Utility.h"
+
+using namespace std;
+using namespace boost::property_tree;
+
+namespace cherenkov_simulator
+{
+    Checkpoint::Checkpoint()
+    {
+        seed = 0;
+        shard = 0;
+        n_shards = 1;
+        next_attempt = 0;
+        next_id = 1;
+        n_rejected = 0;
+        n_culled = 0;
+        n_accepted = 0;
+        n_rows = 0;
+        n_chkv = 0;
+        csv_bytes = 0;
+        event_bytes = 0;
+        n_events = 0;
+    }
+
+    void Checkpoint::Save(string filename) const
+    {
+        ptree state = ptree();
+        state.put("checkpoint.seed", seed);
+        state.put("checkpoint.shard", shard);
+        state.put("checkpoint.n_shards", n_shards);
+        state.put("checkpoint.next_attempt", next_attempt);
+        state.put("checkpoint.next_id", next_id);
+        state.put("checkpoint.n_rejected", n_rejected);
+        state.put("checkpoint.n_culled", n_culled);
+        state.put("checkpoint.n_accepted", n_accepted);
+        state.put("checkpoint.n_rows", n_rows);
+        state.put("checkpoint.n_chkv", n_chkv);
+        state.put("checkpoint.csv_bytes", csv_bytes);
+        state.put("checkpoint.event_bytes", event_bytes);
+        state.put("checkpoint.n_events", n_events);
+
+        string temp_name = filename + ".tmp";
+        {
+            ofstream file = ofstream(temp_name);
+            write_xml(file, state);
+            file.flush();
+            if (file.fail()) throw runtime_error("Could not write checkpoint " + temp_name);
+        }
+        if (rename(temp_name.c_str(), filename.c_str()) != 0)
+            throw runtime_error("Could not replace checkpoint " + filename);
+    }
+
+    Checkpoint Checkpoint::Load(string filename)
+    {
+        try
+        {
+            ptree state = Utility::ParseXMLFile(filename).get_child("checkpoint");
+            Checkpoint checkpoint = Checkpoint();
+            checkpoint.seed = state.get<unsigned int>("seed");
+            checkpoint.shard = state.get<unsigned int>("shard");
+            checkpoint.n_shards = state.get<unsigned int>("n_shards");
+            checkpoint.next_attempt = state.get<uint64_t>("next_attempt");
+            checkpoint.next_id = state.get<uint64_t>("next_id");
+            checkpoint.n_rejected = state.get<uint64_t>("n_rejected");
+            checkpoint.n_culled = state.get<uint64_t>("n_culled");
+            checkpoint.n_accepted = state.get<uint64_t>("n_accepted");
+            checkpoint.n_rows = state.get<uint64_t>("n_rows");
+            checkpoint.n_chkv = state.get<uint64_t>("n_chkv");
+            checkpoint.csv_bytes = state.get<uint64_t>("csv_bytes");
+            checkpoint.event_bytes = state.get<uint64_t>("event_bytes");
+            checkpoint.n_events = state.get<uint64_t>("n_events");
+            return checkpoint;
+        }
+        catch (ptree_error& err)
+        {
+            throw runtime_error("Incomplete checkpoint " + filename + ": " + err.what());
+        }
+    }
+}
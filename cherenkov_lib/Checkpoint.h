@@ -0,0 +1,64 @@
+// Checkpoint.h
+//
+// Author: Matthew Dutson
+//
+// Definition of Checkpoint struct
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+
+namespace cherenkov_simulator
+{
+    /*
+     * The state of a Monte Carlo run after some number of showers, from which the run can be resumed. Each shower is
+     * simulated with its own seed from Utility::StreamSeed(), so the position in the random stream is all that's needed
+     * to reproduce the rest of the run. The byte counts are the lengths of the output files which are known to be
+     * complete, and anything past them is discarded on resume.
+     */
+    struct Checkpoint
+    {
+        /*
+         * The default constructor. Creates the state at the start of an unsharded run with seed zero.
+         */
+        Checkpoint();
+
+        // The position in the shower stream. A shard only simulates the attempts equal to shard modulo n_shards.
+        unsigned int seed;
+        unsigned int shard;
+        unsigned int n_shards;
+        uint64_t next_attempt;
+        uint64_t next_id;
+
+        // The number of attempts rejected by the analytic pre-filter without being simulated
+        uint64_t n_rejected;
+
+        // The photons over every simulated attempt which were culled by the acceptance cone or reached the camera
+        uint64_t n_culled;
+        uint64_t n_accepted;
+
+        // Aggregate statistics over the completed showers
+        uint64_t n_rows;
+        uint64_t n_chkv;
+
+        // The complete parts of the output files
+        uint64_t csv_bytes;
+        uint64_t event_bytes;
+        uint64_t n_events;
+
+        /*
+         * Writes the checkpoint to an XML file. The file is written under a temporary name and then renamed, so an
+         * interrupted save leaves the previous checkpoint intact. Throws a runtime_error if the file can't be written.
+         */
+        void Save(std::string filename) const;
+
+        /*
+         * Reads a checkpoint written by Save(). Throws a runtime_error if the file can't be read or is incomplete.
+         */
+        static Checkpoint Load(std::string filename);
+    };
+}
+
+#endif
@@ -0,0 +1,295 @@
+// Clustering.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of Clustering.h
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Clustering.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+    BitFrame::BitFrame() : BitFrame(0, 0) {}
+
+    BitFrame::BitFrame(size_t n_rows, size_t n_cols)
+    {
+        this->n_rows = n_rows;
+        this->n_cols = n_cols;
+        n_words = (n_cols + 63) / 64;
+        words = vector<uint64_t>(n_rows * n_words, 0);
+    }
+
+    size_t BitFrame::NRows() const
+    {
+        return n_rows;
+    }
+
+    size_t BitFrame::NCols() const
+    {
+        return n_cols;
+    }
+
+    size_t BitFrame::NWords() const
+    {
+        return n_words;
+    }
+
+    bool BitFrame::Get(size_t x, size_t y) const
+    {
+        return (Row(x)[y / 64] >> (y % 64) & 1) != 0;
+    }
+
+    void BitFrame::Set(size_t x, size_t y, bool value)
+    {
+        uint64_t bit = uint64_t(1) << (y % 64);
+        if (value) Row(x)[y / 64] |= bit;
+        else Row(x)[y / 64] &= ~bit;
+    }
+
+    const uint64_t* BitFrame::Row(size_t x) const
+    {
+        return &(words[x * n_words]);
+    }
+
+    uint64_t* BitFrame::Row(size_t x)
+    {
+        return &(words[x * n_words]);
+    }
+
+    bool BitFrame::Empty() const
+    {
+        for (uint64_t word : words)
+            if (word != 0) return false;
+        return true;
+    }
+
+    vector<BitFrame> BitFrame::FromMatrix(const Bool3D& matrix)
+    {
+        size_t n_rows = matrix.size();
+        size_t n_cols = n_rows == 0 ? 0 : matrix[0].size();
+        size_t n_bins = n_cols == 0 ? 0 : matrix[0][0].size();
+        vector<BitFrame> frames = vector<BitFrame>(n_bins, BitFrame(n_rows, n_cols));
+
+        // Each row is only written by the thread which owns its x index.
+        ThreadPool::Shared().ParallelFor(n_rows, [&](size_t begin, size_t end)
+        {
+            for (size_t x = begin; x < end; x++)
+                for (size_t y = 0; y < n_cols; y++)
+                    for (size_t t = 0; t < n_bins; t++)
+                        if (matrix[x][y][t]) frames[t].Set(x, y);
+        });
+        return frames;
+    }
+
+    ClusterLabeler::ClusterLabeler(const vector<BitFrame>& frames, bool connect_time)
+    {
+        // Find the runs of each frame in parallel, then concatenate them.
+        size_t n_frames = frames.size();
+        vector<vector<Run>> frame_runs = vector<vector<Run>>(n_frames);
+        ThreadPool::Shared().ParallelFor(n_frames, [&](size_t begin, size_t end)
+        {
+            for (size_t t = begin; t < end; t++)
+                FindRuns(frames[t], frame_runs[t]);
+        });
+        frame_bgn = vector<size_t>(n_frames + 1, 0);
+        for (size_t t = 0; t < n_frames; t++)
+            frame_bgn[t + 1] = frame_bgn[t] + frame_runs[t].size();
+        runs.reserve(frame_bgn[n_frames]);
+        for (const vector<Run>& curr_runs : frame_runs)
+            runs.insert(runs.end(), curr_runs.begin(), curr_runs.end());
+
+        vector<size_t> parent = vector<size_t>(runs.size());
+        for (size_t i = 0; i < parent.size(); i++)
+            parent[i] = i;
+
+        // Join within slabs of frames in parallel. A slab only ever touches the parents of its own runs, so slabs are
+        // independent. The first frame of each slab is then joined to the frame before it.
+        size_t n_slabs = min(n_frames, 4 * ThreadPool::Shared().Size());
+        ThreadPool::Shared().ParallelFor(n_slabs, [&](size_t slab_begin, size_t slab_end)
+        {
+            for (size_t slab = slab_begin; slab < slab_end; slab++)
+            {
+                for (size_t t = slab * n_frames / n_slabs; t < (slab + 1) * n_frames / n_slabs; t++)
+                {
+                    JoinSpace(t, parent);
+                    if (connect_time && t > slab * n_frames / n_slabs) JoinTime(t, parent);
+                }
+            }
+        });
+        if (connect_time)
+            for (size_t slab = 1; slab < n_slabs; slab++)
+                JoinTime(slab * n_frames / n_slabs, parent);
+
+        // Assign compact labels in order of first appearance and count the cells in each cluster.
+        run_label = vector<int>(runs.size(), -1);
+        vector<int> root_label = vector<int>(runs.size(), -1);
+        for (size_t i = 0; i < runs.size(); i++)
+        {
+            size_t root = Find(parent, i);
+            if (root_label[root] < 0)
+            {
+                root_label[root] = (int) sizes.size();
+                sizes.push_back(0);
+            }
+            run_label[i] = root_label[root];
+            sizes[run_label[i]] += runs[i].y_end - runs[i].y_bgn;
+        }
+    }
+
+    size_t ClusterLabeler::NClusters() const
+    {
+        return sizes.size();
+    }
+
+    int ClusterLabeler::Label(size_t x, size_t y, size_t t) const
+    {
+        if (t + 1 >= frame_bgn.size()) return -1;
+
+        // Find the last run in the frame which starts at or before (x, y).
+        auto first = runs.begin() + frame_bgn[t];
+        auto last = runs.begin() + frame_bgn[t + 1];
+        auto after = upper_bound(first, last, make_pair(x, y), [](const pair<size_t, size_t>& pos, const Run& run)
+        {
+            return pos.first < run.x || (pos.first == run.x && pos.second < run.y_bgn);
+        });
+        if (after == first) return -1;
+        const Run& run = *(after - 1);
+        if (run.x != x || y >= run.y_end) return -1;
+        return run_label[after - 1 - runs.begin()];
+    }
+
+    size_t ClusterLabeler::ClusterSize(size_t label) const
+    {
+        return sizes.at(label);
+    }
+
+    vector<size_t> ClusterLabeler::LargestInFrame() const
+    {
+        vector<size_t> largest = vector<size_t>(frame_bgn.size() - 1, 0);
+        for (size_t t = 0; t < largest.size(); t++)
+            for (size_t i = frame_bgn[t]; i < frame_bgn[t + 1]; i++)
+                largest[t] = max(largest[t], sizes[run_label[i]]);
+        return largest;
+    }
+
+    void ClusterLabeler::Mark(const vector<bool>& keep, Bool3D& matrix) const
+    {
+        for (size_t t = 0; t + 1 < frame_bgn.size(); t++)
+        {
+            for (size_t i = frame_bgn[t]; i < frame_bgn[t + 1]; i++)
+            {
+                if (!keep[run_label[i]]) continue;
+                for (size_t y = runs[i].y_bgn; y < runs[i].y_end; y++)
+                    matrix[runs[i].x][y][t] = true;
+            }
+        }
+    }
+
+    void ClusterLabeler::FindRuns(const BitFrame& frame, vector<Run>& output)
+    {
+        for (size_t x = 0; x < frame.NRows(); x++)
+        {
+            const uint64_t* row = frame.Row(x);
+            size_t y = 0;
+            while (true)
+            {
+                size_t y_bgn = NextBit(row, frame.NWords(), y, true);
+                if (y_bgn >= frame.NCols()) break;
+                size_t y_end = min(NextBit(row, frame.NWords(), y_bgn, false), frame.NCols());
+                output.push_back({(unsigned int) x, (unsigned int) y_bgn, (unsigned int) y_end});
+                y = y_end;
+            }
+        }
+    }
+
+    size_t ClusterLabeler::NextBit(const uint64_t* row, size_t n_words, size_t y, bool value)
+    {
+        size_t word = y / 64;
+        if (word >= n_words) return n_words * 64;
+        uint64_t bits = (value ? row[word] : ~row[word]) & (~uint64_t(0) << (y % 64));
+        while (bits == 0)
+        {
+            if (++word >= n_words) return n_words * 64;
+            bits = value ? row[word] : ~row[word];
+        }
+        return word * 64 + __builtin_ctzll(bits);
+    }
+
+    void ClusterLabeler::JoinSpace(size_t t, vector<size_t>& parent) const
+    {
+        size_t prev_bgn = frame_bgn[t];
+        size_t prev_end = frame_bgn[t];
+        size_t curr = frame_bgn[t];
+        while (curr < frame_bgn[t + 1])
+        {
+            size_t curr_bgn = curr;
+            unsigned int x = runs[curr].x;
+            while (curr < frame_bgn[t + 1] && runs[curr].x == x)
+                curr++;
+
+            // Runs in adjacent rows touch if their y ranges overlap after growing one by a cell on each side.
+            if (prev_end > prev_bgn && runs[prev_bgn].x + 1 == x)
+            {
+                size_t i = prev_bgn;
+                size_t j = curr_bgn;
+                while (i < prev_end && j < curr)
+                {
+                    if (runs[i].y_bgn <= runs[j].y_end && runs[j].y_bgn <= runs[i].y_end)
+                        Union(parent, i, j);
+                    if (runs[i].y_end < runs[j].y_end) i++;
+                    else j++;
+                }
+            }
+            prev_bgn = curr_bgn;
+            prev_end = curr;
+        }
+    }
+
+    void ClusterLabeler::JoinTime(size_t t, vector<size_t>& parent) const
+    {
+        if (t == 0) return;
+        size_t i = frame_bgn[t - 1];
+        size_t j = frame_bgn[t];
+        while (i < frame_bgn[t] && j < frame_bgn[t + 1])
+        {
+            if (runs[i].x < runs[j].x)
+            {
+                i++;
+            }
+            else if (runs[j].x < runs[i].x)
+            {
+                j++;
+            }
+            else
+            {
+                if (runs[i].y_bgn < runs[j].y_end && runs[j].y_bgn < runs[i].y_end)
+                    Union(parent, i, j);
+                if (runs[i].y_end < runs[j].y_end) i++;
+                else j++;
+            }
+        }
+    }
+
+    size_t ClusterLabeler::Find(vector<size_t>& parent, size_t run)
+    {
+        while (parent[run] != run)
+        {
+            parent[run] = parent[parent[run]];
+            run = parent[run];
+        }
+        return run;
+    }
+
+    void ClusterLabeler::Union(vector<size_t>& parent, size_t run_a, size_t run_b)
+    {
+        size_t root_a = Find(parent, run_a);
+        size_t root_b = Find(parent, run_b);
+        if (root_a < root_b) parent[root_b] = root_a;
+        else if (root_b < root_a) parent[root_a] = root_b;
+    }
+}
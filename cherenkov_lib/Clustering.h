@@ -0,0 +1,184 @@
+// Clustering.h
+//
+// Author: Matthew Dutson
+//
+// Defines BitFrame and ClusterLabeler classes
+
+#ifndef CLUSTERING_H
+#define CLUSTERING_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Utility.h"
+
+namespace cherenkov_simulator
+{
+    /*
+     * A 2D boolean mask over the pixel array for a single time bin. Each row (fixed x index) is packed into 64-bit
+     * words, with bit y % 64 of word y / 64 holding the value at (x, y). Bits past the end of a row are always zero.
+     */
+    class BitFrame
+    {
+    public:
+
+        /*
+         * The default constructor. Creates a frame with no rows.
+         */
+        BitFrame();
+
+        /*
+         * Creates a frame of false values with the specified number of rows (x values) and columns (y values).
+         */
+        BitFrame(size_t n_rows, size_t n_cols);
+
+        /*
+         * Returns the number of rows (x values) in the frame.
+         */
+        size_t NRows() const;
+
+        /*
+         * Returns the number of columns (y values) in the frame.
+         */
+        size_t NCols() const;
+
+        /*
+         * Returns the number of 64-bit words used to store each row.
+         */
+        size_t NWords() const;
+
+        /*
+         * Returns the value at the specified position.
+         */
+        bool Get(size_t x, size_t y) const;
+
+        /*
+         * Sets the value at the specified position.
+         */
+        void Set(size_t x, size_t y, bool value = true);
+
+        /*
+         * Returns a pointer to the packed words of the specified row.
+         */
+        const uint64_t* Row(size_t x) const;
+
+        /*
+         * Returns a pointer to the packed words of the specified row.
+         */
+        uint64_t* Row(size_t x);
+
+        /*
+         * Returns true if no values in the frame are true.
+         */
+        bool Empty() const;
+
+        /*
+         * Packs a 3D [x][y][t] vector into one frame per time bin. All sub-vectors must have the same size.
+         */
+        static std::vector<BitFrame> FromMatrix(const Bool3D& matrix);
+
+    private:
+
+        size_t n_rows;
+        size_t n_cols;
+        size_t n_words;
+        std::vector<uint64_t> words;
+    };
+
+    /*
+     * Labels the connected clusters of true cells in a sequence of frames. Cells are connected to their eight spatial
+     * neighbors in the same frame and, optionally, to the same pixel in the adjacent frames. The frames are broken into
+     * runs of consecutive true values along each row, and the runs are joined with a union-find structure, so the work
+     * scales with the number of runs rather than the number of cells. Frames are processed in parallel in slabs of
+     * consecutive time bins on the shared ThreadPool.
+     */
+    class ClusterLabeler
+    {
+    public:
+
+        /*
+         * Labels all clusters in the frames. If connect_time is false, each frame is labeled independently. All frames
+         * must have the same dimensions.
+         */
+        ClusterLabeler(const std::vector<BitFrame>& frames, bool connect_time);
+
+        /*
+         * Returns the number of clusters found. Labels run from zero to NClusters() - 1.
+         */
+        size_t NClusters() const;
+
+        /*
+         * Returns the label of the cluster containing the (x, y, t) cell, or -1 if the cell is false.
+         */
+        int Label(size_t x, size_t y, size_t t) const;
+
+        /*
+         * Returns the number of cells in the cluster with the specified label.
+         */
+        size_t ClusterSize(size_t label) const;
+
+        /*
+         * Returns, for each frame, the size of the largest cluster with at least one cell in that frame. Without time
+         * connections, this is the largest cluster within the frame.
+         */
+        std::vector<size_t> LargestInFrame() const;
+
+        /*
+         * Sets to true every cell of the 3D [x][y][t] vector which belongs to a cluster with a true value in keep.
+         */
+        void Mark(const std::vector<bool>& keep, Bool3D& matrix) const;
+
+    private:
+
+        friend class ClusteringTest;
+
+        /*
+         * A run of true values in row x of some frame, covering y values in [y_bgn, y_end).
+         */
+        struct Run
+        {
+            unsigned int x;
+            unsigned int y_bgn;
+            unsigned int y_end;
+        };
+
+        // Runs are sorted by frame, then by x, then by y. frame_bgn has an extra entry at the end.
+        std::vector<Run> runs;
+        std::vector<size_t> frame_bgn;
+        std::vector<int> run_label;
+        std::vector<size_t> sizes;
+
+        /*
+         * Appends the runs of a single frame to the output vector.
+         */
+        static void FindRuns(const BitFrame& frame, std::vector<Run>& output);
+
+        /*
+         * Returns the position of the first bit at or after y in the packed row which has the specified value. Returns
+         * n_words * 64 if there is no such bit.
+         */
+        static size_t NextBit(const uint64_t* row, size_t n_words, size_t y, bool value);
+
+        /*
+         * Joins the runs of a frame which touch runs in the previous row of the same frame, including diagonally.
+         */
+        void JoinSpace(size_t t, std::vector<size_t>& parent) const;
+
+        /*
+         * Joins the runs of frame t which share a pixel with runs of frame t - 1.
+         */
+        void JoinTime(size_t t, std::vector<size_t>& parent) const;
+
+        /*
+         * Finds the root of the set containing the run, compressing the path along the way.
+         */
+        static size_t Find(std::vector<size_t>& parent, size_t run);
+
+        /*
+         * Merges the sets containing the two runs. The smaller root index becomes the root of the merged set.
+         */
+        static void Union(std::vector<size_t>& parent, size_t run_a, size_t run_b);
+    };
+}
+
+#endif
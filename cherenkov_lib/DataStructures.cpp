@@ -4,13 +4,16 @@
 //
 // Implementation of DataStructures.h
 
-#include <TMath.h>
-#include <TRandom3.h>
+#include <algorithm>
+#include <limits>
+#include <map>
 
 #include "DataStructures.h"
+#include "Numeric.h"
+#include "ThreadPool.h"
 
 using namespace std;
-using namespace TMath;
+using namespace cherenkov_simulator::numeric;
 
 namespace cherenkov_simulator
 {
@@ -66,9 +69,13 @@ namespace cherenkov_simulator
     PhotonCount::PhotonCount()
     {
         n_pixels = 0;
+        ang_size = 0;
+        lin_size = 0;
         min_time = 0;
         max_time = 0;
         empty = true;
+        tally = Tally();
+        FindTables();
     }
 
     PhotonCount::PhotonCount(Params params, double min_time, double max_time)
@@ -84,6 +91,7 @@ namespace cherenkov_simulator
         empty = true;
         frst_time = max_time;
         last_time = min_time;
+        tally = Tally();
 
         if (n_pixels % 2 != 0)
             throw invalid_argument("Number of pixels must be even");
@@ -98,15 +106,12 @@ namespace cherenkov_simulator
 
         counts = Short3D(Size(), Short2D(Size(), Short1D(NBins(), 0)));
         sums = Short2D(Size(), Short1D(Size(), 0));
-        valid = Bool2D(Size(), Bool1D(Size(), false));
-        for (int i = 0; i < Size(); i++)
-            for (int j = 0; j < Size(); j++)
-                valid[i][j] = IsValid(i, j);
+        FindTables();
     }
 
     Bool2D PhotonCount::GetValid() const
     {
-        return valid;
+        return pixel_tables->valid;
     }
 
     size_t PhotonCount::Size() const
@@ -143,9 +148,14 @@ namespace cherenkov_simulator
         return n_pixels / 2.0 * ang_size;
     }
 
-    TVector3 PhotonCount::Direction(const Iterator& iter) const
+    Vec3 PhotonCount::Direction(const Iterator& iter) const
+    {
+        return pixel_tables->directions[iter.X()][iter.Y()];
+    }
+
+    const vector<vector<Vec3>>& PhotonCount::Directions() const
     {
-        return Direction(iter.X(), iter.Y());
+        return pixel_tables->directions;
     }
 
     Short1D PhotonCount::Signal(const Iterator& iter) const
@@ -166,6 +176,29 @@ namespace cherenkov_simulator
         return sum;
     }
 
+    Int2D PhotonCount::PixelSums(const Bool3D* filter) const
+    {
+        Int2D pixel_sums = Int2D(Size(), Int1D(Size(), 0));
+        ThreadPool::Shared().ParallelFor(Size(), [&](size_t begin, size_t end)
+        {
+            for (size_t x = begin; x < end; x++)
+            {
+                for (size_t y = 0; y < Size(); y++)
+                {
+                    if (!pixel_tables->valid[x][y]) continue;
+                    if (filter == nullptr)
+                    {
+                        pixel_sums[x][y] = sums[x][y];
+                        continue;
+                    }
+                    for (size_t t = 0; t < NBins(); t++)
+                        if ((*filter)[x][y][t]) pixel_sums[x][y] += counts[x][y][t];
+                }
+            }
+        });
+        return pixel_sums;
+    }
+
     double PhotonCount::AverageTime(const Iterator& iter) const
     {
         int sum = SumBins(iter);
@@ -192,7 +225,7 @@ namespace cherenkov_simulator
 
     PhotonCount::Iterator PhotonCount::GetIterator() const
     {
-        return Iterator(valid);
+        return Iterator(pixel_tables->valid);
     }
 
     Bool3D PhotonCount::GetFalseMatrix() const
@@ -200,13 +233,13 @@ namespace cherenkov_simulator
         return Bool3D(Size(), Bool2D(Size(), Bool1D(NBins(), false)));
     }
 
-    void PhotonCount::AddPhoton(double time, TVector3 position, int thinning)
+    void PhotonCount::AddPhoton(double time, Vec3 position, int thinning)
     {
-        if (position == TVector3())
+        if (position == Vec3())
             throw invalid_argument("Direction cannot be a zero vector");
         if (time < min_time || time > max_time) return;
 
-        TVector3 direction = -position;
+        Vec3 direction = -position;
         double elevate = ATan2(direction.Y(), direction.Z());
         double azimuth = ATan2(direction.X(), direction.Z());
         auto y_index = (int) (Floor(elevate / ang_size) + n_pixels / 2);
@@ -221,12 +254,107 @@ namespace cherenkov_simulator
         }
     }
 
+    PhotonCount::Tally PhotonCount::GetTally() const
+    {
+        return tally;
+    }
+
+    void PhotonCount::TallyPhoton(bool accepted)
+    {
+        if (accepted) tally.accepted++;
+        else tally.culled++;
+    }
+
+    PhotonCount::Tally PhotonCount::SumTallies(const vector<PhotonCount>& counts)
+    {
+        Tally sum = Tally();
+        for (const PhotonCount& count : counts)
+        {
+            sum.culled += count.tally.culled;
+            sum.accepted += count.tally.accepted;
+        }
+        return sum;
+    }
+
     void PhotonCount::AddNoise(double noise_rate, const Iterator& iter)
     {
         Trim();
         double mean = RealNoiseRate(noise_rate);
         for (size_t i = 0; i < NBins(); i++)
-            IncrementCell(gRandom->Poisson(mean), iter, i);
+            IncrementCell(Random::Shared().Poisson(mean), iter, i);
+    }
+
+    void PhotonCount::AddNoise(const Double2D& noise_rates, const vector<const NoiseBank*>& banks)
+    {
+        Trim();
+
+        // Draw seeds and bank windows, and tabulate the distributions, up front so the parallel section only touches
+        // its own pixels. Each bank is read through a fresh permutation so that pixels get different series.
+        struct BankWindow
+        {
+            const NoiseBank* bank;
+            size_t series;
+            size_t offset;
+        };
+        vector<unsigned int> seeds = vector<unsigned int>(Size());
+        for (size_t x = 0; x < Size(); x++)
+            seeds[x] = Random::Shared().Integer(numeric_limits<unsigned int>::max()) + 1;
+        map<double, Double1D> tables = map<double, Double1D>();
+        map<const NoiseBank*, vector<size_t>> orders = map<const NoiseBank*, vector<size_t>>();
+        map<const NoiseBank*, size_t> n_used = map<const NoiseBank*, size_t>();
+        vector<vector<BankWindow>> windows = vector<vector<BankWindow>>(Size(), vector<BankWindow>(Size()));
+        for (size_t x = 0; x < Size(); x++)
+        {
+            for (size_t y = 0; y < Size(); y++)
+            {
+                windows[x][y].bank = nullptr;
+                if (!pixel_tables->valid[x][y]) continue;
+                double mean = RealNoiseRate(noise_rates[x][y]);
+                for (const NoiseBank* bank : banks)
+                    if (bank->Mean() == mean) windows[x][y].bank = bank;
+
+                const NoiseBank* bank = windows[x][y].bank;
+                if (bank != nullptr)
+                {
+                    if (orders.count(bank) == 0) orders[bank] = bank->Permutation();
+                    windows[x][y].series = orders[bank][n_used[bank]++ % bank->NSeries()];
+                    windows[x][y].offset = Random::Shared().Integer((unsigned int) bank->NBins());
+                }
+                else if (mean >= noise_skip && mean < noise_table && tables.count(mean) == 0)
+                {
+                    tables[mean] = PoissonCDF(mean);
+                }
+            }
+        }
+
+        vector<int> added = vector<int>(Size(), 0);
+        ThreadPool::Shared().ParallelFor(Size(), [&](size_t begin, size_t end)
+        {
+            for (size_t x = begin; x < end; x++)
+            {
+                Random random(seeds[x]);
+                for (size_t y = 0; y < Size(); y++)
+                {
+                    if (!pixel_tables->valid[x][y]) continue;
+                    int n_added;
+                    const BankWindow& window = windows[x][y];
+                    if (window.bank != nullptr)
+                    {
+                        n_added = window.bank->AddWindow(window.series, window.offset, counts[x][y]);
+                    }
+                    else
+                    {
+                        double mean = RealNoiseRate(noise_rates[x][y]);
+                        const Double1D* cdf = tables.count(mean) > 0 ? &tables.at(mean) : nullptr;
+                        n_added = SampleNoise(mean, counts[x][y], random, cdf);
+                    }
+                    sums[x][y] += n_added;
+                    added[x] += n_added;
+                }
+            }
+        });
+        for (int n_added : added)
+            if (n_added > 0) empty = false;
     }
 
     void PhotonCount::Subtract(double noise_rate, const Iterator& iter)
@@ -244,6 +372,84 @@ namespace cherenkov_simulator
         return above;
     }
 
+    vector<PhotonCount::Cell> PhotonCount::CellsAbove(const Int2D& thresholds) const
+    {
+        vector<Cell> cells = vector<Cell>();
+        if (counts.empty() || NBins() == 0) return cells;
+        vector<PyramidLevel> pyramid = BuildPyramid();
+        vector<size_t> n_xy = vector<size_t>(1, Size());
+        vector<size_t> n_t = vector<size_t>(1, NBins());
+        for (const PyramidLevel& level : pyramid)
+        {
+            n_xy.push_back(level.n_xy);
+            n_t.push_back(level.n_t);
+        }
+
+        // The smallest threshold of the valid pixels in each block. Invalid pixels can never pass, so they are given a
+        // threshold which no count can exceed.
+        vector<Int1D> min_thresh = vector<Int1D>(n_xy.size());
+        min_thresh[0] = Int1D(Sq(Size()));
+        const Bool2D& valid = pixel_tables->valid;
+        for (size_t x = 0; x < Size(); x++)
+            for (size_t y = 0; y < Size(); y++)
+                min_thresh[0][x * Size() + y] = valid[x][y] ? thresholds[x][y] : numeric_limits<int>::max();
+        for (size_t k = 1; k < n_xy.size(); k++)
+        {
+            min_thresh[k] = Int1D(Sq(n_xy[k]), numeric_limits<int>::max());
+            for (size_t x = 0; x < n_xy[k - 1]; x++)
+            {
+                for (size_t y = 0; y < n_xy[k - 1]; y++)
+                {
+                    int& block = min_thresh[k][(x / 2) * n_xy[k] + y / 2];
+                    block = Min(block, min_thresh[k - 1][x * n_xy[k - 1] + y]);
+                }
+            }
+        }
+
+        // A block is refined only if its maximum passes the smallest threshold, which can't skip any passing cell.
+        vector<pair<size_t, Cell>> stack = {{pyramid.size(), Cell{0, 0, 0}}};
+        while (!stack.empty())
+        {
+            size_t k = stack.back().first;
+            Cell block = stack.back().second;
+            stack.pop_back();
+            short maximum = k == 0 ? counts[block.x][block.y][block.t]
+                                   : pyramid[k - 1].maxima[(block.x * n_xy[k] + block.y) * n_t[k] + block.t];
+            if (maximum <= min_thresh[k][block.x * n_xy[k] + block.y]) continue;
+            if (k == 0)
+            {
+                cells.push_back(block);
+                continue;
+            }
+            for (size_t x = 2 * block.x; x < Min(2 * block.x + 2, n_xy[k - 1]); x++)
+                for (size_t y = 2 * block.y; y < Min(2 * block.y + 2, n_xy[k - 1]); y++)
+                    for (size_t t = 2 * block.t; t < Min(2 * block.t + 2, n_t[k - 1]); t++)
+                        stack.push_back({k - 1, Cell{x, y, t}});
+        }
+        sort(cells.begin(), cells.end(), [](const Cell& a, const Cell& b)
+        {
+            if (a.t != b.t) return a.t < b.t;
+            return a.x != b.x ? a.x < b.x : a.y < b.y;
+        });
+        return cells;
+    }
+
+    Bool3D PhotonCount::CellMatrix(const vector<Cell>& cells) const
+    {
+        Bool3D matrix = GetFalseMatrix();
+        for (const Cell& cell : cells)
+            matrix[cell.x][cell.y][cell.t] = true;
+        return matrix;
+    }
+
+    vector<BitFrame> PhotonCount::ThresholdFrames(const Int2D& thresholds) const
+    {
+        vector<BitFrame> frames = vector<BitFrame>(NBins(), BitFrame(Size(), Size()));
+        for (const Cell& cell : CellsAbove(thresholds))
+            frames[cell.t].Set(cell.x, cell.y);
+        return frames;
+    }
+
     int PhotonCount::FindThreshold(double noise_rate, double sigma) const
     {
         double max_prob = Erfc(sigma / Sqrt(2)) / 2.0;
@@ -293,6 +499,59 @@ namespace cherenkov_simulator
         sums[x_index][y_index] += inc;
     }
 
+    vector<PhotonCount::PyramidLevel> PhotonCount::BuildPyramid() const
+    {
+        vector<PyramidLevel> pyramid = vector<PyramidLevel>();
+        size_t n_xy = Size();
+        size_t n_t = NBins();
+        while (n_xy > 1 || n_t > 1)
+        {
+            const PyramidLevel* below = pyramid.empty() ? nullptr : &pyramid.back();
+            PyramidLevel level = {(n_xy + 1) / 2, (n_t + 1) / 2, Short1D()};
+            level.maxima = Short1D(Sq(level.n_xy) * level.n_t, numeric_limits<short>::min());
+
+            // Each block of the new level is only written by the thread which owns its x index.
+            ThreadPool::Shared().ParallelFor(level.n_xy, [&](size_t begin, size_t end)
+            {
+                for (size_t x = 2 * begin; x < Min(2 * end, n_xy); x++)
+                {
+                    for (size_t y = 0; y < n_xy; y++)
+                    {
+                        const short* series = below == nullptr ? counts[x][y].data()
+                                                               : &below->maxima[(x * n_xy + y) * n_t];
+                        short* blocks = &level.maxima[((x / 2) * level.n_xy + y / 2) * level.n_t];
+                        for (size_t t = 0; t < n_t; t++)
+                            blocks[t / 2] = Max(blocks[t / 2], series[t]);
+                    }
+                }
+            });
+            n_xy = level.n_xy;
+            n_t = level.n_t;
+            pyramid.push_back(move(level));
+        }
+        return pyramid;
+    }
+
+    void PhotonCount::FindTables()
+    {
+        static KeyedCache<PixelTables> cache;
+        pixel_tables = cache.Get({(double) n_pixels, ang_size, lin_size}, [this]()
+        {
+            PixelTables built = PixelTables();
+            built.valid = Bool2D(Size(), Bool1D(Size(), false));
+            built.directions = vector<vector<Vec3>>(Size(), vector<Vec3>(Size()));
+            for (int i = 0; i < Size(); i++)
+            {
+                for (int j = 0; j < Size(); j++)
+                {
+                    built.valid[i][j] = IsValid(i, j);
+                    built.directions[i][j] = Direction(i, j);
+                }
+            }
+            return built;
+        });
+    }
+
     bool PhotonCount::IsValid(int x_index, int y_index) const
     {
         bool in_range = x_index >= 0 && y_index >= 0 && x_index < n_pixels && y_index < n_pixels;
@@ -301,11 +560,11 @@ namespace cherenkov_simulator
         double arc = n_pixels * lin_size / 2.0;
         double ang = n_pixels * ang_size / 2.0;
         double rad = arc / ang;
-        TVector3 direction = Direction(x_index, y_index) * rad;
+        Vec3 direction = Direction(x_index, y_index) * rad;
         return Utility::WithinXYDisk(direction, rad * Sin(ang));
     }
 
-    TVector3 PhotonCount::Direction(int x_index, int y_index) const
+    Vec3 PhotonCount::Direction(int x_index, int y_index) const
     {
         double pixels_vert = (y_index - n_pixels / 2.0 + 0.5);
         double pixels_horz = (x_index - n_pixels / 2.0 + 0.5);
@@ -313,7 +572,7 @@ namespace cherenkov_simulator
         double azimuth = pixels_horz * ang_size * Cos(elevate);
 
         // A positive azimuth should correspond to a positive x component.
-        return TVector3(Cos(elevate) * Sin(azimuth), Sin(elevate), Cos(elevate) * Cos(azimuth));
+        return Vec3(Cos(elevate) * Sin(azimuth), Sin(elevate), Cos(elevate) * Cos(azimuth));
     }
 
     double PhotonCount::RealNoiseRate(double noise_rate) const
@@ -330,8 +589,146 @@ namespace cherenkov_simulator
         return sum;
     }
 
+    Double1D PhotonCount::PoissonCDF(double mean)
+    {
+        Double1D cdf = Double1D();
+        double term = Exp(-mean);
+        double sum = term;
+        cdf.push_back(sum);
+        for (int x = 1; 1.0 - sum > 1e-12 && x < mean + 50.0 * Sqrt(mean) + 50; x++)
+        {
+            term *= mean / x;
+            sum += term;
+            cdf.push_back(sum);
+        }
+        return cdf;
+    }
+
+    int PhotonCount::SampleNoise(double mean, Short1D& series, Random& random, const Double1D* cdf)
+    {
+        if (mean <= 0.0 || series.empty()) return 0;
+
+        int n_added = 0;
+        if (mean < noise_skip)
+        {
+            // Arrivals form a Poisson process with rate "mean" per bin, so the gaps between them are exponential.
+            double position = random.Exp(1.0 / mean);
+            while (position < series.size())
+            {
+                series[(size_t) position]++;
+                n_added++;
+                position += random.Exp(1.0 / mean);
+            }
+        }
+        else if (cdf != nullptr)
+        {
+            Double1D uniform = Double1D(series.size());
+            random.RndmArray((int) uniform.size(), &(uniform[0]));
+            for (size_t t = 0; t < series.size(); t++)
+            {
+                auto value = (short) (upper_bound(cdf->begin(), cdf->end(), uniform[t]) - cdf->begin());
+                series[t] += value;
+                n_added += value;
+            }
+        }
+        else
+        {
+            for (size_t t = 0; t < series.size(); t++)
+            {
+                auto value = (short) random.Poisson(mean);
+                series[t] += value;
+                n_added += value;
+            }
+        }
+        return n_added;
+    }
+
     double PhotonCount::Poisson(double mean, int x)
     {
         return Exp(-mean) * Power(mean, x) / Factorial(x);
     }
+
+    NoiseBank::NoiseBank()
+    {
+        mean = 0;
+        n_bins = 0;
+    }
+
+    NoiseBank::NoiseBank(double mean, size_t n_series, size_t n_bins)
+    {
+        if (n_series == 0)
+            throw invalid_argument("Noise bank must contain at least one series");
+        if (n_bins == 0)
+            throw invalid_argument("Noise bank series must contain at least one bin");
+        this->mean = mean;
+        this->n_bins = n_bins;
+
+        vector<unsigned int> seeds = vector<unsigned int>(n_series);
+        for (size_t i = 0; i < n_series; i++)
+            seeds[i] = Random::Shared().Integer(numeric_limits<unsigned int>::max()) + 1;
+        Double1D cdf = mean >= noise_skip && mean < noise_table ? PhotonCount::PoissonCDF(mean) : Double1D();
+
+        hits = vector<vector<Hit>>(n_series);
+        ThreadPool::Shared().ParallelFor(n_series, [&](size_t begin, size_t end)
+        {
+            Short1D series = Short1D(n_bins);
+            for (size_t i = begin; i < end; i++)
+            {
+                Random random(seeds[i]);
+                fill(series.begin(), series.end(), 0);
+                PhotonCount::SampleNoise(mean, series, random, cdf.empty() ? nullptr : &cdf);
+                for (size_t t = 0; t < n_bins; t++)
+                    if (series[t] != 0) hits[i].push_back({(unsigned int) t, series[t]});
+            }
+        });
+    }
+
+    double NoiseBank::Mean() const
+    {
+        return mean;
+    }
+
+    size_t NoiseBank::NSeries() const
+    {
+        return hits.size();
+    }
+
+    size_t NoiseBank::NBins() const
+    {
+        return n_bins;
+    }
+
+    vector<size_t> NoiseBank::Permutation() const
+    {
+        vector<size_t> order = vector<size_t>(NSeries());
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        for (size_t i = order.size(); i > 1; i--)
+            swap(order[i - 1], order[Random::Shared().Integer((unsigned int) i)]);
+        return order;
+    }
+
+    int NoiseBank::AddWindow(size_t series, size_t offset, Short1D& target) const
+    {
+        const vector<Hit>& bank_hits = hits.at(series);
+        int n_added = 0;
+
+        // Copy the window in segments which end either at the end of the target or the end of the bank series.
+        size_t n_written = 0;
+        size_t start = offset % n_bins;
+        while (n_written < target.size())
+        {
+            size_t length = min(target.size() - n_written, n_bins - start);
+            auto first = lower_bound(bank_hits.begin(), bank_hits.end(), start,
+                                     [](const Hit& hit, size_t bin) { return hit.bin < bin; });
+            for (auto hit = first; hit != bank_hits.end() && hit->bin < start + length; hit++)
+            {
+                target[n_written + hit->bin - start] += hit->count;
+                n_added += hit->count;
+            }
+            n_written += length;
+            start = 0;
+        }
+        return n_added;
+    }
 }
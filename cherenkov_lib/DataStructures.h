@@ -7,13 +7,18 @@
 #ifndef DATA_STRUCTURES_H
 #define DATA_STRUCTURES_H
 
+#include <memory>
 #include <vector>
-#include <TVector3.h>
 
+#include "Clustering.h"
+#include "Random.h"
 #include "Utility.h"
+#include "Vec3.h"
 
 namespace cherenkov_simulator
 {
+    class NoiseBank;
+
     /*
      * A class containing a 2D collection of vectors. Each vector is a histogram of photon arrival times for a
      * particular photomultiplier. Also contains basic information about the detector which is used to find the
@@ -81,6 +86,26 @@ namespace cherenkov_simulator
             double lin_size;
         };
 
+        /*
+         * The position of a single time bin of a single pixel.
+         */
+        struct Cell
+        {
+            size_t x;
+            size_t y;
+            size_t t;
+        };
+
+        /*
+         * Tallies of the photons traced into a count by Simulator::SimulateOptics(). Culled photons were dropped by the
+         * acceptance cone without being traced, and accepted photons reached the camera.
+         */
+        struct Tally
+        {
+            uint64_t culled;
+            uint64_t accepted;
+        };
+
         /*
          * The default constructor. Objects constructed with this should only be used as placeholders.
          */
@@ -136,7 +161,12 @@ namespace cherenkov_simulator
         /*
          * Determines the direction seen by the pixel at the current location of the iterator.
          */
-        TVector3 Direction(const Iterator& iter) const;
+        Vec3 Direction(const Iterator& iter) const;
+
+        /*
+         * Returns the direction seen by each pixel, indexed by [x][y]. Directions are computed once at construction.
+         */
+        const std::vector<std::vector<Vec3>>& Directions() const;
 
         /*
          * Returns the 1D histogram of photon arrival times at the current location of the iterator.
@@ -154,6 +184,12 @@ namespace cherenkov_simulator
          */
         int SumBinsFiltered(const Iterator& iter, const Bool3D& filter) const;
 
+        /*
+         * Returns the sum of every pixel, indexed by [x][y]. If a filter is passed, only bins with "true" values in the
+         * filter are counted. Invalid pixels have a sum of zero.
+         */
+        Int2D PixelSums(const Bool3D* filter = nullptr) const;
+
         /*
          * Finds the average time in the pixel referenced by the iterator. Throws a domain_error exception if
          * SumBins(iter) == 0 (this results in division by zero).
@@ -183,7 +219,22 @@ namespace cherenkov_simulator
          * invalid_argument exception is thrown if the position vector is zero. Note that the position specified for
          * this method is not the same as the return from Direction(). direction = -position.Unit().
          */
-        void AddPhoton(double time, TVector3 position, int thinning);
+        void AddPhoton(double time, Vec3 position, int thinning);
+
+        /*
+         * Returns the tallies of the photons traced into this count.
+         */
+        Tally GetTally() const;
+
+        /*
+         * Adds a photon to the culled or accepted tally. This doesn't change the histogram.
+         */
+        void TallyPhoton(bool accepted);
+
+        /*
+         * Returns the sums of the tallies of the counts, for detectors with a count per site or unit.
+         */
+        static Tally SumTallies(const std::vector<PhotonCount>& counts);
 
         /*
          * Adds background noise to the time series at the specified position. A random Poisson value is generated for
@@ -192,6 +243,23 @@ namespace cherenkov_simulator
          */
         void AddNoise(double noise_rate, const Iterator& iter);
 
+        /*
+         * Adds background noise to every valid pixel, taking the noise rate (number per second per steradian) of each
+         * pixel from the 2D input. Columns of pixels are processed in parallel on the shared ThreadPool. Each column
+         * has its own random stream seeded from Random::Shared(), so the result for a given seed doesn't depend on the
+         * number of threads. Low rates skip directly between nonzero bins by sampling exponential arrival times,
+         * moderate rates invert a tabulated Poisson CDF, and very high rates fall back to drawing each bin separately.
+         * If one of the banks passed was generated with a pixel's per-bin mean, that pixel's noise is read from the
+         * bank instead.
+         */
+        void AddNoise(const Double2D& noise_rates, const std::vector<const NoiseBank*>& banks = {});
+
+        /*
+         * Determines the average number of noise photons per bin in a single pixel from the noise rate in number per
+         * second per steradian.
+         */
+        double RealNoiseRate(double noise_rate) const;
+
         /*
          * Subtract the average noise rate from the signal in the pixel specified by the iterator. Like AddNoise(), the
          * input rate is the number per second per steradian, which is converted to the appropriate units.
@@ -205,6 +273,25 @@ namespace cherenkov_simulator
          */
         Bool1D AboveThreshold(const Iterator& iter, int threshold) const;
 
+        /*
+         * Returns every cell whose count is greater than its pixel's entry in the 2D threshold vector, sorted by time
+         * bin and then by position. Invalid pixels are never returned. The search starts from the top of a pyramid of
+         * block maxima and only descends into blocks whose maximum is greater than the smallest threshold of their
+         * pixels, so quiet regions of the array are passed over without visiting their cells.
+         */
+        std::vector<Cell> CellsAbove(const Int2D& thresholds) const;
+
+        /*
+         * Returns a 3D vector like GetFalseMatrix(), with true values at the cells passed.
+         */
+        Bool3D CellMatrix(const std::vector<Cell>& cells) const;
+
+        /*
+         * Returns one BitFrame per time bin with "true" for each pixel whose count in that bin is greater than the
+         * pixel's entry in the 2D threshold vector. Invalid pixels are always false.
+         */
+        std::vector<BitFrame> ThresholdFrames(const Int2D& thresholds) const;
+
         /*
          * Determines the appropriate threshold given the noise rate (in number per second per sr per square cm) and the
          * number of standard deviations above the mean where the threshold should be set. This is done by upping the
@@ -226,10 +313,23 @@ namespace cherenkov_simulator
     private:
 
         friend class DataStructuresTest;
+        friend class NoiseBank;
+        friend class EventReader;
+        friend class EventWriter;
+
+        /*
+         * The valid pixels and the direction of each pixel. These only depend on the number and size of the pixels, so
+         * they're built once by FindTables() and shared by every count with the same pixels.
+         */
+        struct PixelTables
+        {
+            Bool2D valid;
+            std::vector<std::vector<Vec3>> directions;
+        };
 
         Short3D counts;
         Short2D sums;
-        Bool2D valid;
+        std::shared_ptr<const PixelTables> pixel_tables;
 
         // The number and size of pixels (cgs, sr)
         size_t n_pixels;
@@ -246,6 +346,25 @@ namespace cherenkov_simulator
         bool empty;
         bool trimd;
 
+        Tally tally;
+
+        /*
+         * A level of the pyramid used by CellsAbove(). Level k has blocks of 2^k by 2^k pixels and 2^k time bins (fewer
+         * at the far edges), and holds the largest count in each block, indexed by (x * n_xy + y) * n_t + t.
+         */
+        struct PyramidLevel
+        {
+            size_t n_xy;
+            size_t n_t;
+            Short1D maxima;
+        };
+
+        /*
+         * Sets pixel_tables to the shared tables for the number and size of the pixels, building them if no count has
+         * used these pixels before.
+         */
+        void FindTables();
+
         /*
          * A wrapper to the other IncrementCell method which takes an Iterator instead of an (x, y) coordinate.
          */
@@ -257,6 +376,12 @@ namespace cherenkov_simulator
          */
         void IncrementCell(int inc, size_t x_index, size_t y_index, size_t t);
 
+        /*
+         * Builds the levels of the block maxima pyramid above the counts themselves, starting with level 1 and ending
+         * with a level which has a single block. Levels are built in parallel on the shared ThreadPool.
+         */
+        std::vector<PyramidLevel> BuildPyramid() const;
+
         /*
          * Determines whether the pixel at the specified indices lies within the central circle.
          */
@@ -265,24 +390,96 @@ namespace cherenkov_simulator
         /*
          * A private method which is functionally equivalent to Direction(const Iterator*).
          */
-        TVector3 Direction(int x_index, int y_index) const;
+        Vec3 Direction(int x_index, int y_index) const;
 
         /*
-         * Determines the average number of noise photons per bin in a single pixel from the noise rate in number per
-         * second per steradian.
+         * Computes the sum of a Poisson distribution with specified mean from the min value (inclusive) to infinity.
          */
-        double RealNoiseRate(double noise_rate) const;
+        static double PoissonSum(double mean, int min);
 
         /*
-         * Computes the sum of a Poisson distribution with specified mean from the min value (inclusive) to infinity.
+         * Tabulates the cumulative Poisson distribution with the specified mean, stopping once the remaining tail is
+         * negligible.
          */
-        static double PoissonSum(double mean, int min);
+        static Double1D PoissonCDF(double mean);
+
+        /*
+         * Adds Poisson noise with the specified mean per bin to the time series, drawing from the random stream passed.
+         * Below noise_skip, arrival times are sampled. Otherwise, if cdf is non-null it must be the table from
+         * PoissonCDF(mean) and is used to sample every bin, and if it is null each bin is drawn separately. Returns the
+         * number of photons added.
+         */
+        static int SampleNoise(double mean, Short1D& series, Random& random, const Double1D* cdf);
 
         /*
          * Calculates a particular value of a Poisson distribution with specified mean.
          */
         static double Poisson(double mean, int x);
     };
+
+    /*
+     * A bank of pre-generated background noise for a single class of pixels (a single per-bin noise mean). Holds a
+     * number of long time series, each stored as a sparse list of nonzero bins. A pixel's noise is built by reading one
+     * of the series from a random offset, wrapping around at the end of the series.
+     */
+    class NoiseBank
+    {
+    public:
+
+        /*
+         * The default constructor. Objects constructed with this should only be used as placeholders.
+         */
+        NoiseBank();
+
+        /*
+         * Generates the specified number of series, each with the specified number of bins, using the per-bin Poisson
+         * mean. Series are generated in parallel on the shared ThreadPool with streams seeded from Random::Shared().
+         * Throws an invalid_argument exception if the number of series or bins is zero.
+         */
+        NoiseBank(double mean, size_t n_series, size_t n_bins);
+
+        /*
+         * Returns the per-bin Poisson mean the bank was generated with.
+         */
+        double Mean() const;
+
+        /*
+         * Returns the number of series in the bank.
+         */
+        size_t NSeries() const;
+
+        /*
+         * Returns the number of bins in each series.
+         */
+        size_t NBins() const;
+
+        /*
+         * Returns a random ordering of the series indices, drawn from Random::Shared().
+         */
+        std::vector<size_t> Permutation() const;
+
+        /*
+         * Adds the window of the specified series starting at the offset bin to the time series. The window has the
+         * same length as the time series and wraps around the end of the bank series. Returns the number of photons
+         * added.
+         */
+        int AddWindow(size_t series, size_t offset, Short1D& target) const;
+
+    private:
+
+        /*
+         * A single nonzero bin of a bank series.
+         */
+        struct Hit
+        {
+            unsigned int bin;
+            short count;
+        };
+
+        std::vector<std::vector<Hit>> hits;
+        double mean;
+        size_t n_bins;
+    };
 }
 
 #endif
@@ -0,0 +1,314 @@
+// EventIO.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of EventIO.h
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "EventIO.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+    EventOrigin::EventOrigin()
+    {
+        attempt = 0;
+        id = 0;
+        weight = 1.0;
+    }
+
+    EventWriter::EventWriter(string filename)
+    {
+        n_written = 0;
+        file.open(filename, ios::binary | ios::trunc);
+        if (!file.is_open())
+            throw runtime_error("Could not open event file " + filename);
+
+        string header = string(event_magic, sizeof(event_magic));
+        for (int i = 0; i < 4; i++)
+            header.push_back((char) (event_version >> (8 * i) & 0xff));
+        file.write(header.data(), header.size());
+        n_bytes = header.size();
+    }
+
+    EventWriter::EventWriter(string filename, uint64_t n_written, uint64_t n_bytes)
+    {
+        struct stat info;
+        bool too_short = n_bytes < sizeof(event_magic) + 4;
+        if (too_short || stat(filename.c_str(), &info) != 0 || (uint64_t) info.st_size < n_bytes)
+            throw runtime_error("Event file " + filename + " is shorter than expected");
+        if (truncate(filename.c_str(), (off_t) n_bytes) != 0)
+            throw runtime_error("Could not truncate event file " + filename);
+
+        this->n_written = n_written;
+        this->n_bytes = n_bytes;
+        file.open(filename, ios::binary | ios::app);
+        if (!file.is_open())
+            throw runtime_error("Could not open event file " + filename);
+    }
+
+    uint64_t EventWriter::Write(const Shower& shower, const PhotonCount& data, const EventOrigin& origin)
+    {
+        uint64_t id = ++n_written;
+        string payload = string();
+        PutVarint(payload, id);
+        PutVarint(payload, origin.attempt);
+        PutVarint(payload, origin.id);
+        PutDouble(payload, origin.weight);
+
+        // The generating shower.
+        PutDouble(payload, shower.EnergyeV());
+        PutDouble(payload, shower.Elevation());
+        for (int i = 0; i < 3; i++)
+            PutDouble(payload, shower.Position()[i]);
+        for (int i = 0; i < 3; i++)
+            PutDouble(payload, shower.Direction()[i]);
+        PutDouble(payload, shower.Time());
+
+        // The PhotonCount parameters and time range.
+        PutVarint(payload, data.n_pixels);
+        PutDouble(payload, data.bin_size);
+        PutDouble(payload, data.ang_size);
+        PutDouble(payload, data.lin_size);
+        PutDouble(payload, data.min_time);
+        PutDouble(payload, data.max_time);
+        PutDouble(payload, data.frst_time);
+        PutDouble(payload, data.last_time);
+        payload.push_back((char) data.trimd);
+        size_t n_bins = data.Size() == 0 ? 0 : data.counts[0][0].size();
+        PutVarint(payload, n_bins);
+
+        // The nonzero bins of each pixel, with pixel and bin indices stored as the difference from the previous one.
+        string hits = string();
+        uint64_t n_hit = 0;
+        uint64_t prev_pixel = 0;
+        for (size_t x = 0; x < data.Size(); x++)
+        {
+            for (size_t y = 0; y < data.Size(); y++)
+            {
+                const Short1D& series = data.counts[x][y];
+                uint64_t n_nonzero = 0;
+                for (short count : series)
+                    if (count != 0) n_nonzero++;
+                if (n_nonzero == 0) continue;
+
+                uint64_t pixel = x * data.Size() + y;
+                PutVarint(hits, pixel - prev_pixel);
+                PutVarint(hits, n_nonzero);
+                prev_pixel = pixel;
+                n_hit++;
+
+                uint64_t prev_bin = 0;
+                for (size_t t = 0; t < series.size(); t++)
+                {
+                    if (series[t] == 0) continue;
+                    PutVarint(hits, t - prev_bin);
+                    PutSigned(hits, series[t]);
+                    prev_bin = t;
+                }
+            }
+        }
+        PutVarint(payload, n_hit);
+        payload += hits;
+
+        string length = string();
+        PutVarint(length, payload.size());
+        file.write(length.data(), length.size());
+        file.write(payload.data(), payload.size());
+        if (!file.good())
+            throw runtime_error("Failed to write to event file");
+        n_bytes += length.size() + payload.size();
+        return id;
+    }
+
+    void EventWriter::Flush()
+    {
+        file.flush();
+        if (!file.good())
+            throw runtime_error("Failed to write to event file");
+    }
+
+    uint64_t EventWriter::NWritten() const
+    {
+        return n_written;
+    }
+
+    uint64_t EventWriter::NBytes() const
+    {
+        return n_bytes;
+    }
+
+    void EventWriter::PutVarint(string& buffer, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            buffer.push_back((char) ((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back((char) value);
+    }
+
+    void EventWriter::PutSigned(string& buffer, int64_t value)
+    {
+        PutVarint(buffer, ((uint64_t) value << 1) ^ (uint64_t) (value >> 63));
+    }
+
+    void EventWriter::PutDouble(string& buffer, double value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        for (int i = 0; i < 8; i++)
+            buffer.push_back((char) (bits >> (8 * i) & 0xff));
+    }
+
+    EventReader::EventReader(string filename)
+    {
+        int descriptor = open(filename.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            throw runtime_error("Could not open event file " + filename);
+        struct stat info;
+        if (fstat(descriptor, &info) != 0 || (size_t) info.st_size < sizeof(event_magic) + 4)
+        {
+            close(descriptor);
+            throw runtime_error(filename + " is not an event file");
+        }
+        length = (size_t) info.st_size;
+        void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        close(descriptor);
+        if (mapping == MAP_FAILED)
+            throw runtime_error("Could not map event file " + filename);
+
+        begin = (const unsigned char*) mapping;
+        end = begin + length;
+        position = begin + sizeof(event_magic) + 4;
+        uint32_t version = 0;
+        for (int i = 0; i < 4; i++)
+            version |= (uint32_t) begin[sizeof(event_magic) + i] << (8 * i);
+        if (memcmp(begin, event_magic, sizeof(event_magic)) != 0)
+        {
+            munmap((void*) begin, length);
+            throw runtime_error(filename + " is not an event file");
+        }
+        if (version != event_version)
+        {
+            munmap((void*) begin, length);
+            throw runtime_error(filename + " has event format version " + to_string(version) + ", expected " +
+                                to_string(event_version));
+        }
+    }
+
+    EventReader::~EventReader()
+    {
+        munmap((void*) begin, length);
+    }
+
+    bool EventReader::Next(uint64_t& id, Shower& shower, PhotonCount& data, EventOrigin& origin)
+    {
+        if (position == end) return false;
+        uint64_t size = GetVarint(position, end);
+        if (size > (uint64_t) (end - position))
+            throw runtime_error("Truncated event record");
+        const unsigned char* cursor = position;
+        const unsigned char* limit = position + size;
+        position = limit;
+
+        id = GetVarint(cursor, limit);
+        origin.attempt = GetVarint(cursor, limit);
+        origin.id = GetVarint(cursor, limit);
+        origin.weight = GetDouble(cursor, limit);
+        double energy = GetDouble(cursor, limit);
+        double elevation = GetDouble(cursor, limit);
+        Vec3 shower_pos = Vec3();
+        for (int i = 0; i < 3; i++)
+            shower_pos[i] = GetDouble(cursor, limit);
+        Vec3 shower_dir = Vec3();
+        for (int i = 0; i < 3; i++)
+            shower_dir[i] = GetDouble(cursor, limit);
+        double time = GetDouble(cursor, limit);
+        shower = Shower(energy, elevation, shower_pos, shower_dir, time);
+
+        // The event already fit in memory when it was simulated, so the memory limit isn't checked again.
+        PhotonCount::Params params = PhotonCount::Params();
+        params.n_pixels = GetVarint(cursor, limit);
+        params.max_byte = numeric_limits<size_t>::max();
+        params.bin_size = GetDouble(cursor, limit);
+        params.ang_size = GetDouble(cursor, limit);
+        params.lin_size = GetDouble(cursor, limit);
+        double min_time = GetDouble(cursor, limit);
+        double max_time = GetDouble(cursor, limit);
+        data = PhotonCount(params, min_time, max_time);
+        data.frst_time = GetDouble(cursor, limit);
+        data.last_time = GetDouble(cursor, limit);
+        if (cursor == limit)
+            throw runtime_error("Truncated event record");
+        data.trimd = *(cursor++) != 0;
+        size_t n_bins = GetVarint(cursor, limit);
+        for (Short2D& column : data.counts)
+            for (Short1D& series : column)
+                series.assign(n_bins, 0);
+
+        uint64_t n_hit = GetVarint(cursor, limit);
+        uint64_t pixel = 0;
+        for (uint64_t i = 0; i < n_hit; i++)
+        {
+            pixel += GetVarint(cursor, limit);
+            uint64_t n_nonzero = GetVarint(cursor, limit);
+            if (pixel >= data.Size() * data.Size())
+                throw runtime_error("Malformed event record");
+            size_t x = pixel / data.Size();
+            size_t y = pixel % data.Size();
+            uint64_t bin = 0;
+            for (uint64_t j = 0; j < n_nonzero; j++)
+            {
+                bin += GetVarint(cursor, limit);
+                int64_t count = GetSigned(cursor, limit);
+                if (bin >= n_bins)
+                    throw runtime_error("Malformed event record");
+                data.IncrementCell((int) count, x, y, bin);
+            }
+        }
+        if (cursor != limit)
+            throw runtime_error("Malformed event record");
+        return true;
+    }
+
+    uint64_t EventReader::GetVarint(const unsigned char*& cursor, const unsigned char* limit)
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (cursor == limit)
+                throw runtime_error("Truncated event record");
+            unsigned char byte = *(cursor++);
+            value |= (uint64_t) (byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        throw runtime_error("Malformed event record");
+    }
+
+    int64_t EventReader::GetSigned(const unsigned char*& cursor, const unsigned char* limit)
+    {
+        uint64_t value = GetVarint(cursor, limit);
+        return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+    }
+
+    double EventReader::GetDouble(const unsigned char*& cursor, const unsigned char* limit)
+    {
+        if (limit - cursor < 8)
+            throw runtime_error("Truncated event record");
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; i++)
+            bits |= (uint64_t) *(cursor++) << (8 * i);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+}
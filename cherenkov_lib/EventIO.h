@@ -0,0 +1,162 @@
+// EventIO.h
+//
+// Author: Matthew Dutson
+//
+// Definition of EventWriter and EventReader classes
+
+#ifndef EVENT_IO_H
+#define EVENT_IO_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "DataStructures.h"
+#include "Geometric.h"
+
+namespace cherenkov_simulator
+{
+    /*
+     * The binary event format stores noise-free simulated events so that they can be reconstructed again without
+     * rerunning the Simulator. A file starts with an 8-byte magic string and a 32-bit format version, followed by one
+     * record per event. Each record is a varint byte length and a payload containing the event ID, the EventOrigin,
+     * the generating Shower, the PhotonCount parameters and time range, and the nonzero bins of each pixel. Pixel
+     * indices, bin indices, and counts are stored as delta-encoded varints, so a typical event takes a few bytes per
+     * nonzero bin.
+     * Doubles are stored as raw little-endian IEEE 754 values. The layout has no pointers or padding, so a file can be
+     * decoded directly from a memory mapping.
+     */
+    const char event_magic[8] = {'C', 'H', 'K', 'V', 'E', 'V', 'T', '\0'};
+    const uint32_t event_version = 2;
+
+    /*
+     * Where an event came from in the run which simulated it: the shower's position in the random stream of the run,
+     * the ID of its row in the run's outputs (zero if it didn't trigger), and its importance sampling weight. The
+     * attempt matches the attempt column of the run's ResultTree, including for showers which didn't trigger.
+     */
+    struct EventOrigin
+    {
+        /*
+         * The default constructor. Creates an origin with no attempt or ID and a weight of one.
+         */
+        EventOrigin();
+
+        uint64_t attempt;
+        uint64_t id;
+        double weight;
+    };
+
+    /*
+     * Appends events to a binary event file.
+     */
+    class EventWriter
+    {
+    public:
+
+        /*
+         * Creates (or overwrites) the file and writes its header. Throws a runtime_error if the file can't be opened.
+         */
+        explicit EventWriter(std::string filename);
+
+        /*
+         * Reopens an existing file for appending, after discarding everything past the first n_bytes. The first
+         * n_written events must lie within those bytes. Throws a runtime_error if the file is shorter than n_bytes or
+         * can't be opened.
+         */
+        EventWriter(std::string filename, uint64_t n_written, uint64_t n_bytes);
+
+        /*
+         * Appends an event and returns its ID. IDs count up from one in the order events are written. The PhotonCount
+         * should be the noise-free output of the Simulator.
+         */
+        uint64_t Write(const Shower& shower, const PhotonCount& data, const EventOrigin& origin = EventOrigin());
+
+        /*
+         * Flushes buffered events to the file.
+         */
+        void Flush();
+
+        /*
+         * Returns the number of events in the file.
+         */
+        uint64_t NWritten() const;
+
+        /*
+         * Returns the length of the file in bytes, including events which haven't been flushed yet.
+         */
+        uint64_t NBytes() const;
+
+    private:
+
+        std::ofstream file;
+        uint64_t n_written;
+        uint64_t n_bytes;
+
+        /*
+         * Appends an unsigned integer as a varint, seven bits per byte with the high bit marking continuation.
+         */
+        static void PutVarint(std::string& buffer, uint64_t value);
+
+        /*
+         * Appends a signed integer as a zigzag-encoded varint.
+         */
+        static void PutSigned(std::string& buffer, int64_t value);
+
+        /*
+         * Appends the raw bytes of a double.
+         */
+        static void PutDouble(std::string& buffer, double value);
+    };
+
+    /*
+     * Reads events sequentially from a memory-mapped binary event file.
+     */
+    class EventReader
+    {
+    public:
+
+        /*
+         * Maps the file and checks its header. Throws a runtime_error if the file can't be read, isn't an event file,
+         * or has a different format version.
+         */
+        explicit EventReader(std::string filename);
+
+        /*
+         * Unmaps the file.
+         */
+        ~EventReader();
+
+        EventReader(const EventReader&) = delete;
+        EventReader& operator=(const EventReader&) = delete;
+
+        /*
+         * Decodes the next event into the arguments. Returns false once there are no more events. Throws a
+         * runtime_error if a record is truncated or malformed.
+         */
+        bool Next(uint64_t& id, Shower& shower, PhotonCount& data, EventOrigin& origin);
+
+    private:
+
+        const unsigned char* begin;
+        const unsigned char* end;
+        const unsigned char* position;
+        size_t length;
+
+        /*
+         * Reads a varint, advancing the cursor. Throws a runtime_error if it runs past the limit.
+         */
+        static uint64_t GetVarint(const unsigned char*& cursor, const unsigned char* limit);
+
+        /*
+         * Reads a zigzag-encoded signed varint.
+         */
+        static int64_t GetSigned(const unsigned char*& cursor, const unsigned char* limit);
+
+        /*
+         * Reads the raw bytes of a double.
+         */
+        static double GetDouble(const unsigned char*& cursor, const unsigned char* limit);
+    };
+}
+
+#endif
@@ -4,18 +4,17 @@
 //
 // Implementation of Geometric.h
 
-#include <TMath.h>
-
 #include "Geometric.h"
+#include "Numeric.h"
 
 using namespace std;
-using namespace TMath;
+using namespace cherenkov_simulator::numeric;
 
 namespace cherenkov_simulator
 {
-    Plane::Plane() : Plane(TVector3(0, 0, 1), TVector3()) {}
+    Plane::Plane() : Plane(Vec3(0, 0, 1), Vec3()) {}
 
-    Plane::Plane(TVector3 normal, TVector3 point)
+    Plane::Plane(Vec3 normal, Vec3 point)
     {
         if (normal.Mag2() == 0) 
             throw invalid_argument("Plane normal vector must be nonzero");
@@ -23,7 +22,7 @@ namespace cherenkov_simulator
         this->coeff = normal.Dot(point);
     }
 
-    TVector3 Plane::Normal() const
+    Vec3 Plane::Normal() const
     {
         return normal;
     }
@@ -33,41 +32,41 @@ namespace cherenkov_simulator
         return coeff;
     }
 
-    bool Plane::InFrontOf(TVector3 direction) const
+    bool Plane::InFrontOf(Vec3 direction) const
     {
-        Ray outward_ray = Ray(TVector3(), direction, 0);
+        Ray outward_ray = Ray(Vec3(), direction, 0);
         return outward_ray.TimeToPlane(*this) > 0;
     }
 
-    Ray::Ray() : Ray(TVector3(), TVector3(0, 0, 1), 0) {}
+    Ray::Ray() : Ray(Vec3(), Vec3(0, 0, 1), 0) {}
 
-    Ray::Ray(TVector3 position, TVector3 direction, double cur_time)
+    Ray::Ray(Vec3 position, Vec3 direction, double cur_time)
     {
         SetDirection(direction);
         this->cur_time = cur_time;
         this->position = position;
     }
 
-    TVector3 Ray::Position() const
+    Vec3 Ray::Position() const
     {
         return position;
     }
 
-    TVector3 Ray::Velocity() const
+    Vec3 Ray::Velocity() const
     {
-        return velocity;
+        return direction * c_cent;
     }
 
-    TVector3 Ray::Direction() const
+    Vec3 Ray::Direction() const
     {
-        return velocity.Unit();
+        return direction;
     }
 
-    void Ray::SetDirection(TVector3 direction)
+    void Ray::SetDirection(Vec3 direction)
     {
         if (direction.Mag2() == 0)
             throw invalid_argument("Ray direction must be nonzero");
-        velocity = direction.Unit() * c_cent;
+        this->direction = direction.Unit();
     }
 
     double Ray::Time() const
@@ -75,9 +74,9 @@ namespace cherenkov_simulator
         return cur_time;
     }
 
-    void Ray::PropagateToPoint(TVector3 destination)
+    void Ray::PropagateToPoint(Vec3 destination)
     {
-        TVector3 displacement = destination - position;
+        Vec3 displacement = destination - position;
         SetDirection(displacement);
         IncrementPosition(displacement.Mag());
     }
@@ -89,30 +88,31 @@ namespace cherenkov_simulator
             IncrementTime(time);
     }
 
-    TVector3 Ray::PlaneImpact(Plane plane) const
+    Vec3 Ray::PlaneImpact(Plane plane) const
     {
         double time = TimeToPlane(move(plane));
         if (time != Infinity())
-            return position + time * velocity;
+            return position + time * Velocity();
         return position;
     }
 
     double Ray::TimeToPlane(Plane plane) const
     {
-        TVector3 normal = plane.Normal();
-        if (normal.Dot(velocity) == 0)
+        Vec3 normal = plane.Normal();
+        double speed = normal.Dot(direction) * c_cent;
+        if (speed == 0)
             return Infinity();
-        return (plane.Coefficient() - normal.Dot(position)) / normal.Dot(velocity);
+        return (plane.Coefficient() - normal.Dot(position)) / speed;
     }
 
-    void Ray::Reflect(TVector3 normal)
+    void Ray::Reflect(Vec3 normal)
     {
         if(normal.Mag2() == 0)
             throw invalid_argument("Reflection normal vector must be nonzero");
-        SetDirection(velocity - 2 * velocity.Dot(normal.Unit()) * normal.Unit());
+        SetDirection(direction - 2 * direction.Dot(normal.Unit()) * normal.Unit());
     }
 
-    bool Ray::Refract(TVector3 normal, double n_in, double n_out)
+    bool Ray::Refract(Vec3 normal, double n_in, double n_out)
     {
         if(normal.Mag2() == 0)
             throw invalid_argument("Refraction normal vector must be nonzero");
@@ -120,19 +120,24 @@ namespace cherenkov_simulator
             throw invalid_argument("Indices of refraction must be at least one");
 
         normal = -normal;
-        double angle_in = velocity.Angle(normal);
+        double angle_in = direction.Angle(normal);
         if (angle_in > PiOver2() || angle_in > ASin(n_out / n_in)) return false;
 
         if (angle_in == 0) return true;
         double angle_out = ASin(n_in * Sin(angle_in) / n_out);
-        velocity.Rotate(angle_out - angle_in, normal.Cross(velocity));
+        direction.Rotate(angle_out - angle_in, normal.Cross(direction));
         return true;
     }
 
-    void Ray::Transform(TRotation rotation)
+    void Ray::Transform(Mat3 rotation)
+    {
+        direction = rotation * direction;
+        position = rotation * position;
+    }
+
+    void Ray::Translate(Vec3 offset)
     {
-        velocity *= rotation;
-        position *= rotation;
+        position += offset;
     }
 
     void Ray::IncrementPosition(double distance)
@@ -143,12 +148,12 @@ namespace cherenkov_simulator
     void Ray::IncrementTime(double time_step)
     {
         cur_time += time_step;
-        position += time_step * velocity;
+        position += time_step * Velocity();
     }
 
     Shower::Shower() : Ray() {}
 
-    Shower::Shower(double energy, double elevation, TVector3 position, TVector3 direction, double time) : Ray(position, direction, time)
+    Shower::Shower(double energy, double elevation, Vec3 position, Vec3 direction, double time) : Ray(position, direction, time)
     {
         this->energy = energy;
         this->elevation = elevation;
@@ -172,6 +177,11 @@ namespace cherenkov_simulator
         return energy;
     }
 
+    double Shower::Elevation() const
+    {
+        return elevation;
+    }
+
     double Shower::ImpactParam() const
     {
         return Position().Cross(Position() + Direction()).Mag();
@@ -222,7 +232,7 @@ namespace cherenkov_simulator
 
     double Shower::X() const
     {
-        return scale_h * rho_sea / Abs(velocity.CosTheta()) * Exp(-(position.Z() + elevation) / scale_h);
+        return scale_h * rho_sea / Abs(direction.CosTheta()) * Exp(-(position.Z() + elevation) / scale_h);
     }
 
     double Shower::XMax() const
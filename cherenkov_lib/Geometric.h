@@ -7,10 +7,8 @@
 #ifndef GEOMETRIC_H
 #define GEOMETRIC_H
 
-#include <TRotation.h>
-#include <TVector3.h>
-
 #include "Utility.h"
+#include "Vec3.h"
 
 namespace cherenkov_simulator
 {
@@ -32,12 +30,12 @@ namespace cherenkov_simulator
          * coefficient "d" by plugging it into the equation ax + by + cz = d. Throws an invalid_argument exception if 
          * the normal vector is zero.
          */
-        Plane(TVector3 normal, TVector3 point);
+        Plane(Vec3 normal, Vec3 point);
 
         /*
          * Returns a copy of the plane's normal vector.
          */
-        TVector3 Normal() const;
+        Vec3 Normal() const;
 
         /*
          * Returns the coefficient "d" of the plane equation.
@@ -48,19 +46,19 @@ namespace cherenkov_simulator
          * Returns true if a Ray going outward from the origin in the specified direction would eventually strike this
          * plane. If the plane is exactly at the origin, false is returned.
          */
-        bool InFrontOf(TVector3 direction) const;
+        bool InFrontOf(Vec3 direction) const;
 
     private:
 
         friend class GeometricTest;
 
-        TVector3 normal;
+        Vec3 normal;
         double coeff;
     };
 
     /*
      * Represents a light Ray with a position, direction, and time. All Rays travel at the speed of light in a vacuum, 
-     * measured in cm/s.
+     * measured in cm/s. The unit direction is stored, so the velocity is found with a single multiplication.
      */
     class Ray
     {
@@ -76,28 +74,28 @@ namespace cherenkov_simulator
          * be unit (this will be taken care of by the constructor. An invalid_argument exception is thrown if the 
          * direction vector is zero.
          */
-        Ray(TVector3 position, TVector3 direction, double cur_time);
+        Ray(Vec3 position, Vec3 direction, double cur_time);
 
         /*
          * Returns the current position of the Ray.
          */
-        TVector3 Position() const;
+        Vec3 Position() const;
 
         /*
          * Returns the current velocity of the Ray.
          */
-        TVector3 Velocity() const;
+        Vec3 Velocity() const;
 
         /*
-         * Returns the unit vector of velocity.
+         * Returns the unit vector of velocity. This is stored, so no normalization is done.
          */
-        TVector3 Direction() const;
+        Vec3 Direction() const;
 
         /*
          * Updates the direction with the one specified, setting the velocity to direction.Unit() * c. An 
          * invalid_argument exception is thrown if the direction vector is zero.
          */
-        void SetDirection(TVector3 direction);
+        void SetDirection(Vec3 direction);
 
         /*
          * Returns the current time of the Ray.
@@ -109,7 +107,7 @@ namespace cherenkov_simulator
          * the current trajectory, the Ray's direction is changed to the displacement between the current position and
          * the destination.
          */
-        void PropagateToPoint(TVector3 destination);
+        void PropagateToPoint(Vec3 destination);
 
         /*
          * Moves the Ray along its current trajectory until it collides with the Plane. If the Ray has already passed
@@ -122,7 +120,7 @@ namespace cherenkov_simulator
          * Finds the point where this Ray will, or would have, collide with the Plane. If the Ray and the Plane are
          * exactly parallel, the current position of the Ray is returned.
          */
-        TVector3 PlaneImpact(Plane plane) const;
+        Vec3 PlaneImpact(Plane plane) const;
 
         /*
          * Finds the amount of time it will take for the Ray to collide with the Plane. Negative times are returned if
@@ -134,7 +132,7 @@ namespace cherenkov_simulator
          * Reflects the Ray across the the normal vector to some surface. The sign of the normal vector doesn't matter.
          * An invalid_argument exception is thrown if the normal vector is zero.
          */
-        void Reflect(TVector3 normal);
+        void Reflect(Vec3 normal);
 
         /*
          * Refracts the Ray across some interface with the normal vector, incident n, and outward n specified. The
@@ -143,19 +141,25 @@ namespace cherenkov_simulator
          * is zero. Returns true if the ray was refracted, and false if the ray was beyond the critical angle. If false
          * is returned, no changes are made to the vector's direction.
          */
-        bool Refract(TVector3 normal, double n_in, double n_out);
+        bool Refract(Vec3 normal, double n_in, double n_out);
 
         /*
          * Applies the rotation to both the Ray's position and velocity.
          */
-        void Transform(TRotation rotation);
+        void Transform(Mat3 rotation);
+
+        /*
+         * Moves the Ray's position by the offset without changing its direction or time. Used to move between frames
+         * with different origins.
+         */
+        void Translate(Vec3 offset);
 
     protected:
 
         friend class GeometricTest;
 
-        TVector3 position;
-        TVector3 velocity;
+        Vec3 position;
+        Vec3 direction;
         double cur_time;
 
         /*
@@ -187,7 +191,7 @@ namespace cherenkov_simulator
          * position, direction, and optional time, which are passed to the parent Ray constructor. An invalid_argument
          * exception is thrown if the energy is not positive.
          */
-        Shower(double energy, double elevation, TVector3 position, TVector3 direction, double time = 0);
+        Shower(double energy, double elevation, Vec3 position, Vec3 direction, double time = 0);
 
         /*
          * Finds the age of the shower, defined as 3 * X / (X + 2 * XMax).
@@ -204,6 +208,11 @@ namespace cherenkov_simulator
          */
         double EnergyeV() const;
 
+        /*
+         * Returns the elevation of the detector above sea level, as passed to the constructor.
+         */
+        double Elevation() const;
+
         /*
          * Calculates the impact parameter of the shower, assuming the detector is at the origin. See
          * http://mathworld.wolfram.com/Point-LineDistance3-Dimensional.html for an explanation of the point-line
@@ -4,12 +4,22 @@
 //
 // Implementation of MonteCarlo.h
 
+#include <chrono>
 #include <fstream>
+#include <memory>
 #include <TFile.h>
+#include <TH2.h>
 #include <TMath.h>
+#include <TROOT.h>
+#include <TVector3.h>
 
 #include "MonteCarlo.h"
 #include "Analysis.h"
+#include "ParameterScan.h"
+#include "Profile.h"
+#include "Random.h"
+#include "ShardMerger.h"
+#include "ThreadPool.h"
 
 using namespace std;
 using namespace boost::property_tree;
@@ -21,36 +31,233 @@ namespace cherenkov_simulator
     {
         elevation = config.get<double>("surroundings.elevation");
         n_showers = config.get<int>("simulation.n_showers");
+        save_event = config.get<bool>("simulation.save_event");
+        diag_level = ParseDiagLevel(config.get<string>("simulation.diag_level"));
+        diag_every = config.get<int>("simulation.diag_every");
+        if (diag_every < 1) throw runtime_error("The diagnostic sampling interval must be positive");
+        writ_queue = config.get<size_t>("simulation.writ_queue");
+        fit_batch = config.get<size_t>("simulation.fit_batch");
+        if (fit_batch < 1) throw runtime_error("The fit batch size must be positive");
+        chkp_every = config.get<uint64_t>("simulation.chkp_every");
+        prefl_thresh = config.get<double>("triggering.prefl_thresh");
 
         energy_pow = config.get<double>("monte_carlo.energy_pow");
         energy_min = config.get<double>("monte_carlo.energy_min");
         energy_max = config.get<double>("monte_carlo.energy_max");
+        energy_prp = config.get<double>("monte_carlo.energy_prp");
         impact_min = config.get<double>("monte_carlo.impact_min");
         impact_max = config.get<double>("monte_carlo.impact_max");
+        impact_prp = config.get<double>("monte_carlo.impact_prp");
         begn_depth = config.get<double>("monte_carlo.begn_depth");
     }
 
-    void MonteCarlo::PerformMonteCarlo(string output_file) const
+    MonteCarlo::DiagLevel MonteCarlo::ParseDiagLevel(string name)
     {
-        TFile file((output_file + ".root").c_str(), "RECREATE");
-        ofstream fout = ofstream(output_file + ".csv");
-        unsigned int start_seed = gRandom->GetSeed();
-        fout << "Seed,ID,Energy," << Shower::Header() << ", " << Reconstructor::Result::Header() << endl;
+        if (name == "none") return none;
+        if (name == "summary") return summary;
+        if (name == "sampled") return sampled;
+        if (name == "full") return full;
+        throw runtime_error("Unknown diagnostic level: " + name);
+    }
+
+    void MonteCarlo::PerformMonteCarlo(string output_file, bool resume, unsigned int shard,
+                                       unsigned int n_shards) const
+    {
+        Detector detector = Detector();
+        detector.ground_plane = simulator.GroundPlane();
+        detector.result_header = Reconstructor::Result::Header();
+        detector.save_events = save_event;
+        detector.bound = [this](const Shower& shower) { return simulator.PeakSignalToNoise(shower); };
+        detector.simulate = [this](const Shower& shower, uint64_t id, EventWriter* events, OutputRecord& record)
+        {
+            EventOrigin origin = EventOrigin();
+            origin.attempt = record.attempt;
+            origin.id = id;
+            origin.weight = record.weight;
+            record.result = RunSingleShower(shower, to_string(id), ShowerDiagLevel(id), events, &record.products,
+                                            origin, &record.tally);
+            return record.result.triggered;
+        };
+        GenerateShowers(detector, output_file, resume, shard, n_shards);
+    }
 
-        Plane ground_plane = simulator.GroundPlane();
-        for (int i = 1; i <= n_showers;)
+    void MonteCarlo::GenerateShowers(const Detector& detector, string output_file, bool resume, unsigned int shard,
+                                     unsigned int n_shards) const
+    {
+        if (shard >= n_shards) throw runtime_error("The shard index must be less than the number of shards");
+        Checkpoint state = Checkpoint();
+        state.seed = Random::Shared().GetSeed();
+        state.shard = shard;
+        state.n_shards = n_shards;
+        state.next_attempt = shard;
+        if (resume) state = Checkpoint::Load(output_file + ".chk");
+        OutputWriter output(output_file, detector.ground_plane, writ_queue, resume ? &state : nullptr,
+                            detector.result_header);
+
+        unique_ptr<EventWriter> events;
+        string event_file = output_file + ".evt";
+        if (detector.save_events && resume)
+            events.reset(new EventWriter(event_file, state.n_events, state.event_bytes));
+        else if (detector.save_events) events.reset(new EventWriter(event_file));
+
+        // With profiling compiled in, every simulated attempt gets a row of counters and stage times.
+        unique_ptr<ofstream> profile_file;
+        Profile run_profile = Profile();
+        uint64_t n_profiled = 0;
+        auto run_start = chrono::steady_clock::now();
+        if (Profile::Enabled())
         {
-            Shower shower = GenerateShower();
-            Reconstructor::Result result = RunSingleShower(shower, to_string(i));
-            if (!result.triggered) continue;
-            cout << "Shower " << i << " finished" << endl;
-            fout << start_seed << "," << i << "," << shower.EnergyeV() << "," << shower.ToString(ground_plane) << ","
-                 << result.ToString(ground_plane) << endl;
-            i++;
+            string profile_name = output_file + "_profile.csv";
+            profile_file.reset(new ofstream(profile_name, resume ? ios::app : ios::trunc));
+            if (!*profile_file) throw runtime_error("Could not open output file " + profile_name);
+            if (!resume) *profile_file << "Attempt,ID," << Profile::Header() << "\n";
+        }
+        auto finish_profile = [&](uint64_t attempt, uint64_t id)
+        {
+            if (!profile_file) return;
+            *profile_file << attempt << "," << id << "," << Profile::Current().ToString() << "\n";
+            run_profile.Add(Profile::Current());
+            n_profiled++;
+        };
+
+        // Each shower gets its own seed, so a resumed run generates the same showers as an uninterrupted one, and
+        // shards with the same seed generate disjoint parts of one stream. Each shard triggers its share of n_showers.
+        uint64_t n_target = n_showers / state.n_shards + (state.shard < n_showers % state.n_shards ? 1 : 0);
+        uint64_t first_id = state.next_id;
+        while (state.next_id <= n_target)
+        {
+            uint64_t attempt = state.next_attempt;
+            state.next_attempt += state.n_shards;
+            Random::Shared().SetSeed(Utility::StreamSeed(state.seed, attempt));
+            double weight;
+            Shower shower = GenerateShower(weight);
+            if (prefl_thresh > 0.0 && detector.bound(shower) < prefl_thresh)
+            {
+                state.n_rejected++;
+                continue;
+            }
+            uint64_t id = state.next_id;
+            OutputRecord record = OutputRecord();
+            record.seed = state.seed;
+            record.id = id;
+            record.attempt = attempt;
+            record.weight = weight;
+            record.shower = shower;
+            Profile::Current() = Profile();
+            bool triggered = detector.simulate(shower, id, events.get(), record);
+            state.n_culled += record.tally.culled;
+            state.n_accepted += record.tally.accepted;
+            if (!triggered)
+            {
+                finish_profile(attempt, 0);
+                continue;
+            }
+            cout << "Shower " << id << " finished" << endl;
+            state.next_id++;
+            record.has_row = true;
+            if (chkp_every > 0 && (id % chkp_every == 0 || id == n_target))
+            {
+                if (events)
+                {
+                    events->Flush();
+                    state.n_events = events->NWritten();
+                    state.event_bytes = events->NBytes();
+                }
+                record.checkpoint = true;
+                record.state = state;
+            }
+            {
+                PROFILE_STAGE(output);
+                output.Submit(id - first_id, move(record));
+            }
+            finish_profile(attempt, id);
+        }
+        output.Close();
+        uint64_t n_attempts = (state.next_attempt - state.shard) / state.n_shards;
+        cout << "Pre-filter rejected " << state.n_rejected << " of " << n_attempts << " showers" << endl;
+        cout << "Acceptance cone culled " << state.n_culled << " photons, and " << state.n_accepted
+             << " reached the camera" << endl;
+
+        if (profile_file)
+        {
+            chrono::duration<double> elapsed = chrono::steady_clock::now() - run_start;
+            uint64_t n_photons = run_profile.counts[Profile::flor_photons] + run_profile.counts[Profile::chkv_photons];
+            cout << "Profiled " << n_profiled << " showers in " << elapsed.count() << " s: "
+                 << n_photons / elapsed.count() << " photons/s, "
+                 << (state.next_id - first_id) * 3600.0 / elapsed.count() << " triggered showers/hour" << endl;
+            cout << Profile::Header() << endl << run_profile.ToString() << endl;
         }
     }
 
-    Reconstructor::Result MonteCarlo::RunSingleShower(Shower shower, string ident) const
+    void MonteCarlo::ReplayEvents(string event_file, string output_file) const
+    {
+        EventReader reader(event_file);
+        OutputWriter output(output_file, simulator.GroundPlane(), writ_queue);
+        unsigned int start_seed = Random::Shared().GetSeed();
+
+        // The noise of each event is added and cleared in file order, so the random stream is the same as when
+        // events are reconstructed one at a time.
+        struct Pending
+        {
+            uint64_t id;
+            EventOrigin origin;
+            Shower shower;
+            DiagLevel level;
+            Snapshot befor_noise;
+            Snapshot after_noise;
+            Snapshot after_clear;
+        };
+        vector<Pending> pending = vector<Pending>();
+        vector<Reconstructor::FitInput> inputs = vector<Reconstructor::FitInput>();
+        uint64_t n_written = 0;
+        auto fit_pending = [&]()
+        {
+            vector<Reconstructor::Result> results = reconstructor.ReconstructBatch(inputs);
+            for (size_t i = 0; i < pending.size(); i++)
+            {
+                if (!results[i].triggered) continue;
+                const Pending& event = pending[i];
+                OutputRecord record = OutputRecord();
+                MakeProducts(event.shower, results[i], to_string(event.id), event.level, event.befor_noise,
+                             event.after_noise, event.after_clear, &record.products);
+                cout << "Shower " << event.id << " finished" << endl;
+                record.has_row = true;
+                record.seed = start_seed;
+                record.id = event.id;
+                record.attempt = event.origin.attempt;
+                record.weight = event.origin.weight;
+                record.shower = event.shower;
+                record.result = results[i];
+                output.Submit(n_written++, move(record));
+            }
+            pending.clear();
+            inputs.clear();
+        };
+
+        uint64_t id;
+        Shower shower;
+        PhotonCount data;
+        EventOrigin origin;
+        while (reader.Next(id, shower, data, origin))
+        {
+            Pending event = Pending();
+            event.id = id;
+            event.origin = origin;
+            event.shower = shower;
+            event.level = ShowerDiagLevel(id);
+            if (!CleanShower(data, event.level, event.befor_noise, event.after_noise)) continue;
+            if (event.level != none) event.after_clear = Analysis::TakeSnapshot(data);
+            inputs.push_back(reconstructor.PrepareFits(data, true));
+            pending.push_back(move(event));
+            if (pending.size() >= fit_batch) fit_pending();
+        }
+        fit_pending();
+        output.Close();
+    }
+
+    Reconstructor::Result MonteCarlo::RunSingleShower(Shower shower, string ident, DiagLevel level,
+                                                      EventWriter* events, vector<Product>* products,
+                                                      EventOrigin origin, PhotonCount::Tally* tally) const
     {
         PhotonCount data;
         try
@@ -63,74 +270,284 @@ namespace cherenkov_simulator
             cout << "Skipping this shower..." << endl;
             return Reconstructor::Result();
         }
+        if (tally != nullptr) *tally = data.GetTally();
         if (data.Empty()) return Reconstructor::Result();
 
-        TH2I befor_noise_pixl = Analysis::MakePixlProfile(data, ident + "_befor_noise_pixl");
-        TGraph befor_noise_time = Analysis::MakeTimeProfile(data);
-        reconstructor.AddNoise(data);
-        TH2I after_noise_pixl = Analysis::MakePixlProfile(data, ident + "_after_noise_pixl");
-        TGraph after_noise_time = Analysis::MakeTimeProfile(data);
-        reconstructor.ClearNoise(data);
-        TH2I after_clear_pixl = Analysis::MakePixlProfile(data, ident + "_after_clear_pixl");
-        TGraph after_clear_time = Analysis::MakeTimeProfile(data);
-
-        Reconstructor::Result result = reconstructor.Reconstruct(data);
-        if (!result.triggered) return Reconstructor::Result();
-
-        befor_noise_pixl.Write();
-        befor_noise_time.Write((ident + "_befor_noise_time").c_str());
-        after_noise_pixl.Write();
-        after_noise_time.Write((ident + "_after_noise_time").c_str());
-        after_clear_pixl.Write();
-        after_clear_time.Write((ident + "_after_clear_time").c_str());
-
-        Plane ground_plane = simulator.GroundPlane();
-        shower.Direction().Write((ident + "_orig_direction").c_str());
-        shower.PlaneImpact(ground_plane).Write((ident + "_orig_gnd_impact").c_str());
-        result.mono_recon.Direction().Write((ident + "_mono_direction").c_str());
-        result.mono_recon.PlaneImpact(ground_plane).Write((ident + "_mono_gnd_impact").c_str());
-        result.chkv_recon.Direction().Write((ident + "_chkv_direction").c_str());
-        result.chkv_recon.PlaneImpact(ground_plane).Write((ident + "_chkv_gnd_impact").c_str());
+        // The event is written once its trigger is known, so that only triggered events keep the ID of their row.
+        Reconstructor::Result result = ProcessShower(shower, data, ident, level, products);
+        if (events != nullptr)
+        {
+            if (!result.triggered) origin.id = 0;
+            events->Write(shower, data, origin);
+        }
         return result;
     }
 
+    Reconstructor::Result MonteCarlo::ProcessShower(Shower shower, PhotonCount data, string ident, DiagLevel level,
+                                                    vector<Product>* products) const
+    {
+        // Only the small snapshots needed by the diagnostic level are kept, and plots are made after triggering.
+        Snapshot befor_noise, after_noise;
+        if (!CleanShower(data, level, befor_noise, after_noise)) return Reconstructor::Result();
+        Reconstructor::Result result = reconstructor.Reconstruct(data, true);
+        if (level == none) return result;
+        MakeProducts(shower, result, ident, level, befor_noise, after_noise, Analysis::TakeSnapshot(data), products);
+        return result;
+    }
+
+    bool MonteCarlo::CleanShower(PhotonCount& data, DiagLevel level, Snapshot& befor_noise, Snapshot& after_noise) const
+    {
+        if (level == full) befor_noise = Analysis::TakeSnapshot(data);
+        reconstructor.AddNoise(data);
+        if (level == full) after_noise = Analysis::TakeSnapshot(data);
+        return reconstructor.ClearNoise(data);
+    }
+
+    void MonteCarlo::MakeProducts(Shower shower, const Reconstructor::Result& result, string ident, DiagLevel level,
+                                  const Snapshot& befor_noise, const Snapshot& after_noise, const Snapshot& after_clear,
+                                  vector<Product>* products) const
+    {
+        if (level == none) return;
+
+        // Full output covers the whole camera and time range. Summary output is cropped to the signal.
+        bool crop = level != full;
+        vector<Product> output;
+        if (level == full)
+        {
+            output.emplace_back(ident + "_befor_noise_pixl",
+                                new TH2I(Analysis::MakePixlProfile(befor_noise, ident + "_befor_noise_pixl",
+                                                                   true, crop)));
+            output.emplace_back(ident + "_befor_noise_time", new TGraph(Analysis::MakeTimeProfile(befor_noise, crop)));
+            output.emplace_back(ident + "_after_noise_pixl",
+                                new TH2I(Analysis::MakePixlProfile(after_noise, ident + "_after_noise_pixl",
+                                                                   true, crop)));
+            output.emplace_back(ident + "_after_noise_time", new TGraph(Analysis::MakeTimeProfile(after_noise, crop)));
+        }
+        output.emplace_back(ident + "_after_clear_pixl",
+                            new TH2I(Analysis::MakePixlProfile(after_clear, ident + "_after_clear_pixl",
+                                                               true, crop)));
+        output.emplace_back(ident + "_after_clear_time", new TGraph(Analysis::MakeTimeProfile(after_clear, crop)));
+        if (level == full)
+        {
+            Plane ground_plane = simulator.GroundPlane();
+            vector<pair<string, Vec3>> vectors = {
+                    {"_orig_direction", shower.Direction()},
+                    {"_orig_gnd_impact", shower.PlaneImpact(ground_plane)},
+                    {"_mono_direction", result.mono_recon.Direction()},
+                    {"_mono_gnd_impact", result.mono_recon.PlaneImpact(ground_plane)},
+                    {"_chkv_direction", result.chkv_recon.Direction()},
+                    {"_chkv_gnd_impact", result.chkv_recon.PlaneImpact(ground_plane)}};
+            for (const pair<string, Vec3>& vec : vectors)
+                output.emplace_back(ident + vec.first, new TVector3(vec.second.X(), vec.second.Y(), vec.second.Z()));
+        }
+
+        if (products != nullptr)
+            for (Product& product : output)
+                products->push_back(move(product));
+        else
+            for (const Product& product : output)
+                product.object->Write(product.name.c_str());
+    }
+
     Shower MonteCarlo::GenerateShower() const
+    {
+        double weight;
+        return GenerateShower(weight);
+    }
+
+    Shower MonteCarlo::GenerateShower(double& weight) const
     {
         double zenith = Utility::RandCosine();
-        double azmuth = gRandom->Uniform(TwoPi());
-        TVector3 axis = TVector3(sin(zenith) * cos(azmuth), sin(zenith) * sin(azmuth), -cos(zenith));
+        double azmuth = Random::Shared().Uniform(TwoPi());
+        Vec3 axis = Vec3(sin(zenith) * cos(azmuth), sin(zenith) * sin(azmuth), -cos(zenith));
+
+        // The linear prior keeps its own generator so that unbiased runs reproduce the showers of earlier versions.
+        double im_par;
+        if (impact_prp == 1.0) im_par = Utility::RandLinear(impact_min, impact_max);
+        else im_par = Utility::RandPower(impact_min, impact_max, impact_prp);
+        double im_ang = Random::Shared().Uniform(TwoPi());
+        double energy = Utility::RandPower(energy_min, energy_max, energy_prp);
 
-        double im_par = Utility::RandLinear(impact_min, impact_max);
-        double im_ang = gRandom->Uniform(TwoPi());
-        double energy = Utility::RandPower(energy_min, energy_max, energy_pow);
+        weight = Utility::PowerDensity(energy, energy_min, energy_max, energy_pow);
+        weight /= Utility::PowerDensity(energy, energy_min, energy_max, energy_prp);
+        weight *= Utility::PowerDensity(im_par, impact_min, impact_max, 1.0);
+        weight /= Utility::PowerDensity(im_par, impact_min, impact_max, impact_prp);
         return GenerateShower(axis, im_par, im_ang, energy);
     }
 
-    Shower MonteCarlo::GenerateShower(TVector3 axis, double im_par, double im_ang, double energy) const
+    Shower MonteCarlo::GenerateShower(Vec3 axis, double im_par, double im_ang, double energy) const
     {
         // Start with an impact point directly in front of the detector, then rotate it by a random angle.
-        TVector3 impact_pos = TVector3(1, 0, 0).Cross(axis).Unit();
+        Vec3 impact_pos = Vec3(1, 0, 0).Cross(axis).Unit();
         impact_pos.Rotate(im_ang, axis);
         impact_pos *= im_par;
 
         double start_h = -scale_h * Log(begn_depth * Abs(axis.CosTheta()) / (rho_sea * scale_h)) - elevation;
         double trace = (start_h - impact_pos.Z()) / (axis.Z());
-        TVector3 start_pos = impact_pos + trace * axis;
+        Vec3 start_pos = impact_pos + trace * axis;
         return Shower(energy, elevation, start_pos, axis);
     }
 
+    void MonteCarlo::PerformStereo(const Stereo& stereo, string output_file, bool resume, unsigned int shard,
+                                   unsigned int n_shards) const
+    {
+        Plane ground_plane = stereo.GroundPlane();
+        Detector detector = Detector();
+        detector.ground_plane = ground_plane;
+        detector.result_header = Stereo::Result::Header(stereo.NSites());
+        detector.save_events = false;
+        detector.bound = [&stereo](const Shower& shower) { return stereo.PeakSignalToNoise(shower); };
+        detector.simulate = [&stereo, ground_plane](const Shower& shower, uint64_t, EventWriter*, OutputRecord& record)
+        {
+            vector<PhotonCount> data = stereo.SimulateShower(shower);
+            record.tally = PhotonCount::SumTallies(data);
+            Stereo::Result result = stereo.Reconstruct(data);
+
+            // The results tree has the columns of a single site, so it holds the first site which triggered.
+            for (const Reconstructor::Result& site : result.sites)
+            {
+                if (!site.triggered) continue;
+                record.result = site;
+                record.result_fields = result.ToString(ground_plane);
+                return true;
+            }
+            return false;
+        };
+        GenerateShowers(detector, output_file, resume, shard, n_shards);
+    }
+
+    void MonteCarlo::PerformStation(const Station& station, string output_file, bool resume, unsigned int shard,
+                                    unsigned int n_shards) const
+    {
+        Detector detector = Detector();
+        detector.ground_plane = station.GroundPlane();
+        detector.result_header = Reconstructor::Result::Header();
+        detector.save_events = false;
+        detector.bound = [&station](const Shower& shower) { return station.PeakSignalToNoise(shower); };
+        detector.simulate = [&station](const Shower& shower, uint64_t, EventWriter*, OutputRecord& record)
+        {
+            vector<PhotonCount> data = station.SimulateShower(shower);
+            record.tally = PhotonCount::SumTallies(data);
+            record.result = station.Reconstruct(data);
+            return record.result.triggered;
+        };
+        GenerateShowers(detector, output_file, resume, shard, n_shards);
+    }
+
+    void MonteCarlo::ShareCaches(const MonteCarlo& other)
+    {
+        reconstructor.ShareNoiseBanks(other.reconstructor);
+    }
+
+    MonteCarlo::DiagLevel MonteCarlo::ShowerDiagLevel(uint64_t id) const
+    {
+        if (diag_level != sampled) return diag_level;
+        return id % diag_every == 0 ? full : none;
+    }
+
     int MonteCarlo::Run(int argc, const char* argv[])
     {
+        vector<string> args = vector<string>(argv + 1, argv + argc);
+        string replay_file;
+        string scan_file;
+        bool resume = false;
+        bool merge = false;
+        bool stereo = false;
+        bool station = false;
+        unsigned int shard = 0;
+        unsigned int n_shards = 1;
+        try
+        {
+            while (!args.empty() && args[0].compare(0, 2, "--") == 0)
+            {
+                size_t n_used = 1;
+                if (args[0] == "--resume")
+                {
+                    resume = true;
+                }
+                else if (args[0] == "--replay" && args.size() > 1)
+                {
+                    replay_file = args[1];
+                    n_used = 2;
+                }
+                else if (args[0] == "--stereo")
+                {
+                    stereo = true;
+                }
+                else if (args[0] == "--station")
+                {
+                    station = true;
+                }
+                else if (args[0] == "--scan" && args.size() > 1)
+                {
+                    scan_file = args[1];
+                    n_used = 2;
+                }
+                else if (args[0] == "--shard" && args.size() > 2)
+                {
+                    shard = (unsigned int) stoul(args[1]);
+                    n_shards = (unsigned int) stoul(args[2]);
+                    if (shard >= n_shards) throw invalid_argument("--shard");
+                    n_used = 3;
+                }
+                else if (args[0] == "--merge" && args.size() > 1)
+                {
+                    merge = true;
+                    n_shards = (unsigned int) stoul(args[1]);
+                    if (n_shards == 0) throw invalid_argument("--merge");
+                    n_used = 2;
+                }
+                else
+                {
+                    throw invalid_argument(args[0]);
+                }
+                args.erase(args.begin(), args.begin() + n_used);
+            }
+            if (!scan_file.empty() && (resume || merge || n_shards > 1 || !replay_file.empty()))
+                throw invalid_argument("--scan");
+            if ((stereo || station) && (merge || !replay_file.empty() || !scan_file.empty()))
+                throw invalid_argument("--stereo");
+            if (stereo && station) throw invalid_argument("--station");
+        }
+        catch (logic_error&)
+        {
+            cout << "Usage: [--resume] [--shard <index> <count>] [output file] [config file] [seed]" << endl;
+            cout << "       --replay <event file> [output file] [config file] [seed]" << endl;
+            cout << "       --merge <count> [output file]" << endl;
+            cout << "       --scan <scan file> [output file] [config file] [seed]" << endl;
+            cout << "       --stereo [--resume] [--shard <index> <count>] [output file] [config file] [seed]" << endl;
+            cout << "       --station [--resume] [--shard <index> <count>] [output file] [config file] [seed]" << endl;
+            return -1;
+        }
+
         string output_file = "Output";
         string config_file = "Config.xml";
-        if (argc > 1) output_file = string(argv[1]);
-        if (argc > 2) config_file = string(argv[2]);
+        if (args.size() > 0) output_file = args[0];
+        if (args.size() > 1) config_file = args[1];
         try
         {
+            if (merge)
+            {
+                ShardMerger::Merge(output_file, n_shards);
+                return 0;
+            }
+            if (n_shards > 1) output_file = ShardMerger::ShardName(output_file, shard);
+
             ptree config = Utility::ParseXMLFile(config_file).get_child("config");
-            if (config.get<bool>("simulation.time_seed")) gRandom->SetSeed();
-            if (argc > 3) gRandom->SetSeed(stoul(argv[3]));
-            MonteCarlo(config).PerformMonteCarlo(output_file);
+            if (config.get<bool>("simulation.time_seed")) Random::Shared().SetSeed();
+            if (args.size() > 2) Random::Shared().SetSeed(stoul(args[2]));
+
+            // Each shard would draw its own time seed, so the shards wouldn't make up a single run.
+            if (n_shards > 1 && !resume && args.size() <= 2 && config.get<bool>("simulation.time_seed"))
+                throw runtime_error("Sharded runs need an explicit seed when simulation.time_seed is enabled");
+            auto n_threads = config.get<size_t>("simulation.n_threads");
+            if (n_threads > 1 || config.get<size_t>("simulation.writ_queue") > 0) ROOT::EnableThreadSafety();
+            ThreadPool::SetShared(n_threads);
+            if (stereo) MonteCarlo(config).PerformStereo(Stereo(config), output_file, resume, shard, n_shards);
+            else if (station) MonteCarlo(config).PerformStation(Station(config), output_file, resume, shard, n_shards);
+            else if (!scan_file.empty()) ParameterScan::Run(config, ParameterScan::Load(scan_file), output_file);
+            else if (replay_file.empty()) MonteCarlo(config).PerformMonteCarlo(output_file, resume, shard, n_shards);
+            else MonteCarlo(config).ReplayEvents(replay_file, output_file);
             return 0;
         }
         catch (runtime_error& err)
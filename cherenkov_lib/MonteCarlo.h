@@ -7,13 +7,17 @@
 #ifndef MONTE_CARLO_H
 #define MONTE_CARLO_H
 
+#include <functional>
 #include <boost/property_tree/ptree.hpp>
-#include <TF1.h>
-#include <TRandom3.h>
 
+#include "Analysis.h"
+#include "EventIO.h"
 #include "Geometric.h"
+#include "OutputWriter.h"
 #include "Reconstructor.h"
 #include "Simulator.h"
+#include "Station.h"
+#include "Stereo.h"
 #include "Utility.h"
 
 namespace cherenkov_simulator
@@ -27,6 +31,23 @@ namespace cherenkov_simulator
     {
     public:
 
+        /*
+         * The amount of diagnostic output written to the ROOT file for each shower. With summary, only the pixel and
+         * time profiles after noise removal are written, cropped to the signal. With full, the profiles cover the whole
+         * camera and time range, and profiles before and after adding noise are also written, along with the true and
+         * reconstructed directions and impact points. Sampled writes full output for one in every diag_every showers
+         * and nothing for the rest. Diagnostics are only built for triggered showers.
+         */
+        enum DiagLevel
+        {
+            none, summary, sampled, full
+        };
+
+        /*
+         * Converts "none", "summary", "sampled", or "full" to a DiagLevel. Throws runtime_error for anything else.
+         */
+        static DiagLevel ParseDiagLevel(std::string name);
+
         /*
          * Constructs the MonteCarlo by copying user-specified parameters from the parsed XML file.
          * TODO: Method should throw exceptions if parameters are out of range
@@ -36,16 +57,72 @@ namespace cherenkov_simulator
         /*
          * Performs the overall Monte Carlo simulation and writes results to a CSV file. A ROOT file is also written
          * which, for each shower, contains plots of the initial shower track, the post noise shower track, and the post
-         * noise removal shower track.
+         * noise removal shower track. The ROOT file also holds a ResultTree with the same rows as the CSV file, at full
+         * precision. Both files are written through an OutputWriter, on a separate thread if writ_queue is nonzero.
+         * Every chkp_every showers, the outputs are saved and a Checkpoint is written to output_file.chk. If resume is
+         * true, the run continues from that checkpoint, appending to the existing outputs. If n_shards is greater than
+         * one, only every n_shards-th position in the shower stream is simulated, starting at shard, until the shard's
+         * share of n_showers have triggered. The shards of a run must all be given the same seed. Showers whose
+         * Simulator::PeakSignalToNoise() is below prefl_thresh are rejected before simulation, and the number of
+         * rejections is printed at the end of the run, along with the number of photons culled by the acceptance cone
+         * and the number which reached the camera. The default threshold of 50 was set by simulating about a
+         * thousand showers drawn over the default ranges with bounds below 5000. The lowest bound of any which
+         * triggered was about 190, and the threshold leaves a factor of four below that. Each row holds the importance
+         * sampling weight of its shower. If profiling is compiled in, the Profile of every simulated shower is written
+         * to output_file_profile.csv, and the run totals, photons per second, and showers per hour are printed at the
+         * end.
+         */
+        void PerformMonteCarlo(std::string output_file, bool resume = false, unsigned int shard = 0,
+                               unsigned int n_shards = 1) const;
+
+        /*
+         * Reconstructs previously simulated events from a binary event file instead of running the Simulator. Noise is
+         * added, cleared, and reconstructed as in PerformMonteCarlo(), and the same CSV and ROOT outputs are written,
+         * with the ID column holding each event's ID in the file. Each row has the attempt and weight stored in the
+         * event's EventOrigin, so weighted histograms of a replay match those of the original run, and rows can be
+         * matched to the original run by attempt. Only the Reconstructor::FitInput and snapshots of each cleaned event
+         * are kept, and the time profiles of every fit_batch events are fit together with
+         * Reconstructor::ReconstructBatch(), which gives the same results as reconstructing them one at a time.
+         */
+        void ReplayEvents(std::string event_file, std::string output_file) const;
+
+        /*
+         * Performs the Monte Carlo with every site of a Stereo, counting a shower as triggered if it triggered at least
+         * one site. Showers are generated, seeded, pre-filtered, checkpointed, and sharded as in PerformMonteCarlo(),
+         * with the pre-filter passing showers which are visible from any site. Each CSV row holds the result of every
+         * site and the stereo reconstruction, and the ResultTree holds the result of the first site which triggered.
+         * No plots or events are written.
+         */
+        void PerformStereo(const Stereo& stereo, std::string output_file, bool resume = false, unsigned int shard = 0,
+                           unsigned int n_shards = 1) const;
+
+        /*
+         * Performs the Monte Carlo with a multi-mirror Station in place of the Simulator and Reconstructor. The outputs
+         * have the same columns as those of PerformMonteCarlo(), and showers are generated, seeded, pre-filtered,
+         * checkpointed, and sharded in the same way. No plots or events are written.
          */
-        void PerformMonteCarlo(std::string output_file) const;
+        void PerformStation(const Station& station, std::string output_file, bool resume = false,
+                            unsigned int shard = 0, unsigned int n_shards = 1) const;
 
         /*
-         * Simulates and attempts reconstruction on a single shower, passed as a parameter. Writes various plots to the
-         * current open file handle, and returns a Reconstructor::Result with reconstructed parameters. It is assumed
-         * that a ROOT file will have been opened before calling this method.
+         * Simulates and attempts reconstruction on a single shower, passed as a parameter. Makes plots for the
+         * specified diagnostic level, and returns a Reconstructor::Result with reconstructed parameters. If products
+         * is null, the plots are written to the current open file handle, which must have been opened before calling
+         * this method. Otherwise, they are appended to products. If an EventWriter is passed, the noise-free simulated
+         * event is appended to it with the specified origin, whose ID is replaced with zero if the shower didn't
+         * trigger. If a tally is passed, it is set to the tallies of the simulated photons.
          */
-        Reconstructor::Result RunSingleShower(Shower shower, std::string ident) const;
+        Reconstructor::Result RunSingleShower(Shower shower, std::string ident, DiagLevel level = full,
+                                              EventWriter* events = nullptr, std::vector<Product>* products = nullptr,
+                                              EventOrigin origin = EventOrigin(),
+                                              PhotonCount::Tally* tally = nullptr) const;
+
+        /*
+         * Adds noise to, clears noise from, and reconstructs noise-free simulated data. Makes the same plots as
+         * RunSingleShower().
+         */
+        Reconstructor::Result ProcessShower(Shower shower, PhotonCount data, std::string ident, DiagLevel level = full,
+                                            std::vector<Product>* products = nullptr) const;
 
         /*
          * Generates a Shower with a random position, direction, and energy. Allowed ranges of these parameters are
@@ -53,15 +130,39 @@ namespace cherenkov_simulator
          */
         Shower GenerateShower() const;
 
+        /*
+         * Generates a Shower as above, but draws the energy and impact parameter from the proposal power laws given by
+         * energy_prp and impact_prp rather than from the energy_pow and linear priors. The importance sampling weight
+         * (the ratio of the prior density to the proposal density) is stored in weight. Weighted sums over the
+         * generated showers estimate the same quantities as unweighted sums over showers drawn from the priors. If the
+         * proposals match the priors, the showers are the same as without importance sampling and the weight is one.
+         */
+        Shower GenerateShower(double& weight) const;
+
         /*
          * Constructs a Shower given an axis direction, impact parameter, impact angle (angle of the point of closest
          * approach), and energy.
          */
-        Shower GenerateShower(TVector3 axis, double im_par, double im_ang, double energy) const;
+        Shower GenerateShower(Vec3 axis, double im_par, double im_ang, double energy) const;
+
+        /*
+         * Makes this MonteCarlo reuse the noise banks of another wherever their noise means and sizes match. This has
+         * no effect unless simulation.noise_bank is enabled. The tables which don't depend on random numbers are
+         * always shared between MonteCarlos with matching parameters, without calling this.
+         */
+        void ShareCaches(const MonteCarlo& other);
 
         /*
          * Parses the output file and configuration file from command line arguments, instantiates the MonteCarlo
-         * object, and runs the PerformMonteCarlo method.
+         * object, and runs the PerformMonteCarlo method. If the first arguments are "--replay <event file>", events
+         * are read from the file and passed to ReplayEvents() instead. If the first argument is "--resume", the run
+         * is continued from its last checkpoint, and any seed argument is ignored. "--shard <index> <count>" runs a
+         * single shard, with outputs named by ShardMerger::ShardName(), and "--merge <count> [output file]" merges
+         * the outputs of all shards. If simulation.time_seed is enabled, every shard must be given the same explicit
+         * seed. "--scan <scan file>" runs every point of a ParameterScan in this process. "--stereo" runs
+         * PerformStereo() with the sites in the configuration, and "--station" runs PerformStation() with the mirror
+         * units in the configuration. Both can be combined with "--resume" and "--shard", and their shards are merged
+         * in the same way.
          */
         static int Run(int argc, const char* argv[]);
 
@@ -71,16 +172,69 @@ namespace cherenkov_simulator
 
         int n_showers;
         double elevation;
+        bool save_event;
+        DiagLevel diag_level;
+        int diag_every;
+        size_t writ_queue;
+        size_t fit_batch;
+        uint64_t chkp_every;
+        double prefl_thresh;
 
         double energy_pow;
         double energy_min;
         double energy_max;
+        double energy_prp;
         double impact_min;
         double impact_max;
+        double impact_prp;
         double begn_depth;
 
         Simulator simulator;
         Reconstructor reconstructor;
+
+        /*
+         * The parts of a Monte Carlo run which depend on the detector. bound returns the pre-filter's bound on the
+         * peak signal-to-noise ratio of a shower. simulate simulates and reconstructs the shower with the specified ID,
+         * writing its event if events isn't null, fills in the result, result fields, products, and photon tally of the
+         * record, and returns whether the shower triggered. The seed, ID, attempt, weight, and shower of the record are
+         * filled in before simulate is called. The result columns of the CSV rows are given by result_header.
+         */
+        struct Detector
+        {
+            Plane ground_plane;
+            std::string result_header;
+            bool save_events;
+            std::function<double(const Shower&)> bound;
+            std::function<bool(const Shower&, uint64_t, EventWriter*, OutputRecord&)> simulate;
+        };
+
+        /*
+         * Runs the generation loop of PerformMonteCarlo() with the specified detector. Each attempt is seeded from its
+         * position in the shower stream, pre-filtered, and simulated, and triggered showers are written with their
+         * weights through an OutputWriter, with checkpoints every chkp_every showers.
+         */
+        void GenerateShowers(const Detector& detector, std::string output_file, bool resume, unsigned int shard,
+                             unsigned int n_shards) const;
+
+        /*
+         * Returns the diagnostic level for the shower with the specified ID, resolving the sampled level to either
+         * full or none.
+         */
+        DiagLevel ShowerDiagLevel(uint64_t id) const;
+
+        /*
+         * Adds noise to and clears noise from the data, taking the snapshots needed by the diagnostic level. Returns
+         * false if no frame was triggered.
+         */
+        bool CleanShower(PhotonCount& data, DiagLevel level, Snapshot& befor_noise, Snapshot& after_noise) const;
+
+        /*
+         * Makes the plots of a triggered shower for the diagnostic level, as described for RunSingleShower(), from
+         * snapshots taken before adding noise, after adding noise, and after clearing noise.
+         */
+        void MakeProducts(Shower shower, const Reconstructor::Result& result, std::string ident, DiagLevel level,
+                          const Snapshot& befor_noise, const Snapshot& after_noise, const Snapshot& after_clear,
+                          std::vector<Product>* products) const;
     };
 }
 
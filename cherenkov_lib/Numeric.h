@@ -0,0 +1,94 @@
+// Numeric.h
+//
+// Author: Matthew Dutson
+//
+// Definition of the mathematical functions used by the ROOT-free core
+
+#ifndef NUMERIC_H
+#define NUMERIC_H
+
+#include <cmath>
+#include <limits>
+
+namespace cherenkov_simulator
+{
+    /*
+     * Inline replacements for the TMath functions used by the simulation and reconstruction, with the same names and
+     * the same behavior, so that the core library doesn't depend on ROOT. Source files in the core use this namespace
+     * where they previously used TMath.
+     */
+    namespace numeric
+    {
+        constexpr double Pi() { return 3.14159265358979323846; }
+
+        constexpr double TwoPi() { return 2.0 * Pi(); }
+
+        constexpr double PiOver2() { return Pi() / 2.0; }
+
+        inline double Infinity() { return std::numeric_limits<double>::infinity(); }
+
+        constexpr double Sq(double x) { return x * x; }
+
+        inline double Sqrt(double x) { return std::sqrt(x); }
+
+        inline double Sin(double x) { return std::sin(x); }
+
+        inline double Cos(double x) { return std::cos(x); }
+
+        inline double Tan(double x) { return std::tan(x); }
+
+        /*
+         * Like TMath::ASin() and TMath::ACos(), arguments outside [-1, 1] are clamped rather than giving NaN.
+         */
+        inline double ASin(double x)
+        {
+            if (x < -1.0) return -PiOver2();
+            if (x > 1.0) return PiOver2();
+            return std::asin(x);
+        }
+
+        inline double ACos(double x)
+        {
+            if (x < -1.0) return Pi();
+            if (x > 1.0) return 0.0;
+            return std::acos(x);
+        }
+
+        inline double ATan2(double y, double x) { return std::atan2(y, x); }
+
+        inline double Exp(double x) { return std::exp(x); }
+
+        inline double Log(double x) { return std::log(x); }
+
+        inline double Log10(double x) { return std::log10(x); }
+
+        inline double Power(double x, double y) { return std::pow(x, y); }
+
+        inline double Floor(double x) { return std::floor(x); }
+
+        inline double Erfc(double x) { return std::erfc(x); }
+
+        inline double LnGamma(double x) { return std::lgamma(x); }
+
+        /*
+         * Returns n!, or one for n less than one.
+         */
+        inline double Factorial(int n)
+        {
+            double result = 1.0;
+            for (int i = 2; i <= n; i++) result *= i;
+            return result;
+        }
+
+        template <typename T>
+        constexpr T Abs(T x) { return x < 0 ? -x : x; }
+
+        template <typename T>
+        constexpr T Min(T a, T b) { return a <= b ? a : b; }
+
+        template <typename T>
+        constexpr T Max(T a, T b) { return a >= b ? a : b; }
+    }
+}
+
+#endif
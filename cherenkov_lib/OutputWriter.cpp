@@ -0,0 +1,205 @@
+// OutputWriter.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of OutputWriter.h
+
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+#include <TH1.h>
+
+#include "OutputWriter.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+    Product::Product(string name, TObject* object) : name(name), object(object)
+    {
+        // Histograms are normally attached to the current directory, which may belong to another thread.
+        TH1* histo = dynamic_cast<TH1*>(object);
+        if (histo != nullptr) histo->SetDirectory(nullptr);
+    }
+
+    OutputRecord::OutputRecord()
+    {
+        has_row = false;
+        seed = 0;
+        id = 0;
+        attempt = 0;
+        weight = 1.0;
+        checkpoint = false;
+        tally = PhotonCount::Tally();
+    }
+
+    OutputWriter::OutputWriter(string output_file, Plane ground_plane, size_t capacity, const Checkpoint* resume,
+                               string result_header) :
+        output_file(output_file), ground_plane(ground_plane), result_header(result_header), capacity(capacity)
+    {
+        next = 0;
+        closing = false;
+        if (resume != nullptr) progress = *resume;
+        if (capacity == 0) Open(resume != nullptr);
+        else writer = thread(&OutputWriter::Work, this, resume != nullptr);
+    }
+
+    OutputWriter::~OutputWriter()
+    {
+        try
+        {
+            Close();
+        }
+        catch (...) {}
+    }
+
+    void OutputWriter::Submit(uint64_t number, OutputRecord record)
+    {
+        unique_lock<std::mutex> lock(mutex);
+        if (capacity == 0)
+        {
+            pending.emplace(number, move(record));
+            for (auto iter = pending.find(next); iter != pending.end(); iter = pending.find(++next))
+            {
+                OutputRecord ready = move(iter->second);
+                pending.erase(iter);
+                Write(ready);
+            }
+            return;
+        }
+
+        // Only accept records within capacity of the next one to write, so the writer can never fall further behind.
+        space_ready.wait(lock, [this, number]() { return error || number < next + capacity; });
+        if (error) rethrow_exception(error);
+        pending.emplace(number, move(record));
+        if (number == next) record_ready.notify_one();
+    }
+
+    void OutputWriter::Close()
+    {
+        if (writer.joinable())
+        {
+            {
+                lock_guard<std::mutex> lock(mutex);
+                closing = true;
+            }
+            record_ready.notify_one();
+            writer.join();
+        }
+        else if (files)
+        {
+            Finish();
+        }
+
+        if (error)
+        {
+            exception_ptr curr_error = error;
+            error = nullptr;
+            rethrow_exception(curr_error);
+        }
+    }
+
+    OutputWriter::Files::Files(string output_file, Plane ground_plane, const Checkpoint* resume) :
+        root((output_file + ".root").c_str(), resume == nullptr ? "RECREATE" : "UPDATE")
+    {
+        if (root.IsZombie()) throw runtime_error("Could not open output file " + output_file + ".root");
+        string csv_name = output_file + ".csv";
+        if (resume == nullptr)
+        {
+            csv.open(csv_name);
+            results.reset(new ResultTree(ground_plane));
+        }
+        else
+        {
+            if (truncate(csv_name.c_str(), (off_t) resume->csv_bytes) != 0)
+                throw runtime_error("Could not truncate output file " + csv_name);
+            csv.open(csv_name, ios::app);
+            results.reset(new ResultTree(ground_plane, resume->n_rows));
+        }
+        if (!csv) throw runtime_error("Could not open output file " + csv_name);
+    }
+
+    void OutputWriter::Open(bool resume)
+    {
+        files.reset(new Files(output_file, ground_plane, resume ? &progress : nullptr));
+        if (resume) return;
+        ostringstream header;
+        header << "Seed,ID,Energy," << Shower::Header() << ", " << result_header << ",Weight\n";
+        files->csv << header.str();
+        progress.csv_bytes = header.str().size();
+    }
+
+    void OutputWriter::Work(bool resume)
+    {
+        try
+        {
+            Open(resume);
+            unique_lock<std::mutex> lock(mutex);
+            while (true)
+            {
+                record_ready.wait(lock, [this]() { return closing || pending.count(next) > 0; });
+                auto iter = pending.find(next);
+                if (iter == pending.end()) break;
+                OutputRecord record = move(iter->second);
+                pending.erase(iter);
+
+                lock.unlock();
+                Write(record);
+                lock.lock();
+                next++;
+                space_ready.notify_all();
+            }
+            pending.clear();
+            lock.unlock();
+            Finish();
+        }
+        catch (...)
+        {
+            files.reset();
+            lock_guard<std::mutex> lock(mutex);
+            error = current_exception();
+            space_ready.notify_all();
+        }
+    }
+
+    void OutputWriter::Write(OutputRecord& record)
+    {
+        files->root.cd();
+        if (record.has_row)
+        {
+            string result_fields = record.result_fields;
+            if (result_fields.empty()) result_fields = record.result.ToString(ground_plane);
+            ostringstream row;
+            row << record.seed << "," << record.id << "," << record.shower.EnergyeV() << ","
+                << record.shower.ToString(ground_plane) << "," << result_fields << "," << record.weight << "\n";
+            files->csv << row.str();
+            files->results->Fill(record.seed, record.id, record.attempt, record.weight, record.shower, record.result);
+            progress.csv_bytes += row.str().size();
+            progress.n_rows++;
+            if (record.result.chkv_tried) progress.n_chkv++;
+        }
+
+        // Overwriting means products repeated after resuming from a checkpoint replace the ones from before.
+        for (Product& product : record.products)
+            product.object->Write(product.name.c_str(), TObject::kOverwrite);
+
+        if (record.checkpoint)
+        {
+            files->csv.flush();
+            if (!files->csv) throw runtime_error("Failed to write to output file " + output_file + ".csv");
+            files->results->Save();
+            Checkpoint state = record.state;
+            state.n_rows = progress.n_rows;
+            state.n_chkv = progress.n_chkv;
+            state.csv_bytes = progress.csv_bytes;
+            state.Save(output_file + ".chk");
+        }
+    }
+
+    void OutputWriter::Finish()
+    {
+        files->root.cd();
+        files->results->Write();
+        files.reset();
+    }
+}
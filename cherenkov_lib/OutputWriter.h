@@ -0,0 +1,166 @@
+// OutputWriter.h
+//
+// Author: Matthew Dutson
+//
+// Definition of Product, OutputRecord, and OutputWriter
+
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <TFile.h>
+#include <TObject.h>
+
+#include "Checkpoint.h"
+#include "Geometric.h"
+#include "Reconstructor.h"
+#include "ResultTree.h"
+
+namespace cherenkov_simulator
+{
+    /*
+     * A ROOT object which is written to the output file under the specified name.
+     */
+    struct Product
+    {
+        /*
+         * Takes ownership of the object. Histograms are detached from the current ROOT directory.
+         */
+        Product(std::string name, TObject* object);
+
+        std::string name;
+        std::unique_ptr<TObject> object;
+    };
+
+    /*
+     * Everything written to the output files for a single shower. If has_row is false, only the products are written.
+     * If checkpoint is true, the files are saved once the record is written, and state is saved as the run's
+     * checkpoint, after the writer fills in its statistics and the lengths of the CSV file. If result_fields is not
+     * empty, it is written to the CSV row in place of result.ToString(), for runs whose rows have other columns. The
+     * tally of the simulated photons isn't written, and is added to the run's totals whether or not there is a row.
+     */
+    struct OutputRecord
+    {
+        /*
+         * The default constructor. Creates a record with no row, no products, and no checkpoint.
+         */
+        OutputRecord();
+
+        bool has_row;
+        unsigned int seed;
+        uint64_t id;
+        uint64_t attempt;
+        double weight;
+        Shower shower;
+        Reconstructor::Result result;
+        std::string result_fields;
+        std::vector<Product> products;
+        bool checkpoint;
+        Checkpoint state;
+        PhotonCount::Tally tally;
+    };
+
+    /*
+     * Writes the CSV file, the ROOT file, and the ResultTree inside the ROOT file. Records are numbered by the caller
+     * and are always written in order of their number, regardless of the order they are submitted in. With a nonzero
+     * capacity, records are written by a dedicated thread, which owns both files, and Submit() only blocks when the
+     * writer is capacity records behind. With a capacity of zero, records are written on the calling thread.
+     */
+    class OutputWriter
+    {
+    public:
+
+        /*
+         * Opens output_file.csv and output_file.root and writes the CSV header. In the asynchronous mode, the files are
+         * opened on the writer thread, and any error is reported by the next call to Submit() or Close(). If a
+         * checkpoint is passed, the existing files are cut back to the state at the checkpoint and appended to. The
+         * result columns of the CSV header are given by result_header, which must match the rows' result fields.
+         */
+        OutputWriter(std::string output_file, Plane ground_plane, size_t capacity, const Checkpoint* resume = nullptr,
+                     std::string result_header = Reconstructor::Result::Header());
+
+        /*
+         * Calls Close(), ignoring any error.
+         */
+        ~OutputWriter();
+
+        OutputWriter(const OutputWriter&) = delete;
+
+        OutputWriter& operator=(const OutputWriter&) = delete;
+
+        /*
+         * Queues a record to be written. Records must be numbered consecutively from zero, and each number must be
+         * submitted exactly once. Rethrows any error which occurred while writing.
+         */
+        void Submit(uint64_t number, OutputRecord record);
+
+        /*
+         * Waits for all submitted records to be written, writes the ResultTree, and closes the files. Records which
+         * are still waiting for an earlier number are discarded. Rethrows any error which occurred while writing.
+         */
+        void Close();
+
+    private:
+
+        /*
+         * The open output files. Only ever used by one thread at a time. The ResultTree is declared after the ROOT
+         * file so that it is destroyed first.
+         */
+        struct Files
+        {
+            Files(std::string output_file, Plane ground_plane, const Checkpoint* resume);
+
+            TFile root;
+            std::ofstream csv;
+            std::unique_ptr<ResultTree> results;
+        };
+
+        std::string output_file;
+        Plane ground_plane;
+        std::string result_header;
+        size_t capacity;
+        std::unique_ptr<Files> files;
+
+        // The statistics and CSV length after the records written so far. Only used by the writing thread.
+        Checkpoint progress;
+
+        // Records waiting to be written, keyed by number. next is the number of the next record to write.
+        std::map<uint64_t, OutputRecord> pending;
+        uint64_t next;
+        bool closing;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable record_ready;
+        std::condition_variable space_ready;
+        std::thread writer;
+
+        /*
+         * The loop run by the writer thread. Opens the files, writes records in order until the writer is closed, and
+         * then finishes the files.
+         */
+        void Work(bool resume);
+
+        /*
+         * Writes the CSV row, ResultTree row, and products of a record, and saves the checkpoint if it has one.
+         */
+        void Write(OutputRecord& record);
+
+        /*
+         * Opens the files. If resume is true, the files are cut back to the state in progress.
+         */
+        void Open(bool resume);
+
+        /*
+         * Writes the ResultTree and closes the files.
+         */
+        void Finish();
+    };
+}
+
+#endif
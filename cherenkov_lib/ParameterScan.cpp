@@ -0,0 +1,171 @@
+// ParameterScan.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of ParameterScan.h
+
+#include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <boost/algorithm/string/trim.hpp>
+
+#include "MonteCarlo.h"
+#include "ParameterScan.h"
+#include "Random.h"
+#include "ThreadPool.h"
+
+using namespace std;
+using namespace boost::property_tree;
+
+namespace cherenkov_simulator
+{
+    vector<ParameterScan::Point> ParameterScan::Load(string scan_file)
+    {
+        ptree scan;
+        try
+        {
+            scan = Utility::ParseXMLFile(scan_file).get_child("scan");
+        }
+        catch (ptree_error& err)
+        {
+            throw runtime_error("The scan file " + scan_file + " has no scan element: " + err.what());
+        }
+
+        vector<Point> points = vector<Point>();
+        for (const ptree::value_type& element : scan)
+        {
+            if (element.first == "point")
+            {
+                Point point = Point();
+                point.tag = element.second.get<string>("<xmlattr>.tag", "");
+                for (const ptree::value_type& set : element.second)
+                {
+                    if (set.first != "set") continue;
+                    string value = boost::algorithm::trim_copy(set.second.data());
+                    point.overrides.emplace_back(set.second.get<string>("<xmlattr>.key"), value);
+                }
+                points.push_back(point);
+            }
+            else if (element.first == "grid")
+            {
+                vector<pair<string, vector<string>>> axes = vector<pair<string, vector<string>>>();
+                for (const ptree::value_type& axis : element.second)
+                {
+                    if (axis.first != "axis") continue;
+                    string key = axis.second.get<string>("<xmlattr>.key");
+                    vector<string> values = vector<string>();
+                    istringstream stream = istringstream(axis.second.data());
+                    string value;
+                    while (stream >> value)
+                        values.push_back(value);
+                    if (values.empty()) throw runtime_error("The scan axis " + key + " has no values");
+                    axes.emplace_back(key, values);
+                }
+                if (axes.empty()) continue;
+
+                // Step through the grid like an odometer, with the last axis changing fastest.
+                vector<size_t> index = vector<size_t>(axes.size(), 0);
+                size_t carry = axes.size();
+                while (carry > 0)
+                {
+                    Point point = Point();
+                    for (size_t i = 0; i < axes.size(); i++)
+                        point.overrides.emplace_back(axes[i].first, axes[i].second[index[i]]);
+                    points.push_back(point);
+                    for (carry = axes.size(); carry > 0; carry--)
+                    {
+                        if (++index[carry - 1] < axes[carry - 1].second.size()) break;
+                        index[carry - 1] = 0;
+                    }
+                }
+            }
+        }
+        if (points.empty()) throw runtime_error("The scan file " + scan_file + " has no points");
+
+        set<string> tags = set<string>();
+        for (Point& point : points)
+        {
+            if (point.tag.empty())
+            {
+                for (const pair<string, string>& change : point.overrides)
+                    point.tag += (point.tag.empty() ? "" : "_") + ShortName(change.first) + "_" + change.second;
+                if (point.tag.empty()) point.tag = "base";
+            }
+            if (!tags.insert(point.tag).second) throw runtime_error("Repeated scan point " + point.tag);
+        }
+        return points;
+    }
+
+    ptree ParameterScan::Apply(const ptree& config, const Point& point)
+    {
+        ptree output = config;
+        for (const pair<string, string>& change : point.overrides)
+            output.put(ResolveKey(config, change.first), change.second);
+        return output;
+    }
+
+    void ParameterScan::Run(const ptree& config, const vector<Point>& points, string output_file)
+    {
+        // Every point is constructed before any is run, so a bad value fails the scan before it starts.
+        vector<unique_ptr<MonteCarlo>> monte_carlos = vector<unique_ptr<MonteCarlo>>();
+        for (const Point& point : points)
+        {
+            monte_carlos.emplace_back(new MonteCarlo(Apply(config, point)));
+            if (monte_carlos.size() > 1) monte_carlos.back()->ShareCaches(*monte_carlos[monte_carlos.size() - 2]);
+        }
+
+        ofstream index = ofstream(output_file + "_scan.csv");
+        if (!index) throw runtime_error("Could not open output file " + output_file + "_scan.csv");
+        index << "Tag,Overrides\n";
+        for (const Point& point : points)
+        {
+            index << point.tag << ",";
+            for (size_t i = 0; i < point.overrides.size(); i++)
+                index << (i > 0 ? ";" : "") << ResolveKey(config, point.overrides[i].first) << "="
+                      << point.overrides[i].second;
+            index << "\n";
+        }
+        index.close();
+
+        // Each point draws from its own generator with the same seed, so the points can run at the same time on the
+        // shared pool and still see the same shower stream.
+        unsigned int seed = Random::Shared().GetSeed();
+        ThreadPool::Shared().ParallelFor(points.size(), [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                Random random(seed);
+                Random::Scope scope(random);
+                cout << "Scan point " + points[i].tag + "\n" << flush;
+                monte_carlos[i]->PerformMonteCarlo(output_file + "_" + points[i].tag);
+            }
+        });
+    }
+
+    string ParameterScan::ResolveKey(const ptree& config, string key)
+    {
+        if (key.find('.') != string::npos)
+        {
+            if (!config.get_child_optional(key)) throw runtime_error("Unknown scan key " + key);
+            return key;
+        }
+
+        string path;
+        for (const ptree::value_type& section : config)
+        {
+            if (section.second.find(key) == section.second.not_found()) continue;
+            if (!path.empty()) throw runtime_error("Ambiguous scan key " + key + ", use its full path");
+            path = section.first + "." + key;
+        }
+        if (path.empty()) throw runtime_error("Unknown scan key " + key);
+        return path;
+    }
+
+    string ParameterScan::ShortName(string key)
+    {
+        size_t split = key.rfind('.');
+        return split == string::npos ? key : key.substr(split + 1);
+    }
+}
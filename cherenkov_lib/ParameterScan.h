@@ -0,0 +1,82 @@
+// ParameterScan.h
+//
+// Author: Matthew Dutson
+//
+// Definition of ParameterScan class
+
+#ifndef PARAMETER_SCAN_H
+#define PARAMETER_SCAN_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/property_tree/ptree.hpp>
+
+namespace cherenkov_simulator
+{
+    /*
+     * Runs a Monte Carlo for each of several variants of one configuration in a single process. The variants are read
+     * from an XML scan file, which holds any number of <point> elements, each with an optional tag attribute and a list
+     * of <set key="...">value</set> overrides, and any number of <grid> elements, each with a list of
+     * <axis key="...">value value ...</axis> elements whose values are combined in every possible way. A key is either
+     * a full path such as "detector.n_pixels" or a parameter name such as "n_pixels" which appears once in the
+     * configuration.
+     */
+    class ParameterScan
+    {
+    public:
+
+        /*
+         * A single variant of the configuration, with the name used for its outputs.
+         */
+        struct Point
+        {
+            std::string tag;
+            std::vector<std::pair<std::string, std::string>> overrides;
+        };
+
+        /*
+         * Reads the points of a scan file in the order they appear. Grid points are ordered with the last axis changing
+         * fastest. Untagged points are tagged with their overrides, such as "trigr_thresh_6.0_n_pixels_300". Throws a
+         * runtime_error if the file can't be read, holds no points, has a grid axis with no values, or has two points
+         * with the same tag.
+         */
+        static std::vector<Point> Load(std::string scan_file);
+
+        /*
+         * Returns a copy of the configuration with the overrides of the point applied. Throws a runtime_error if a key
+         * isn't in the configuration or a parameter name is ambiguous.
+         */
+        static boost::property_tree::ptree Apply(const boost::property_tree::ptree& config, const Point& point);
+
+        /*
+         * Runs MonteCarlo::PerformMonteCarlo() for each point, writing the outputs to output_file_<tag>, and lists the
+         * points and their overrides in output_file_scan.csv. The points are run at the same time on the shared
+         * ThreadPool, each with its own Random generator starting from the current seed of Random::Shared(), so the
+         * points see the same shower stream as far as their parameters allow. The MonteCarlo of every point is
+         * constructed before any is run, so a bad value is reported before the scan starts. The pixel tables, the
+         * traced optics, and the trigger thresholds are shared between every point whose parameters they depend on
+         * match, which doesn't change the results. The noise banks, which are only used if simulation.noise_bank is
+         * enabled, are also shared between points whose noise means and bank sizes match. A point which reuses a bank
+         * doesn't draw its seeds and can differ from a separate run of the same configuration, and with more than one
+         * thread, which point draws them depends on timing. Without noise banks, each point is the same as a separate
+         * run.
+         */
+        static void Run(const boost::property_tree::ptree& config, const std::vector<Point>& points,
+                        std::string output_file);
+
+    private:
+
+        /*
+         * Converts a key from the scan file to a full path in the configuration.
+         */
+        static std::string ResolveKey(const boost::property_tree::ptree& config, std::string key);
+
+        /*
+         * Returns the last component of a key, which is used to build default tags.
+         */
+        static std::string ShortName(std::string key);
+    };
+}
+
+#endif
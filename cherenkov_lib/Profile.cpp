@@ -0,0 +1,72 @@
+// Profile.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of Profile.h
+
+#include <sstream>
+
+#include "Profile.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+    Profile::Timer::Timer(Stage stage) : stage(stage)
+    {
+        start = chrono::steady_clock::now();
+    }
+
+    Profile::Timer::~Timer()
+    {
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        Current().seconds[stage] += elapsed.count();
+    }
+
+    Profile::Profile()
+    {
+        for (uint64_t& count : counts)
+            count = 0;
+        for (double& time : seconds)
+            time = 0.0;
+    }
+
+    void Profile::Add(const Profile& other)
+    {
+        for (int i = 0; i < n_counters; i++)
+            counts[i] += other.counts[i];
+        for (int i = 0; i < n_stages; i++)
+            seconds[i] += other.seconds[i];
+    }
+
+    string Profile::Header()
+    {
+        return "FlorPhotons,ChkvPhotons,ConeCulled,LensMissed,CameraShadow,MirrorMissed,CameraMissed,Accepted,"
+               "Stepping(s),Fluorescence(s),Cherenkov(s),Optics(s),Noise(s),Clearing(s),Trigger(s),Fits(s),Output(s)";
+    }
+
+    string Profile::ToString() const
+    {
+        ostringstream row;
+        for (int i = 0; i < n_counters; i++)
+            row << counts[i] << ",";
+        for (int i = 0; i < n_stages; i++)
+            row << seconds[i] << (i + 1 < n_stages ? "," : "");
+        return row.str();
+    }
+
+    Profile& Profile::Current()
+    {
+        thread_local Profile current = Profile();
+        return current;
+    }
+
+    bool Profile::Enabled()
+    {
+#ifdef CHERENKOV_PROFILE
+        return true;
+#else
+        return false;
+#endif
+    }
+}
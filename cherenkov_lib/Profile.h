@@ -0,0 +1,108 @@
+// Profile.h
+//
+// Author: Matthew Dutson
+//
+// Definition of Profile class and profiling macros
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// The profiling macros compile to nothing unless CHERENKOV_PROFILE is defined, which is set by the CMake option.
+#ifdef CHERENKOV_PROFILE
+#define PROFILE_COUNT(counter, n) \
+    cherenkov_simulator::Profile::Current().counts[cherenkov_simulator::Profile::counter] += (n)
+#define PROFILE_STAGE(stage) \
+    cherenkov_simulator::Profile::Timer profile_timer(cherenkov_simulator::Profile::stage)
+#else
+#define PROFILE_COUNT(counter, n)
+#define PROFILE_STAGE(stage)
+#endif
+
+namespace cherenkov_simulator
+{
+    /*
+     * Per-stage counters and timers for the simulation and reconstruction of a shower. Each thread has its own current
+     * Profile, which is updated by the PROFILE_COUNT and PROFILE_STAGE macros, so work done on ThreadPool workers is
+     * not counted, but the stages which call into the pool are timed as a whole. Stage times are inclusive: optics is
+     * also counted in fluorescence and cherenkov, and trigger is partly counted in clearing.
+     */
+    class Profile
+    {
+    public:
+
+        /*
+         * Photon counts. Photons are counted after thinning, so each one is a ray which was traced. Each traced photon
+         * ends in exactly one of cone_culled, lens_missed, camera_shadow, mirror_missed, camera_missed, or accepted.
+         */
+        enum Counter
+        {
+            flor_photons, chkv_photons, cone_culled, lens_missed, camera_shadow, mirror_missed, camera_missed, accepted,
+            n_counters
+        };
+
+        /*
+         * Timed stages.
+         */
+        enum Stage
+        {
+            stepping, fluorescence, cherenkov, optics, noise, clearing, trigger, fits, output, n_stages
+        };
+
+        /*
+         * A timer which adds the time between its construction and destruction to a stage of the current Profile of
+         * the constructing thread.
+         */
+        class Timer
+        {
+        public:
+
+            explicit Timer(Stage stage);
+
+            ~Timer();
+
+        private:
+
+            Stage stage;
+            std::chrono::steady_clock::time_point start;
+        };
+
+        uint64_t counts[n_counters];
+        double seconds[n_stages];
+
+        /*
+         * Creates a Profile with all counts and times zero.
+         */
+        Profile();
+
+        /*
+         * Adds the counts and times of another Profile to this one.
+         */
+        void Add(const Profile& other);
+
+        /*
+         * Creates a header for rows of data created with ToString().
+         */
+        static std::string Header();
+
+        /*
+         * Creates a string with comma separated fields: the counters, then the stage times in seconds.
+         */
+        std::string ToString() const;
+
+        /*
+         * Returns the current Profile of the calling thread.
+         */
+        static Profile& Current();
+
+        /*
+         * Returns true if the profiling macros were compiled in.
+         */
+        static bool Enabled();
+    };
+}
+
+#endif
@@ -0,0 +1,307 @@
+// ProfileFitter.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of ProfileFitter.h
+
+#include <algorithm>
+#include <limits>
+
+#include "Numeric.h"
+#include "ProfileFitter.h"
+#include "ThreadPool.h"
+
+using namespace std;
+using namespace cherenkov_simulator::numeric;
+
+namespace cherenkov_simulator
+{
+    FitResult::FitResult()
+    {
+        t_0 = 0;
+        r_p = 0;
+        psi = 0;
+        chi2 = 0;
+        converged = false;
+    }
+
+    FitResult ProfileFitter::FitMonocular(const FitPoints& points)
+    {
+        Problem problem = MakeProblem(points, false, 0, 0);
+        State state = Start(problem);
+        Minimize(problem, state);
+        return Finish(problem, state);
+    }
+
+    FitResult ProfileFitter::FitHybrid(const FitPoints& points, double impact_distance, double alpha)
+    {
+        Problem problem = MakeProblem(points, true, impact_distance, alpha);
+        State state = Start(problem);
+        Minimize(problem, state);
+        return Finish(problem, state);
+    }
+
+    vector<FitResult> ProfileFitter::FitBatch(const vector<FitRequest>& requests)
+    {
+        // Fits are independent, so each runs to completion on whichever thread picks it up.
+        vector<FitResult> results = vector<FitResult>(requests.size());
+        ThreadPool::Shared().ParallelFor(requests.size(), [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                const FitRequest& request = requests[i];
+                Problem problem = MakeProblem(request.points, request.hybrid, request.impact_distance, request.alpha);
+                State state = Start(problem);
+                Minimize(problem, state);
+                results[i] = Finish(problem, state);
+            }
+        });
+        return results;
+    }
+
+    double ProfileFitter::ProfileTime(double angle, double t_0, double r_p, double psi)
+    {
+        return t_0 + r_p / c_cent * Tan((Pi() - psi - angle) / 2);
+    }
+
+    ProfileFitter::Problem ProfileFitter::MakeProblem(const FitPoints& points, bool hybrid, double impact_distance,
+                                                      double alpha)
+    {
+        Problem problem = Problem();
+        problem.hybrid = hybrid;
+        problem.impact_distance = impact_distance;
+        problem.alpha = alpha;
+
+        double weight_sum = 0;
+        double time_sum = 0;
+        for (size_t i = 0; i < points.angles.size(); i++)
+        {
+            if (points.time_err[i] <= 0) continue;
+            double weight = 1.0 / Sq(points.time_err[i]);
+            problem.angles.push_back(points.angles[i]);
+            problem.times.push_back(points.times[i]);
+            problem.weights.push_back(weight);
+            weight_sum += weight;
+            time_sum += weight * points.times[i];
+        }
+
+        // Work with times relative to their mean to avoid cancellation in the sums.
+        problem.time_offset = weight_sum > 0 ? time_sum / weight_sum : 0;
+        for (double& time : problem.times)
+            time -= problem.time_offset;
+        return problem;
+    }
+
+    ProfileFitter::State ProfileFitter::Start(const Problem& problem)
+    {
+        State state = State();
+        state.psi = PiOver2();
+        state.r_p = problem.hybrid ? problem.impact_distance * Sin(state.psi + problem.alpha) : 0;
+        state.chi2 = numeric_limits<double>::infinity();
+        state.lambda = 1e-3;
+        state.n_iter = 0;
+        state.converged = false;
+
+        // At a fixed psi the best r_p and t_0 can be solved for exactly, so a coarse scan over psi finds the basin of
+        // the global minimum.
+        size_t n_params = problem.hybrid ? 1 : 2;
+        bool found = false;
+        if (problem.angles.size() > n_params)
+        {
+            for (int i = 0; i < fit_scan; i++)
+            {
+                double psi = Pi() * (i + 0.5) / fit_scan;
+                double r_p = BestImpactParam(problem, psi);
+                double chi2, t_0;
+                if (Evaluate(problem, r_p, psi, chi2, t_0) && chi2 < state.chi2)
+                {
+                    state.r_p = r_p;
+                    state.psi = psi;
+                    state.chi2 = chi2;
+                    found = true;
+                }
+            }
+        }
+        if (found)
+        {
+            double t_0;
+            Evaluate(problem, state.r_p, state.psi, state.chi2, t_0, state.curvature, state.gradient);
+        }
+        state.done = !found;
+        return state;
+    }
+
+    void ProfileFitter::Step(const Problem& problem, State& state)
+    {
+        if (state.done) return;
+        if (state.n_iter++ >= fit_iters)
+        {
+            state.done = true;
+            return;
+        }
+
+        // Solve the damped normal equations (J^T W J + lambda * diag(J^T W J)) delta = -J^T W r.
+        double step[2] = {0, 0};
+        const double (&curv)[2][2] = state.curvature;
+        if (problem.hybrid)
+        {
+            double diag = curv[0][0] * (1 + state.lambda);
+            if (diag > 0) step[0] = -state.gradient[0] / diag;
+        }
+        else
+        {
+            double diag_0 = curv[0][0] * (1 + state.lambda);
+            double diag_1 = curv[1][1] * (1 + state.lambda);
+            double det = diag_0 * diag_1 - curv[0][1] * curv[1][0];
+            if (det > 0)
+            {
+                step[0] = (-state.gradient[0] * diag_1 + state.gradient[1] * curv[0][1]) / det;
+                step[1] = (-state.gradient[1] * diag_0 + state.gradient[0] * curv[1][0]) / det;
+            }
+        }
+
+        // The monocular parameters are (r_p, psi), and the hybrid parameter is psi.
+        double psi = state.psi + (problem.hybrid ? step[0] : step[1]);
+        double r_p = problem.hybrid ? problem.impact_distance * Sin(psi + problem.alpha) : state.r_p + step[0];
+        double chi2, t_0;
+        double curvature[2][2];
+        double gradient[2];
+        if (Evaluate(problem, r_p, psi, chi2, t_0, curvature, gradient) && chi2 <= state.chi2)
+        {
+            bool small_change = state.chi2 - chi2 <= fit_toler * chi2;
+            state.r_p = r_p;
+            state.psi = psi;
+            state.chi2 = chi2;
+            copy(&curvature[0][0], &curvature[0][0] + 4, &state.curvature[0][0]);
+            copy(gradient, gradient + 2, state.gradient);
+            state.lambda = Max(state.lambda / 10, 1e-12);
+            if (small_change) state.done = state.converged = true;
+        }
+        else
+        {
+            // Once no damped step goes downhill, the state is at a minimum to within rounding error.
+            state.lambda *= 10;
+            if (state.lambda > 1e12) state.done = state.converged = true;
+        }
+    }
+
+    void ProfileFitter::Minimize(const Problem& problem, State& state)
+    {
+        while (!state.done)
+            Step(problem, state);
+    }
+
+    FitResult ProfileFitter::Finish(const Problem& problem, const State& state)
+    {
+        FitResult result = FitResult();
+        result.r_p = state.r_p;
+        result.psi = state.psi;
+        result.converged = state.converged;
+        result.t_0 = problem.time_offset;
+        result.chi2 = state.chi2;
+        double chi2, t_0;
+        if (!problem.angles.empty() && Evaluate(problem, state.r_p, state.psi, chi2, t_0))
+        {
+            result.t_0 += t_0;
+            result.chi2 = chi2;
+        }
+        return result;
+    }
+
+    bool ProfileFitter::Evaluate(const Problem& problem, double r_p, double psi, double& chi2, double& t_0,
+                                 double (*curvature)[2], double* gradient)
+    {
+        // The derivative of the model with respect to each free parameter, for the point with the specified tangent.
+        double sin_sum = Sin(psi + problem.alpha);
+        double cos_sum = Cos(psi + problem.alpha);
+        size_t n_params = problem.hybrid ? 1 : 2;
+        auto derivatives = [&](double tan_half, double* deriv)
+        {
+            if (problem.hybrid)
+            {
+                deriv[0] = problem.impact_distance / c_cent * (cos_sum * tan_half - sin_sum * (1 + Sq(tan_half)) / 2);
+            }
+            else
+            {
+                deriv[0] = tan_half / c_cent;
+                deriv[1] = -r_p / (2 * c_cent) * (1 + Sq(tan_half));
+            }
+        };
+
+        // The first pass finds the weighted means of the residual (which is t_0) and of the derivatives.
+        double weight_sum = 0;
+        double resid_sum = 0;
+        double deriv_sum[2] = {0, 0};
+        double deriv[2];
+        for (size_t i = 0; i < problem.angles.size(); i++)
+        {
+            double angle_sum = psi + problem.angles[i];
+            if (!(angle_sum > 0 && angle_sum < TwoPi())) return false;
+            double tan_half = Tan((Pi() - angle_sum) / 2);
+            double weight = problem.weights[i];
+            weight_sum += weight;
+            resid_sum += weight * (problem.times[i] - r_p / c_cent * tan_half);
+            if (curvature == nullptr) continue;
+            derivatives(tan_half, deriv);
+            for (size_t k = 0; k < n_params; k++)
+                deriv_sum[k] += weight * deriv[k];
+        }
+        if (weight_sum <= 0) return false;
+        t_0 = resid_sum / weight_sum;
+
+        // The second pass accumulates the chi-square and normal equations about those means.
+        chi2 = 0;
+        if (curvature != nullptr)
+        {
+            for (size_t k = 0; k < 2; k++)
+            {
+                gradient[k] = 0;
+                curvature[k][0] = curvature[k][1] = 0;
+            }
+        }
+        for (size_t i = 0; i < problem.angles.size(); i++)
+        {
+            double tan_half = Tan((Pi() - psi - problem.angles[i]) / 2);
+            double weight = problem.weights[i];
+            double resid = problem.times[i] - r_p / c_cent * tan_half - t_0;
+            chi2 += weight * Sq(resid);
+            if (curvature == nullptr) continue;
+
+            // The Jacobian of the profiled residual is minus the centered model derivative.
+            derivatives(tan_half, deriv);
+            for (size_t k = 0; k < n_params; k++)
+            {
+                double jac_k = -(deriv[k] - deriv_sum[k] / weight_sum);
+                gradient[k] += weight * jac_k * resid;
+                for (size_t l = 0; l < n_params; l++)
+                    curvature[k][l] += weight * jac_k * -(deriv[l] - deriv_sum[l] / weight_sum);
+            }
+        }
+        return true;
+    }
+
+    double ProfileFitter::BestImpactParam(const Problem& problem, double psi)
+    {
+        if (problem.hybrid) return problem.impact_distance * Sin(psi + problem.alpha);
+
+        // Weighted linear regression of time against tan((pi - psi - x) / 2).
+        double weight_sum = 0;
+        double tan_sum = 0;
+        double time_sum = 0;
+        for (size_t i = 0; i < problem.angles.size(); i++)
+        {
+            weight_sum += problem.weights[i];
+            tan_sum += problem.weights[i] * Tan((Pi() - psi - problem.angles[i]) / 2);
+            time_sum += problem.weights[i] * problem.times[i];
+        }
+        double covariance = 0;
+        double variance = 0;
+        for (size_t i = 0; i < problem.angles.size(); i++)
+        {
+            double tan_diff = Tan((Pi() - psi - problem.angles[i]) / 2) - tan_sum / weight_sum;
+            covariance += problem.weights[i] * tan_diff * (problem.times[i] - time_sum / weight_sum);
+            variance += problem.weights[i] * Sq(tan_diff);
+        }
+        return variance > 0 ? c_cent * covariance / variance : 0;
+    }
+}
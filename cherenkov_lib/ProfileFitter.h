@@ -0,0 +1,165 @@
+// ProfileFitter.h
+//
+// Author: Matthew Dutson
+//
+// Definition of FitPoints, FitResult, and ProfileFitter
+
+#ifndef PROFILE_FITTER_H
+#define PROFILE_FITTER_H
+
+#include <vector>
+
+#include "Utility.h"
+
+namespace cherenkov_simulator
+{
+    /*
+     * The data used in a time profile fit. Each point is a pixel, with its angle within the shower-detector plane, its
+     * average signal time, and the error on that time.
+     */
+    struct FitPoints
+    {
+        Double1D angles;
+        Double1D times;
+        Double1D time_err;
+    };
+
+    /*
+     * The outcome of a time profile fit. For a hybrid fit, r_p is the impact parameter implied by psi and the impact
+     * point.
+     */
+    struct FitResult
+    {
+        /*
+         * The default constructor. Sets all parameters to zero and converged to false.
+         */
+        FitResult();
+
+        double t_0;
+        double r_p;
+        double psi;
+        double chi2;
+        bool converged;
+    };
+
+    /*
+     * A single fit within a batch. If hybrid is false, impact_distance and alpha are ignored.
+     */
+    struct FitRequest
+    {
+        FitPoints points;
+        bool hybrid;
+        double impact_distance;
+        double alpha;
+    };
+
+    /*
+     * Fits the time profile t(x) = t_0 + r_p / c * tan((pi - psi - x) / 2) to a set of points. The model is linear in
+     * t_0, so t_0 is eliminated analytically at every step and the remaining parameters (r_p and psi for a monocular
+     * fit, psi for a hybrid fit) are found by Levenberg-Marquardt iteration with analytic derivatives. The starting
+     * point comes from a scan over psi, where r_p is also solved for exactly. Points with zero time error are ignored.
+     */
+    class ProfileFitter
+    {
+    public:
+
+        /*
+         * Fits t_0, r_p, and psi.
+         */
+        static FitResult FitMonocular(const FitPoints& points);
+
+        /*
+         * Fits t_0 and psi, with r_p constrained to impact_distance * sin(psi + alpha) by a known ground impact point.
+         */
+        static FitResult FitHybrid(const FitPoints& points, double impact_distance, double alpha);
+
+        /*
+         * Performs many independent fits on the shared ThreadPool. Each fit runs from start to finish on a single
+         * thread, so there is no synchronization between iterations. The results are identical to fitting each request
+         * on its own.
+         */
+        static std::vector<FitResult> FitBatch(const std::vector<FitRequest>& requests);
+
+        /*
+         * Evaluates the time profile model at the specified angle.
+         */
+        static double ProfileTime(double angle, double t_0, double r_p, double psi);
+
+    private:
+
+        friend class ProfileFitterTest;
+
+        /*
+         * The usable points of a fit along with its constraint. Times are stored relative to their weighted mean.
+         */
+        struct Problem
+        {
+            Double1D angles;
+            Double1D times;
+            Double1D weights;
+            double time_offset;
+            bool hybrid;
+            double impact_distance;
+            double alpha;
+        };
+
+        /*
+         * The current position of a Levenberg-Marquardt minimization, along with the normal equations at that
+         * position. Only the first element of each array is used in a hybrid fit.
+         */
+        struct State
+        {
+            double r_p;
+            double psi;
+            double chi2;
+            double lambda;
+            double curvature[2][2];
+            double gradient[2];
+            int n_iter;
+            bool done;
+            bool converged;
+        };
+
+        /*
+         * Builds a problem from the points, dropping those with non-positive time errors.
+         */
+        static Problem MakeProblem(const FitPoints& points, bool hybrid, double impact_distance, double alpha);
+
+        /*
+         * Finds the starting point by scanning psi over (0, pi). If no value of psi is valid for every point, the
+         * returned state is already done and not converged.
+         */
+        static State Start(const Problem& problem);
+
+        /*
+         * Performs one Levenberg-Marquardt iteration, updating the state. Does nothing if the state is done.
+         */
+        static void Step(const Problem& problem, State& state);
+
+        /*
+         * Runs Step() until the state is done.
+         */
+        static void Minimize(const Problem& problem, State& state);
+
+        /*
+         * Converts a finished state to a result.
+         */
+        static FitResult Finish(const Problem& problem, const State& state);
+
+        /*
+         * Computes the chi-square at (r_p, psi) with t_0 eliminated, along with t_0 itself. If curvature and gradient
+         * are non-null, they are filled with the Gauss-Newton normal equations (J^T W J and J^T W r) for the free
+         * parameters. Returns false if psi + angle leaves (0, 2 pi) for any point, where the model is undefined.
+         */
+        static bool Evaluate(const Problem& problem, double r_p, double psi, double& chi2, double& t_0,
+                             double (*curvature)[2] = nullptr, double* gradient = nullptr);
+
+        /*
+         * Returns the r_p which minimizes the chi-square at a fixed psi in a monocular fit, or the constrained r_p in a
+         * hybrid fit.
+         */
+        static double BestImpactParam(const Problem& problem, double psi);
+    };
+}
+
+#endif
@@ -0,0 +1,148 @@
+// Random.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of Random.h
+
+#include "Numeric.h"
+#include "Random.h"
+
+using namespace std;
+using namespace cherenkov_simulator::numeric;
+
+namespace cherenkov_simulator
+{
+    Random::Random(unsigned int seed)
+    {
+        SetSeed(seed);
+    }
+
+    void Random::SetSeed(unsigned int seed)
+    {
+        while (seed == 0) seed = random_device()();
+        this->seed = seed;
+        engine.seed(seed);
+        has_spare = false;
+    }
+
+    unsigned int Random::GetSeed() const
+    {
+        return seed;
+    }
+
+    double Random::Rndm()
+    {
+        // The tempered 32-bit output of the engine is the same as that of TRandom3, and is scaled the same way.
+        while (true)
+        {
+            uint_fast32_t value = engine();
+            if (value != 0) return 2.3283064365386963e-10 * value;
+        }
+    }
+
+    void Random::RndmArray(int n, double* array)
+    {
+        for (int i = 0; i < n; i++) array[i] = Rndm();
+    }
+
+    double Random::Uniform(double max)
+    {
+        return max * Rndm();
+    }
+
+    double Random::Uniform(double min, double max)
+    {
+        return min + (max - min) * Rndm();
+    }
+
+    double Random::Exp(double tau)
+    {
+        return -tau * Log(Rndm());
+    }
+
+    unsigned int Random::Integer(unsigned int max)
+    {
+        return (unsigned int) (max * Rndm());
+    }
+
+    int Random::Poisson(double mean)
+    {
+        if (mean <= 0) return 0;
+        if (mean < 25)
+        {
+            double exp_mean = numeric::Exp(-mean);
+            double product = 1.0;
+            int n = -1;
+            do
+            {
+                n++;
+                product *= Rndm();
+            } while (product > exp_mean);
+            return n;
+        }
+        if (mean < 1e9)
+        {
+            // Rejection from a Lorentzian envelope (see Numerical Recipes).
+            double sq = Sqrt(2.0 * mean);
+            double log_mean = Log(mean);
+            double g = mean * log_mean - LnGamma(mean + 1.0);
+            double em, t, y;
+            do
+            {
+                do
+                {
+                    y = Tan(Pi() * Rndm());
+                    em = sq * y + mean;
+                } while (em < 0.0);
+                em = Floor(em);
+                t = 0.9 * (1.0 + y * y) * numeric::Exp(em * log_mean - LnGamma(em + 1.0) - g);
+            } while (Rndm() > t);
+            return (int) em;
+        }
+        return (int) (Gaus(0.0, 1.0) * Sqrt(mean) + mean + 0.5);
+    }
+
+    double Random::Gaus(double mean, double sigma)
+    {
+        if (has_spare)
+        {
+            has_spare = false;
+            return mean + sigma * spare;
+        }
+        double u, v, s;
+        do
+        {
+            u = 2.0 * Rndm() - 1.0;
+            v = 2.0 * Rndm() - 1.0;
+            s = u * u + v * v;
+        } while (s >= 1.0 || s == 0.0);
+        double scale = Sqrt(-2.0 * Log(s) / s);
+        spare = v * scale;
+        has_spare = true;
+        return mean + sigma * u * scale;
+    }
+
+    Random& Random::Shared()
+    {
+        static Random shared = Random();
+        Random* scoped = ScopedPointer();
+        return scoped == nullptr ? shared : *scoped;
+    }
+
+    Random::Scope::Scope(Random& random)
+    {
+        previous = ScopedPointer();
+        ScopedPointer() = &random;
+    }
+
+    Random::Scope::~Scope()
+    {
+        ScopedPointer() = previous;
+    }
+
+    Random*& Random::ScopedPointer()
+    {
+        thread_local Random* scoped = nullptr;
+        return scoped;
+    }
+}
@@ -0,0 +1,124 @@
+// Random.h
+//
+// Author: Matthew Dutson
+//
+// Definition of Random class
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <random>
+
+namespace cherenkov_simulator
+{
+    /*
+     * A Mersenne Twister random number generator with the interface of the parts of TRandom3 used by the simulation,
+     * so that the core library doesn't depend on ROOT. The engine is seeded the same way as TRandom3, and Rndm(),
+     * Uniform(), Exp(), Integer(), and Poisson() use the same algorithms as ROOT, so a given seed produces the same
+     * numbers as it would with TRandom3 (up to rounding in the logarithm of the gamma function). Gaus() uses the polar
+     * Box-Muller method and doesn't match TRandom::Gaus().
+     */
+    class Random
+    {
+    public:
+
+        /*
+         * Creates a generator with the specified seed. The default is the default seed of TRandom3.
+         */
+        explicit Random(unsigned int seed = 4357);
+
+        /*
+         * Reseeds the generator. A seed of zero is replaced by a nonzero seed drawn from std::random_device, as
+         * TRandom3 replaces it with a time-based seed.
+         */
+        void SetSeed(unsigned int seed = 0);
+
+        /*
+         * Returns the seed passed to the last call of SetSeed() or the constructor, after any replacement of zero.
+         */
+        unsigned int GetSeed() const;
+
+        /*
+         * Returns a uniform random number in (0, 1]. Zero is never returned.
+         */
+        double Rndm();
+
+        /*
+         * Fills an array with n numbers from Rndm().
+         */
+        void RndmArray(int n, double* array);
+
+        /*
+         * Returns a uniform random number in (0, max] or (min, max].
+         */
+        double Uniform(double max);
+
+        double Uniform(double min, double max);
+
+        /*
+         * Returns a number from an exponential distribution with mean tau.
+         */
+        double Exp(double tau);
+
+        /*
+         * Returns a uniform random integer in [0, max).
+         */
+        unsigned int Integer(unsigned int max);
+
+        /*
+         * Returns a number from a Poisson distribution with the specified mean. A multiplication method is used below
+         * a mean of 25, a rejection method below a mean of 1e9, and a Gaussian approximation above that.
+         */
+        int Poisson(double mean);
+
+        /*
+         * Returns a number from a Gaussian distribution with the specified mean and standard deviation.
+         */
+        double Gaus(double mean = 0.0, double sigma = 1.0);
+
+        /*
+         * Returns the generator shared by the whole application, which takes the place of gRandom. It must only be used
+         * from one thread at a time. Parallel stages seed their own generators from it. If the calling thread is inside
+         * a Scope, the scope's generator is returned instead.
+         */
+        static Random& Shared();
+
+        /*
+         * Makes Shared() return the specified generator on the calling thread for the life of the scope, so that tasks
+         * which run at the same time on different threads each draw from their own stream. Scopes may be nested.
+         */
+        class Scope
+        {
+        public:
+
+            explicit Scope(Random& random);
+
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+
+            Random* previous;
+        };
+
+    private:
+
+        std::mt19937 engine;
+        unsigned int seed;
+
+        // The second Gaussian number from the last pair generated by Gaus(), if it hasn't been used yet
+        bool has_spare;
+        double spare;
+
+        /*
+         * Returns the storage for the generator of the innermost Scope on the calling thread, which is null outside
+         * any scope.
+         */
+        static Random*& ScopedPointer();
+    };
+}
+
+#endif
@@ -4,17 +4,17 @@
 //
 // Implementation of Reconstructor.h
 
-#include <TF1.h>
-#include <TFile.h>
-#include <TGraphErrors.h>
-#include <TMath.h>
-#include <TMatrixDSymEigen.h>
+#include <algorithm>
+#include <limits>
 
+#include "Numeric.h"
+#include "Profile.h"
 #include "Reconstructor.h"
+#include "ThreadPool.h"
 
 using namespace std;
 using namespace boost::property_tree;
-using namespace TMath;
+using namespace cherenkov_simulator::numeric;
 
 namespace cherenkov_simulator
 {
@@ -42,10 +42,12 @@ namespace cherenkov_simulator
 
     Reconstructor::Reconstructor(const ptree& config)
     {
-        TVector3 ground_norm = Utility::ToVector(config.get<string>("surroundings.ground_norm"));
-        TVector3 ground_fixd = Utility::ToVector(config.get<string>("surroundings.ground_fixd"));
-        ground_plane = Plane(ground_norm, ground_fixd);
-        rot_to_world = Utility::MakeRotation(config.get<double>("surroundings.elevation_angle"));
+        Vec3 ground_norm = Utility::ToVector(config.get<string>("surroundings.ground_norm"));
+        Vec3 ground_fixd = Utility::ToVector(config.get<string>("surroundings.ground_fixd"));
+        site_posn = Utility::ToVector(config.get<string>("surroundings.site_posn"));
+        ground_plane = Plane(ground_norm, ground_fixd - site_posn);
+        rot_to_world = Utility::MakeRotation(config.get<double>("surroundings.elevation_angle"),
+                                             config.get<double>("surroundings.azimuth_angle"));
 
         double mirror_radius = config.get<double>("detector.mirror_radius");
         double stop_diameter = mirror_radius / (2.0 * config.get<double>("detector.f_number"));
@@ -57,152 +59,218 @@ namespace cherenkov_simulator
         impact_buffr = config.get<double>("triggering.impact_buffr");
         plane_thresh = config.get<double>("triggering.plane_thresh");
         trigr_clustr = config.get<int>("triggering.trigr_clustr");
+        trigr_patrn = TriggerEngine::ParsePattern(config.get<string>("triggering.trigr_patrn"));
+
+        noise_bank = config.get<bool>("simulation.noise_bank");
+        bank_count = config.get<size_t>("simulation.bank_count");
+        bank_bins = config.get<size_t>("simulation.bank_bins");
+        noise_banks = make_shared<NoiseBankCache>();
     }
 
-    Reconstructor::Result Reconstructor::Reconstruct(const PhotonCount& data) const
+    Reconstructor::Result Reconstructor::Reconstruct(const PhotonCount& data, bool triggered) const
     {
         Result result = Result();
-        result.triggered = DetectorTriggered(GetTriggeringState(data));
+        result.triggered = triggered;
         if (result.triggered)
         {
-            TRotation to_sdp = FitSDPlane(data);
-            result.mono_recon = MonocularFit(data, to_sdp);
-            TVector3 direction = rot_to_world.Inverse() * result.mono_recon.PlaneImpact(ground_plane);
+            Mat3 to_sdp = FitSDPlane(data);
+            result.mono_recon = MonocularFit(data, to_sdp, result.mono_fit);
+            Vec3 direction = rot_to_world.Inverse() * result.mono_recon.PlaneImpact(ground_plane);
             if (direction.Theta() < data.DetectorAxisAngle() - impact_buffr)
             {
-                TVector3 impact;
+                Vec3 impact;
                 if (FindGroundImpact(data, impact))
                 {
-                    result.chkv_recon = HybridFit(data, impact, to_sdp);
+                    result.chkv_recon = HybridFit(data, impact, to_sdp, result.chkv_fit);
                     result.chkv_tried = true;
                 }
             }
+
+            // The fits are done relative to the detector, but results are reported in the world frame.
+            result.mono_recon.Translate(site_posn);
+            result.chkv_recon.Translate(site_posn);
         }
         return result;
     }
 
+    Reconstructor::FitInput Reconstructor::PrepareFits(const PhotonCount& data, bool triggered) const
+    {
+        FitInput input = FitInput();
+        input.triggered = triggered;
+        input.axis_angle = data.DetectorAxisAngle();
+        input.impact_found = false;
+        if (!input.triggered) return input;
+        input.to_sdp = FitSDPlane(data);
+        input.points = GetFitPoints(data, input.to_sdp);
+        input.impact_found = FindGroundImpact(data, input.impact);
+        return input;
+    }
+
+    vector<Reconstructor::Result> Reconstructor::ReconstructBatch(const vector<FitInput>& inputs) const
+    {
+        PROFILE_STAGE(fits);
+        vector<Result> results = vector<Result>(inputs.size());
+        vector<FitRequest> requests = vector<FitRequest>();
+        vector<size_t> owners = vector<size_t>();
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            if (!inputs[i].triggered) continue;
+            requests.push_back({inputs[i].points, false, 0.0, 0.0});
+            owners.push_back(i);
+        }
+        vector<FitResult> fits = ProfileFitter::FitBatch(requests);
+
+        // As in Reconstruct(), the hybrid fit is only tried if the ground impact of the monocular fit is in view.
+        requests.clear();
+        vector<size_t> hybrid_owners = vector<size_t>();
+        for (size_t j = 0; j < owners.size(); j++)
+        {
+            const FitInput& input = inputs[owners[j]];
+            Result& result = results[owners[j]];
+            result.triggered = true;
+            result.mono_fit = fits[j];
+            result.mono_recon = MakeShower(fits[j].t_0, fits[j].r_p, fits[j].psi, input.to_sdp);
+            Vec3 direction = rot_to_world.Inverse() * result.mono_recon.PlaneImpact(ground_plane);
+            if (direction.Theta() >= input.axis_angle - impact_buffr || !input.impact_found) continue;
+            requests.push_back({input.points, true, input.impact.Mag(), (input.to_sdp * input.impact).Phi()});
+            hybrid_owners.push_back(owners[j]);
+        }
+        fits = ProfileFitter::FitBatch(requests);
+        for (size_t j = 0; j < hybrid_owners.size(); j++)
+        {
+            const FitInput& input = inputs[hybrid_owners[j]];
+            Result& result = results[hybrid_owners[j]];
+            result.chkv_fit = fits[j];
+            double r_p = input.impact.Mag() * Sin(fits[j].psi);
+            result.chkv_recon = MakeShower(fits[j].t_0, r_p, fits[j].psi, input.to_sdp);
+            result.chkv_tried = true;
+        }
+
+        for (Result& result : results)
+        {
+            if (!result.triggered) continue;
+            result.mono_recon.Translate(site_posn);
+            result.chkv_recon.Translate(site_posn);
+        }
+        return results;
+    }
+
     void Reconstructor::AddNoise(PhotonCount& data) const
     {
+        PROFILE_STAGE(noise);
+        Double2D noise_rates = Double2D(data.Size(), Double1D(data.Size(), 0.0));
         PhotonCount::Iterator iter = data.GetIterator();
         while (iter.Next())
         {
             bool toward_ground = ground_plane.InFrontOf(rot_to_world * data.Direction(iter));
-            data.AddNoise(toward_ground ? gnd_noise : sky_noise, iter);
+            noise_rates[iter.X()][iter.Y()] = toward_ground ? gnd_noise : sky_noise;
         }
-    }
 
-    Shower Reconstructor::MonocularFit(const PhotonCount& data, TRotation to_sdp, string graph_file) const
-    {
-        // Define the functional form of the time profile.
-        stringstream func_string = stringstream();
-        func_string << "[0] + [1] / (" << c_cent << ") * tan((pi - [2] - x) / 2)";
-        TF1 func = TF1("profile_fit", func_string.str().c_str(), -Pi(), Pi());
-
-        func.SetParNames("t_0", "r_p", "psi");
-        func.SetParameters(0.0, 1e6, PiOver2());
-        TGraphErrors data_graph = GetFitGraph(data, to_sdp);
-        data_graph.Fit("profile_fit", "Q");
-        TF1* result = data_graph.GetFunction("profile_fit");
-        if (!graph_file.empty())
+        vector<const NoiseBank*> banks = vector<const NoiseBank*>();
+        if (noise_bank)
         {
-            TFile file(graph_file.c_str(), "RECREATE");
-            data_graph.Write("fit_graph");
+            banks.push_back(&GetNoiseBank(data.RealNoiseRate(sky_noise)));
+            banks.push_back(&GetNoiseBank(data.RealNoiseRate(gnd_noise)));
         }
+        data.AddNoise(noise_rates, banks);
+    }
+
+    const NoiseBank& Reconstructor::GetNoiseBank(double mean) const
+    {
+        // Banks are held by pointer, so references to them stay valid as the list grows.
+        lock_guard<mutex> lock(noise_banks->mutex);
+        for (const shared_ptr<NoiseBank>& bank : noise_banks->banks)
+            if (bank->Mean() == mean && bank->NSeries() == bank_count && bank->NBins() == bank_bins) return *bank;
+        noise_banks->banks.push_back(make_shared<NoiseBank>(mean, bank_count, bank_bins));
+        return *noise_banks->banks.back();
+    }
+
+    void Reconstructor::ShareNoiseBanks(const Reconstructor& other)
+    {
+        noise_banks = other.noise_banks;
+    }
 
-        double t_0 = result->GetParameter("t_0");
-        double r_p = result->GetParameter("r_p");
-        double psi = result->GetParameter("psi");
-        return MakeShower(t_0, r_p, psi, to_sdp);
+    Shower Reconstructor::MonocularFit(const PhotonCount& data, Mat3 to_sdp, FitResult& fit) const
+    {
+        PROFILE_STAGE(fits);
+        FitPoints points = GetFitPoints(data, to_sdp);
+        fit = ProfileFitter::FitMonocular(points);
+        return MakeShower(fit.t_0, fit.r_p, fit.psi, to_sdp);
     }
 
-    Shower Reconstructor::HybridFit(const PhotonCount& data, TVector3 impact, TRotation to_sdp, string graph_file) const
+    Shower Reconstructor::HybridFit(const PhotonCount& data, Vec3 impact, Mat3 to_sdp, FitResult& fit) const
     {
+        PROFILE_STAGE(fits);
         double impact_distance = impact.Mag();
         double alpha = (to_sdp * impact).Phi();
 
-        // Define the functional form of the time profile.
-        stringstream func_string = stringstream();
-        func_string << "[0] +" << impact_distance << " * sin([1] + " << alpha << ") / (" << c_cent
-                    << ") * tan((pi - [1] - x) / 2)";
-        TF1 func = TF1("profile_fit", func_string.str().c_str(), -Pi(), Pi());
-
-        func.SetParNames("t_0", "psi");
-        func.SetParameters(0.0, PiOver2());
-        TGraphErrors data_graph = GetFitGraph(data, to_sdp);
-        data_graph.Fit("profile_fit", "Q");
-        TF1* result = data_graph.GetFunction("profile_fit");
-        if (!graph_file.empty())
-        {
-            TFile file(graph_file.c_str(), "RECREATE");
-            data_graph.Write("fit_graph");
-        }
+        FitPoints points = GetFitPoints(data, to_sdp);
+        fit = ProfileFitter::FitHybrid(points, impact_distance, alpha);
+        double r_p = impact_distance * Sin(fit.psi);
+        return MakeShower(fit.t_0, r_p, fit.psi, to_sdp);
+    }
 
-        double t_0 = result->GetParameter("t_0");
-        double psi = result->GetParameter("psi");
-        double r_p = impact_distance * Sin(psi);
-        return MakeShower(t_0, r_p, psi, to_sdp);
+    Mat3 Reconstructor::FitSDPlane(const PhotonCount& data, const Bool3D* mask) const
+    {
+        double matrix[3][3];
+        PlaneMoments(data, matrix, mask);
+        return MakeSDPFrame(rot_to_world * Utility::MinEigenvector(matrix));
     }
 
-    TRotation Reconstructor::FitSDPlane(const PhotonCount& data, const Bool3D* mask) const
+    void Reconstructor::PlaneMoments(const PhotonCount& data, double matrix[3][3], const Bool3D* mask) const
     {
-        PhotonCount::Iterator iter = data.GetIterator();
-        Bool1D curr_mask = Bool1D(data.NBins(), true);
-        TMatrixDSym matrix(3);
-        for (int j = 0; j < 3; j++)
+        // Accumulate the six independent elements of the moment tensor in one pass over the pixels. Each row keeps its
+        // own partial sums so that the result doesn't depend on the number of threads.
+        Int2D sums = data.PixelSums(mask);
+        const vector<vector<Vec3>>& directions = data.Directions();
+        Double2D row_moments = Double2D(data.Size(), Double1D(6, 0.0));
+        ThreadPool::Shared().ParallelFor(data.Size(), [&](size_t begin, size_t end)
         {
-            for (int k = j; k < 3; k++)
+            for (size_t x = begin; x < end; x++)
             {
-                double mat_element = 0;
-                iter.Reset();
-                while (iter.Next())
+                Double1D& moments = row_moments[x];
+                for (size_t y = 0; y < data.Size(); y++)
                 {
-                    int pmt_sum;
-                    if (mask == nullptr)
-                        pmt_sum = data.SumBins(iter);
-                    else
-                        pmt_sum = data.SumBinsFiltered(iter, *mask);
-                    TVector3 direction = data.Direction(iter);
-                    mat_element += direction[j] * direction[k] * pmt_sum;
+                    if (sums[x][y] == 0) continue;
+                    const Vec3& direction = directions[x][y];
+                    double weight = sums[x][y];
+                    moments[0] += direction.X() * direction.X() * weight;
+                    moments[1] += direction.X() * direction.Y() * weight;
+                    moments[2] += direction.X() * direction.Z() * weight;
+                    moments[3] += direction.Y() * direction.Y() * weight;
+                    moments[4] += direction.Y() * direction.Z() * weight;
+                    moments[5] += direction.Z() * direction.Z() * weight;
                 }
-                matrix[j][k] = mat_element;
-                matrix[k][j] = mat_element;
             }
-        }
-
-        // Construct the shower-detector frame.
-        TVector3 normal = rot_to_world * MinValVec(matrix);
-        if (normal.X() < 0) normal = -normal;
-        TVector3 new_x = (normal == TVector3(0, 0, 1)) ? TVector3(1, 0, 0) : TVector3(0, 0, 1).Cross(normal).Unit();
-        TVector3 new_y = normal.Cross(new_x).Unit();
-        return TRotation().RotateAxes(new_x, new_y, normal).Inverse();
+        });
+        Double1D moments = Double1D(6, 0.0);
+        for (const Double1D& row : row_moments)
+            for (int i = 0; i < 6; i++)
+                moments[i] += row[i];
+        matrix[0][0] = moments[0];
+        matrix[0][1] = matrix[1][0] = moments[1];
+        matrix[0][2] = matrix[2][0] = moments[2];
+        matrix[1][1] = moments[3];
+        matrix[1][2] = matrix[2][1] = moments[4];
+        matrix[2][2] = moments[5];
     }
 
-    TVector3 Reconstructor::MinValVec(TMatrixDSym matrix) const
+    Mat3 Reconstructor::MakeSDPFrame(Vec3 normal)
     {
-        TMatrixDSymEigen eigen = TMatrixDSymEigen(matrix);
-        TVectorD eigen_val = eigen.GetEigenValues();
-        TMatrixD eigen_vec = eigen.GetEigenVectors();
-        double min_val = eigen_val[0];
-        int min_index = 0;
-        for (int i = 0; i < eigen_val.GetNoElements(); i++)
-        {
-            if (eigen_val[i] < min_val)
-            {
-                min_val = eigen_val[i];
-                min_index = i;
-            }
-        }
-        return TVector3(eigen_vec[0][min_index], eigen_vec[1][min_index], eigen_vec[2][min_index]);
+        if (normal.X() < 0) normal = -normal;
+        Vec3 new_x = (normal == Vec3(0, 0, 1)) ? Vec3(1, 0, 0) : Vec3(0, 0, 1).Cross(normal).Unit();
+        Vec3 new_y = normal.Cross(new_x).Unit();
+        return Mat3().RotateAxes(new_x, new_y, normal).Inverse();
     }
 
-    bool Reconstructor::FindGroundImpact(const PhotonCount& data, TVector3& impact) const
+    bool Reconstructor::FindGroundImpact(const PhotonCount& data, Vec3& impact) const
     {
-        TVector3 reflect_dir = TVector3();
+        Vec3 reflect_dir = Vec3();
         int highest_sum = 0;
         PhotonCount::Iterator iter = data.GetIterator();
         while (iter.Next())
         {
-            TVector3 direction = rot_to_world * data.Direction(iter);
+            Vec3 direction = rot_to_world * data.Direction(iter);
             int sum = data.SumBins(iter);
             if (sum > highest_sum && ground_plane.InFrontOf(direction))
             {
@@ -211,36 +279,49 @@ namespace cherenkov_simulator
             }
         }
 
-        if (reflect_dir == TVector3()) return false;
-        Ray outward_ray = Ray(TVector3(), reflect_dir, 0);
+        if (reflect_dir == Vec3()) return false;
+        Ray outward_ray = Ray(Vec3(), reflect_dir, 0);
         outward_ray.PropagateToPlane(ground_plane);
         impact = outward_ray.Position();
         return highest_sum > data.FindThreshold(gnd_noise, trigr_thresh);
     }
 
-    TGraphErrors Reconstructor::GetFitGraph(const PhotonCount& data, TRotation to_sdp) const
+    FitPoints Reconstructor::GetFitPoints(const PhotonCount& data, Mat3 to_sdp) const
     {
-        Double1D angles = Double1D();
-        Double1D times = Double1D();
-        Double1D time_err = Double1D();
+        FitPoints unsorted = FitPoints();
         PhotonCount::Iterator iter = data.GetIterator();
         while (iter.Next())
         {
             // Don't rotate to the world because the rotation goes from the detector frame to the shower-detector frame.
-            TVector3 direction = rot_to_world * data.Direction(iter);
+            Vec3 direction = rot_to_world * data.Direction(iter);
             int bin_sum = data.SumBins(iter);
             if (!ground_plane.InFrontOf(direction) && bin_sum > 0)
             {
-                angles.push_back((to_sdp * direction).Phi());
-                times.push_back(data.AverageTime(iter));
-                time_err.push_back(data.TimeError(iter));
+                unsorted.angles.push_back((to_sdp * direction).Phi());
+                unsorted.times.push_back(data.AverageTime(iter));
+                unsorted.time_err.push_back(data.TimeError(iter));
             }
         }
+        return SortFitPoints(unsorted);
+    }
 
-        Double1D angle_err = Double1D(angles.size(), 0.0);
-        TGraphErrors graph = TGraphErrors((int) angles.size(), &(angles[0]), &(times[0]), &(angle_err[0]), &(time_err[0]));
-        graph.Sort();
-        return graph;
+    FitPoints Reconstructor::SortFitPoints(const FitPoints& unsorted)
+    {
+        vector<size_t> order = vector<size_t>(unsorted.angles.size());
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        stable_sort(order.begin(), order.end(), [&unsorted](size_t a, size_t b)
+        {
+            return unsorted.angles[a] < unsorted.angles[b];
+        });
+        FitPoints points = FitPoints();
+        for (size_t i : order)
+        {
+            points.angles.push_back(unsorted.angles[i]);
+            points.times.push_back(unsorted.times[i]);
+            points.time_err.push_back(unsorted.time_err[i]);
+        }
+        return points;
     }
 
     void Reconstructor::SubtractAverageNoise(PhotonCount& data) const
@@ -255,113 +336,69 @@ namespace cherenkov_simulator
 
     Bool1D Reconstructor::GetTriggeringState(const PhotonCount& data) const
     {
-        Bool3D trig_matrices = GetThresholdMatrices(data, trigr_thresh, false);
-        Bool1D good_frames = Bool1D(data.NBins(), false);
-
-        list<array<size_t, 3>> frontier = list<array<size_t, 3>>();
-        for (size_t t_trig = 0; t_trig < data.NBins(); t_trig++)
+        PROFILE_STAGE(trigger);
+        // The breadth-first search this replaced counted its starting pixel twice, so a cluster needed trigr_clustr
+        // pixels (not trigr_clustr + 1) to trigger. The engine's cluster pattern keeps that behavior.
+        vector<PhotonCount::Cell> cells = data.CellsAbove(*GetThresholds(data, trigr_thresh, false));
+        TriggerEngine engine = TriggerEngine(data.Size(), data.Size(), trigr_patrn, trigr_clustr);
+        BitFrame frame = BitFrame(data.Size(), data.Size());
+
+        // The cells are sorted by time bin, so each frame is set from the next run of cells and cleared once pushed.
+        size_t next = 0;
+        for (size_t t = 0; t < data.NBins(); t++)
         {
-            bool found = false;
-            for (size_t x_trig = 0; x_trig < trig_matrices.size() && !found; x_trig++)
-            {
-                for (size_t y_trig = 0; y_trig < trig_matrices.at(x_trig).size() && !found; y_trig++)
-                {
-                    if (trig_matrices.at(x_trig)[y_trig][t_trig])
-                        frontier.push_back({x_trig, y_trig, t_trig});
-
-                    int adjacent = 0;
-                    while (!frontier.empty() && !found)
-                    {
-                        array<size_t, 3> curr = frontier.front();
-                        frontier.pop_front();
-                        size_t x = curr[0];
-                        size_t y = curr[1];
-                        size_t t = curr[2];
-                        adjacent++;
-                        if (adjacent > trigr_clustr)
-                        {
-                            frontier.clear();
-                            found = true;
-                        }
-                        VisitSpaceAdj(x, y, t, frontier, trig_matrices);
-                    }
-                }
-            }
-            good_frames[t_trig] = found;
+            size_t first = next;
+            for (; next < cells.size() && cells[next].t == t; next++)
+                frame.Set(cells[next].x, cells[next].y);
+            engine.Push(frame);
+            for (size_t i = first; i < next; i++)
+                frame.Set(cells[i].x, cells[i].y, false);
         }
-        return good_frames;
+        return engine.Decisions();
     }
 
-    void Reconstructor::ClearNoise(PhotonCount& data) const
+    bool Reconstructor::ClearNoise(PhotonCount& data) const
     {
+        PROFILE_STAGE(clearing);
         SubtractAverageNoise(data);
-        Bool3D not_visited = GetThresholdMatrices(data, noise_thresh);
-        Bool3D triggered = GetThresholdMatrices(data, trigr_thresh);
-        Bool3D good_pixels = data.GetFalseMatrix();
+        vector<PhotonCount::Cell> above = data.CellsAbove(*GetThresholds(data, trigr_thresh));
+        Bool3D triggered = data.CellMatrix(above);
         FindPlaneSubset(data, triggered);
         Bool1D trig_state = GetTriggeringState(data);
-
-        list<array<size_t, 3>> frontier = list<array<size_t, 3>>();
-        for (size_t x_trig = 0; x_trig < triggered.size(); x_trig++)
+        if (!DetectorTriggered(trig_state))
         {
-            for (size_t y_trig = 0; y_trig < triggered[x_trig].size(); y_trig++)
-            {
-                for (size_t t_trig = 0; t_trig < triggered[x_trig][y_trig].size(); t_trig++)
-                {
-                    if (triggered[x_trig][y_trig][t_trig] && trig_state[t_trig])
-                        frontier.push_back({x_trig, y_trig, t_trig});
-
-                    while (!frontier.empty())
-                    {
-                        array<size_t, 3> curr = frontier.front();
-                        frontier.pop_front();
-                        size_t x = curr[0];
-                        size_t y = curr[1];
-                        size_t t = curr[2];
-                        good_pixels[x][y][t] = true;
-                        VisitSpaceAdj(x, y, t, frontier, not_visited);
-                        VisitTimeAdj(x, y, t, frontier, not_visited);
-                    }
-                }
-            }
+            data.Subset(data.GetFalseMatrix());
+            return false;
         }
-        data.Subset(good_pixels);
-    }
 
-    void Reconstructor::VisitSpaceAdj(size_t x, size_t y, size_t t, list<array<size_t, 3>>& front, Bool3D& not_visited)
-    {
-        VisitPush(x - 1, y - 1, t, front, not_visited);
-        VisitPush(x - 1, y, t, front, not_visited);
-        VisitPush(x - 1, y + 1, t, front, not_visited);
-        VisitPush(x, y - 1, t, front, not_visited);
-        VisitPush(x, y + 1, t, front, not_visited);
-        VisitPush(x + 1, y - 1, t, front, not_visited);
-        VisitPush(x + 1, y, t, front, not_visited);
-        VisitPush(x + 1, y + 1, t, front, not_visited);
-    }
-
-    void Reconstructor::VisitTimeAdj(size_t x, size_t y, size_t t, list<array<size_t, 3>>& front, Bool3D& not_visited)
-    {
-        VisitPush(x, y, t - 1, front, not_visited);
-        VisitPush(x, y, t + 1, front, not_visited);
-    }
+        // Keep every cluster of above-noise cells which contains a triggered cell in a triggered frame.
+        ClusterLabeler labeler = ClusterLabeler(data.ThresholdFrames(*GetThresholds(data, noise_thresh)), true);
+        vector<bool> keep = vector<bool>(labeler.NClusters(), false);
+        Bool3D good_pixels = data.GetFalseMatrix();
+        bool any_kept = false;
+        for (const PhotonCount::Cell& cell : above)
+        {
+            if (!triggered[cell.x][cell.y][cell.t] || !trig_state[cell.t]) continue;
+            good_pixels[cell.x][cell.y][cell.t] = true;
+            any_kept = true;
+            int label = labeler.Label(cell.x, cell.y, cell.t);
+            if (label >= 0) keep[label] = true;
+        }
 
-    void Reconstructor::VisitPush(size_t x, size_t y, size_t t, list<array<size_t, 3>>& front, Bool3D& not_visited)
-    {
-        if (x > not_visited.size() - 1)
-            return;
-        else if (y > not_visited.at(x).size() - 1)
-            return;
-        else if (t > not_visited.at(x)[y].size() - 1)
-            return;
-        else if (not_visited.at(x)[y][t])
-            front.push_back({x, y, t});
-        not_visited[x][y][t] = false;
+        // If none of the triggering cells are near the shower-detector plane, there is nothing left to reconstruct.
+        if (!any_kept)
+        {
+            data.Subset(data.GetFalseMatrix());
+            return false;
+        }
+        labeler.Mark(keep, good_pixels);
+        data.Subset(good_pixels);
+        return true;
     }
 
     void Reconstructor::FindPlaneSubset(const PhotonCount& data, Bool3D& triggered) const
     {
-        TRotation to_sd_plane = FitSDPlane(data, &triggered);
+        Mat3 to_sd_plane = FitSDPlane(data, &triggered);
         PhotonCount::Iterator iter = data.GetIterator();
         while (iter.Next())
         {
@@ -370,9 +407,9 @@ namespace cherenkov_simulator
         }
     }
 
-    bool Reconstructor::NearPlane(TRotation to_plane, TVector3 direction) const
+    bool Reconstructor::NearPlane(Mat3 to_plane, Vec3 direction) const
     {
-        TVector3 dir_rotated = to_plane * direction;
+        Vec3 dir_rotated = to_plane * direction;
         double angle = ASin(dir_rotated.Z() / dir_rotated.Mag());
         return Abs(angle) < plane_thresh;
     }
@@ -384,28 +421,40 @@ namespace cherenkov_simulator
         return false;
     }
 
-    Bool3D Reconstructor::GetThresholdMatrices(const PhotonCount& data, double sigma_mult, bool use_below_horiz) const
+    shared_ptr<const Int2D> Reconstructor::GetThresholds(const PhotonCount& data, double sigma_mult,
+                                                         bool use_below_horiz) const
     {
-        int gnd_thresh = data.FindThreshold(gnd_noise, sigma_mult);
-        int sky_thresh = data.FindThreshold(sky_noise, sigma_mult);
-        Bool3D pass = data.GetFalseMatrix();
-        PhotonCount::Iterator iter = data.GetIterator();
-        while (iter.Next())
+        // The pixels enter through their number and field of view, and the time bins through the per-bin noise means.
+        static KeyedCache<Int2D> cache;
+        Vec3 normal = ground_plane.Normal();
+        vector<double> key = {(double) data.Size(), data.DetectorAxisAngle(), data.RealNoiseRate(gnd_noise),
+                              data.RealNoiseRate(sky_noise), sigma_mult, (double) use_below_horiz, normal.X(),
+                              normal.Y(), normal.Z(), ground_plane.Coefficient(), rot_to_world.XX(), rot_to_world.XY(),
+                              rot_to_world.XZ(), rot_to_world.YX(), rot_to_world.YY(), rot_to_world.YZ(),
+                              rot_to_world.ZX(), rot_to_world.ZY(), rot_to_world.ZZ()};
+        return cache.Get(key, [&]()
         {
-            bool toward_ground = ground_plane.InFrontOf(rot_to_world * data.Direction(iter));
-            if (toward_ground && !use_below_horiz) continue;
-            pass[iter.X()][iter.Y()] = data.AboveThreshold(iter, toward_ground ? gnd_thresh : sky_thresh);
-        }
-        return pass;
+            int gnd_thresh = data.FindThreshold(gnd_noise, sigma_mult);
+            int sky_thresh = data.FindThreshold(sky_noise, sigma_mult);
+            Int2D thresholds = Int2D(data.Size(), Int1D(data.Size(), numeric_limits<int>::max()));
+            PhotonCount::Iterator iter = data.GetIterator();
+            while (iter.Next())
+            {
+                bool toward_ground = ground_plane.InFrontOf(rot_to_world * data.Direction(iter));
+                if (toward_ground && !use_below_horiz) continue;
+                thresholds[iter.X()][iter.Y()] = toward_ground ? gnd_thresh : sky_thresh;
+            }
+            return thresholds;
+        });
     }
 
-    Shower Reconstructor::MakeShower(double t_0, double r_p, double psi, TRotation to_sdp)
+    Shower Reconstructor::MakeShower(double t_0, double r_p, double psi, Mat3 to_sdp)
     {
         // Remember that to_sdp goes from the world frame.
-        TVector3 shower_direction = to_sdp.Inverse() * TVector3(Cos(psi), -Sin(psi), 0);
+        Vec3 shower_direction = to_sdp.Inverse() * Vec3(Cos(psi), -Sin(psi), 0);
         if (shower_direction.Z() > 0.0) shower_direction = -shower_direction;
-        TVector3 plane_normal = to_sdp.Inverse() * TVector3(0, 0, 1);
-        TVector3 impact_direction = plane_normal.Cross(shower_direction);
+        Vec3 plane_normal = to_sdp.Inverse() * Vec3(0, 0, 1);
+        Vec3 impact_direction = plane_normal.Cross(shower_direction);
         return Shower(1.0, 1.0, r_p * impact_direction, shower_direction, t_0);
     }
 }
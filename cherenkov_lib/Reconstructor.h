@@ -7,15 +7,16 @@
 #ifndef RECONSTRUCTOR_H
 #define RECONSTRUCTOR_H
 
-#include <array>
-#include <queue>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include <boost/property_tree/ptree.hpp>
-#include <TGraphErrors.h>
-#include <TMatrixDSym.h>
-#include <TRotation.h>
 
+#include "Clustering.h"
 #include "DataStructures.h"
 #include "Geometric.h"
+#include "ProfileFitter.h"
+#include "Trigger.h"
 #include "Utility.h"
 
 namespace cherenkov_simulator
@@ -37,6 +38,8 @@ namespace cherenkov_simulator
             bool chkv_tried;
             Shower mono_recon;
             Shower chkv_recon;
+            FitResult mono_fit;
+            FitResult chkv_fit;
 
             /*
              * The default constructor.
@@ -54,34 +57,78 @@ namespace cherenkov_simulator
             std::string ToString(Plane ground_plane) const;
         };
 
+        /*
+         * The parts of a cleaned event which are needed to reconstruct it, so that the time profile fits of many events
+         * can be done together after their PhotonCounts are gone.
+         */
+        struct FitInput
+        {
+            bool triggered;
+            Mat3 to_sdp;
+            FitPoints points;
+            double axis_angle;
+            bool impact_found;
+            Vec3 impact;
+        };
+
         /*
          * Constructs the Reconstructor from values in the configuration tree.
          */
         explicit Reconstructor(const boost::property_tree::ptree& config);
 
         /*
-         * Performs both a monocular and Cherenkov reconstruction, storing output in a Result data structure. If the
+         * Performs both a monocular and Cherenkov reconstruction of data which has had its noise cleared, storing
+         * output in a Result data structure. The trigger decision is the value returned by ClearNoise(), and if the
          * detector was not triggered, Result.triggered = false. If there was not visible impact point,
-         * Result.cherenkov = false.
+         * Result.cherenkov = false. Reconstructed showers are given in the world frame.
+         */
+        Result Reconstruct(const PhotonCount& data, bool triggered) const;
+
+        /*
+         * Finds the shower-detector plane, the fit points, and the ground impact of data which has had its noise
+         * cleared, as Reconstruct() would. Nothing is found unless triggered, the value returned by ClearNoise(), is
+         * true.
+         */
+        FitInput PrepareFits(const PhotonCount& data, bool triggered) const;
+
+        /*
+         * Reconstructs many events from their FitInputs. The monocular fits of all triggered events are done in one
+         * ProfileFitter::FitBatch() call, followed by the hybrid fits of the events whose ground impact is in view.
+         * Each result is identical to the result of Reconstruct() on the event's data.
          */
-        Result Reconstruct(const PhotonCount& data) const;
+        std::vector<Result> ReconstructBatch(const std::vector<FitInput>& inputs) const;
 
         /*
-         * Adds Poisson-distributed background noise to the signal.
+         * Adds Poisson-distributed background noise to the signal. If noise banks are enabled in the config, noise is
+         * read from a bank for each pixel class, which is generated the first time it is needed.
          */
         void AddNoise(PhotonCount& data) const;
 
         /*
          * Attempts to isolate signal from noise by subtracting the background level, applying triggering, removing
-         * anything below three sigma, and performing a recursive search from triggered pixels.
+         * anything below three sigma, and keeping the clusters which contain triggered pixels. Returns whether the
+         * detector triggered, which is the only time the trigger is evaluated. Returns false if no frame was
+         * triggered or no triggering pixel is near the shower-detector plane, in which case all of the signal is
+         * removed and the shower can be dropped.
+         */
+        bool ClearNoise(PhotonCount& data) const;
+
+        /*
+         * Makes this Reconstructor use the noise banks of another, so that a bank generated by either is reused by
+         * both. Banks are only reused when their per-bin mean and size match the configuration.
          */
-        void ClearNoise(PhotonCount& data) const;
+        void ShareNoiseBanks(const Reconstructor& other);
 
     private:
 
-        // Parameters relating to the position and orientation of the detector relative to its surroundings - cgs
+        friend class KernelBench;
+        friend class Station;
+
+        // Parameters relating to the position and orientation of the detector relative to its surroundings - cgs. The
+        // ground plane is stored relative to the detector, which sits at site_posn in the world frame.
+        Vec3 site_posn;
         Plane ground_plane;
-        TRotation rot_to_world;
+        Mat3 rot_to_world;
 
         // Detector-specific levels of night sky background noise - cgs, sr
         double sky_noise;
@@ -93,71 +140,91 @@ namespace cherenkov_simulator
         double impact_buffr;
         double plane_thresh;
         int trigr_clustr;
+        TriggerEngine::Pattern trigr_patrn;
+
+        /*
+         * Noise banks which may be shared between Reconstructors. The mutex guards the list, since banks are added
+         * from const methods.
+         */
+        struct NoiseBankCache
+        {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<NoiseBank>> banks;
+        };
+
+        // Optional banks of pre-generated noise, created on first use for each per-bin noise mean and size
+        bool noise_bank;
+        size_t bank_count;
+        size_t bank_bins;
+        std::shared_ptr<NoiseBankCache> noise_banks;
+
+        /*
+         * Returns the noise bank generated with the specified per-bin mean, generating it if it doesn't exist yet.
+         * This is safe to call from several threads, even when the banks are shared.
+         */
+        const NoiseBank& GetNoiseBank(double mean) const;
 
         /*
          * Performs an ordinary monocular time profile reconstruction of the shower geometry. A ground impact point is
-         * not used.
+         * not used. The raw fit parameters are stored in fit.
          */
-        Shower MonocularFit(const PhotonCount& data, TRotation to_sdp, std::string graph_file = "") const;
+        Shower MonocularFit(const PhotonCount& data, Mat3 to_sdp, FitResult& fit) const;
 
         /*
-         * Performs a time profile reconstruction, but using the constraint of an impact point.
+         * Performs a time profile reconstruction, but using the constraint of an impact point. The raw fit parameters
+         * are stored in fit.
          */
-        Shower HybridFit(const PhotonCount& data, TVector3 impact, TRotation to_sdp, std::string graph_file = "") const;
+        Shower HybridFit(const PhotonCount& data, Vec3 impact, Mat3 to_sdp, FitResult& fit) const;
 
         /*
          * Finds the shower-detector plane based on the distribution of data points. Returns a rotation to a frame in
          * which the shower-detector plane is the xy-plane, with the x-axis lying in the original xy-plane. This
          * rotation is assumed to start world frame, not the detector frame.
          */
-        TRotation FitSDPlane(const PhotonCount& data, const Bool3D* mask = nullptr) const;
+        Mat3 FitSDPlane(const PhotonCount& data, const Bool3D* mask = nullptr) const;
 
         /*
-         * Finds the eigenvector of the symmetric matrix with the smallest eigenvalue.
+         * Fills matrix with the moment tensor of the pixel directions in the detector frame, weighted by the pixel
+         * sums. The normal to the shower-detector plane is the eigenvector with the smallest eigenvalue.
          */
-        TVector3 MinValVec(TMatrixDSym matrix) const;
+        void PlaneMoments(const PhotonCount& data, double matrix[3][3], const Bool3D* mask = nullptr) const;
 
         /*
-         * Attempts to find the reflection point of the shower. If this attempt fails, false is returned. Otherwise,
-         * true is returned. We assume at this point that filters and triggering have been applied. The condition is
-         * that some pixel below the horizon must have seen a total number of photons above the triggering threshold.
+         * Returns the rotation to the shower-detector frame with the specified plane normal, as described for
+         * FitSDPlane().
          */
-        bool FindGroundImpact(const PhotonCount& data, TVector3& impact) const;
+        static Mat3 MakeSDPFrame(Vec3 normal);
 
         /*
-         * Constructs a TGraphErrors from fitting using the data contained in the PhotonCount object.
+         * Attempts to find the reflection point of the shower. If this attempt fails, false is returned. Otherwise,
+         * true is returned. We assume at this point that filters and triggering have been applied. The condition is
+         * that some pixel below the horizon must have seen a total number of photons above the triggering threshold.
          */
-        TGraphErrors GetFitGraph(const PhotonCount& data, TRotation to_sdp) const;
+        bool FindGroundImpact(const PhotonCount& data, Vec3& impact) const;
 
         /*
-         * Subtracts the average amount of noise from each pixel.
+         * Collects the angle within the shower-detector plane, average time, and time error of each pixel above the
+         * horizon with a nonzero signal. Points are sorted by angle. Analysis::MakeFitGraph() plots them.
          */
-        void SubtractAverageNoise(PhotonCount& data) const;
+        FitPoints GetFitPoints(const PhotonCount& data, Mat3 to_sdp) const;
 
         /*
-         * Apply triggering logic to the signal. Look for consecutive groups of pixels in each time bin which have
-         * signals above some threshold. Also, eliminate any noise which is below some lower threshold. Return true if
-         * any frames were triggered.
+         * Returns the points sorted by angle, keeping the original order of equal angles.
          */
-        Bool1D GetTriggeringState(const PhotonCount& data) const;
+        static FitPoints SortFitPoints(const FitPoints& unsorted);
 
         /*
-         * Visits all spatially adjacent pixels to the (x, y, t) point passed, pushing them to the queue. They are also
-         * marked as visited in the not_visited structure.
+         * Subtracts the average amount of noise from each pixel.
          */
-        static void VisitSpaceAdj(size_t x, size_t y, size_t t, std::list<std::array<size_t, 3>>& front, Bool3D& not_visited);
-
-        /*
-         * Visits all spatially adjacent temporally to the (x, y, t) point passed, pushing them to the queue. They are
-         * also marked as visited in the not_visited structure.
-        */
-        static void VisitTimeAdj(size_t x, size_t y, size_t t, std::list<std::array<size_t, 3>>& front, Bool3D& not_visited);
+        void SubtractAverageNoise(PhotonCount& data) const;
 
         /*
-         * Pushes the specified (x, y, z) point to the queue, first checking that the point lies within appropriate
-         * bounds and has not yet been visited. not_visited[x][y][t] is set to false.
+         * Apply triggering logic to the signal. Frames of pixels above the triggering threshold are streamed through
+         * a TriggerEngine, which looks for the configured pattern of trigr_clustr pixels. The frames are built from
+         * PhotonCount::CellsAbove(), so quiet frames are pushed empty without scanning their pixels. Returns true for
+         * each triggered frame.
          */
-        static void VisitPush(size_t x, size_t y, size_t t, std::list<std::array<size_t, 3>>& front, Bool3D& not_visited);
+        Bool1D GetTriggeringState(const PhotonCount& data) const;
 
         /*
          * Modify the set of triggered pixels/times to contain the subset of triggered pixels/times which are within
@@ -169,7 +236,7 @@ namespace cherenkov_simulator
          * Determines whether the input direction is near enough to the plane. The maximum angular deviation from the
          * plane is defined in the config.
          */
-        bool NearPlane(TRotation to_plane, TVector3 direction) const;
+        bool NearPlane(Mat3 to_plane, Vec3 direction) const;
 
         /*
          * Determines whether the detector was triggered by iterating through trig_state and determining if there are
@@ -178,15 +245,18 @@ namespace cherenkov_simulator
         bool DetectorTriggered(const Bool1D& trig_state) const;
 
         /*
-         * Returns a 2D array of arrays, each of which contains true values for tubes above the specified multiple of
-         * sigma, and false values for all those below.
+         * Returns the count threshold of each pixel for the specified multiple of sigma. If use_below_horiz is false,
+         * pixels below the horizon get a threshold which can never be exceeded. The thresholds only depend on the
+         * pixels and time bins of the data, the noise levels, and the orientation of the detector to the ground, so
+         * they're computed once for each combination of these and shared by every Reconstructor.
          */
-        Bool3D GetThresholdMatrices(const PhotonCount& data, double sigma_mult, bool use_below_horiz = true) const;
+        std::shared_ptr<const Int2D> GetThresholds(const PhotonCount& data, double sigma_mult,
+                                                   bool use_below_horiz = true) const;
 
         /*
          * Constructs a shower based on the results of the time profile reconstruction.
          */
-        static Shower MakeShower(double t_0, double r_p, double psi, TRotation to_sdp);
+        static Shower MakeShower(double t_0, double r_p, double psi, Mat3 to_sdp);
     };
 }
 
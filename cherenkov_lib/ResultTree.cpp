@@ -0,0 +1,145 @@
+// ResultTree.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of ResultTree.h
+
+#include <stdexcept>
+#include <TDirectory.h>
+#include <TMath.h>
+
+#include "ResultTree.h"
+
+using namespace std;
+using namespace TMath;
+
+namespace cherenkov_simulator
+{
+    ResultTree::ResultTree(Plane ground_plane) : ground_plane(ground_plane)
+    {
+        tree = new TTree("results", "Monte Carlo results");
+        source = nullptr;
+        MakeBranches(*tree, true);
+    }
+
+    ResultTree::ResultTree(Plane ground_plane, uint64_t keep_rows) : ground_plane(ground_plane)
+    {
+        // Rows past keep_rows may have been saved after the last checkpoint, so only the rows before them are copied.
+        TTree* saved = gDirectory->Get<TTree>("results");
+        if (saved == nullptr) throw runtime_error("No saved results tree to resume");
+        if ((uint64_t) saved->GetEntries() < keep_rows) throw runtime_error("The saved results tree is too short");
+        tree = saved->CloneTree((Long64_t) keep_rows);
+        delete saved;
+
+        // The clone is attached to the directory under the same name, so detach it while the saved cycles are deleted.
+        TDirectory* directory = gDirectory;
+        tree->SetDirectory(nullptr);
+        directory->Delete("results;*");
+        tree->SetDirectory(directory);
+        source = nullptr;
+        MakeBranches(*tree, false);
+    }
+
+    ResultTree::~ResultTree()
+    {
+        delete tree;
+    }
+
+    void ResultTree::Fill(unsigned int seed, uint64_t id, uint64_t attempt, double weight, const Shower& shower,
+                          const Reconstructor::Result& result)
+    {
+        this->seed = seed;
+        this->id = id;
+        this->attempt = attempt;
+        this->weight = weight;
+        energy = shower.EnergyeV();
+        SetRecon(shower, truth);
+
+        trig = result.triggered;
+        mono = Recon();
+        mono_chi2 = result.mono_fit.chi2;
+        mono_conv = result.mono_fit.converged;
+        if (trig) SetRecon(result.mono_recon, mono);
+
+        chkv = result.chkv_tried;
+        chkv_recon = Recon();
+        chkv_chi2 = result.chkv_fit.chi2;
+        chkv_conv = result.chkv_fit.converged;
+        if (chkv) SetRecon(result.chkv_recon, chkv_recon);
+        tree->Fill();
+    }
+
+    void ResultTree::Append(TTree& source, uint64_t row, uint64_t new_id)
+    {
+        if (&source != this->source)
+        {
+            MakeBranches(source, false);
+            this->source = &source;
+        }
+        source.GetEntry((Long64_t) row);
+        id = new_id;
+        tree->Fill();
+    }
+
+    uint64_t ResultTree::NRows() const
+    {
+        return (uint64_t) tree->GetEntries();
+    }
+
+    void ResultTree::Save()
+    {
+        tree->AutoSave("FlushBaskets SaveSelf");
+    }
+
+    void ResultTree::Write()
+    {
+        tree->Write(nullptr, TObject::kOverwrite);
+    }
+
+    void ResultTree::MakeBranches(TTree& target, bool create)
+    {
+        MakeBranch(target, create, "seed", &seed, "/i");
+        MakeBranch(target, create, "id", &id, "/l");
+        MakeBranch(target, create, "attempt", &attempt, "/l");
+        MakeBranch(target, create, "weight", &weight, "/D");
+        MakeBranch(target, create, "energy", &energy, "/D");
+        MakeBranches(target, create, "", truth);
+        MakeBranch(target, create, "trig", &trig, "/O");
+        MakeBranches(target, create, "mono_", mono);
+        MakeBranch(target, create, "mono_chi2", &mono_chi2, "/D");
+        MakeBranch(target, create, "mono_conv", &mono_conv, "/O");
+        MakeBranch(target, create, "chkv", &chkv, "/O");
+        MakeBranches(target, create, "chkv_", chkv_recon);
+        MakeBranch(target, create, "chkv_chi2", &chkv_chi2, "/D");
+        MakeBranch(target, create, "chkv_conv", &chkv_conv, "/O");
+    }
+
+    void ResultTree::MakeBranches(TTree& target, bool create, string prefix, Recon& recon)
+    {
+        MakeBranch(target, create, prefix + "psi", &recon.psi, "/D");
+        MakeBranch(target, create, prefix + "im", &recon.im, "/D");
+        MakeBranch(target, create, prefix + "gnd", &recon.gnd, "/D");
+        MakeBranch(target, create, prefix + "dir", recon.dir, "[3]/D");
+        MakeBranch(target, create, prefix + "impact", recon.impact, "[3]/D");
+        MakeBranch(target, create, prefix + "t0", &recon.t0, "/D");
+    }
+
+    void ResultTree::MakeBranch(TTree& target, bool create, string name, void* address, string type)
+    {
+        if (create) target.Branch(name.c_str(), address, (name + type).c_str());
+        else target.SetBranchAddress(name.c_str(), address);
+    }
+
+    void ResultTree::SetRecon(const Shower& shower, Recon& recon) const
+    {
+        Vec3 impact = shower.PlaneImpact(ground_plane);
+        recon.psi = shower.ImpactAngle() * 180.0 / Pi();
+        recon.im = shower.ImpactParam() / 1e5;
+        recon.gnd = impact.Mag() / 1e5;
+        shower.Direction().GetXYZ(recon.dir);
+        impact.GetXYZ(recon.impact);
+
+        // The shower reaches its point of closest approach after travelling back along the axis from the origin.
+        recon.t0 = shower.Time() - shower.Position().Dot(shower.Direction()) / c_cent;
+    }
+}
@@ -0,0 +1,140 @@
+// ResultTree.h
+//
+// Author: Matthew Dutson
+//
+// Definition of ResultTree class
+
+#ifndef RESULT_TREE_H
+#define RESULT_TREE_H
+
+#include <cstdint>
+#include <TTree.h>
+
+#include "Geometric.h"
+#include "Reconstructor.h"
+
+namespace cherenkov_simulator
+{
+    /*
+     * A columnar store of Monte Carlo results, written as a ROOT TTree named "results" with one branch per field. The
+     * scalar branches have the same names and units as the CSV columns (angles in degrees, distances in km), so
+     * expressions written against the CSV also work against the tree. The remaining branches hold full-precision
+     * vectors in cgs units: dir and impact (the shower direction and ground impact point), t0 (the time at the point
+     * of closest approach), chi2 and conv (the fit's chi-squared and convergence flag). The monocular and Cherenkov
+     * reconstructions use the same names with "mono_" and "chkv_" prefixes. The attempt branch holds the shower's
+     * position in the random stream of the run, and the weight branch holds its importance sampling weight, which
+     * can be passed as the selection of TTree::Draw() to make weighted histograms.
+     */
+    class ResultTree
+    {
+    public:
+
+        /*
+         * Creates an empty tree in the current ROOT directory. A file should be opened before this is called, and the
+         * ResultTree should be destroyed before the file is closed.
+         */
+        explicit ResultTree(Plane ground_plane);
+
+        /*
+         * Continues the tree already saved in the current ROOT directory, keeping only its first keep_rows rows. Throws
+         * a runtime_error if there is no tree or it has fewer rows.
+         */
+        ResultTree(Plane ground_plane, uint64_t keep_rows);
+
+        /*
+         * Deletes the in-memory tree. Rows which haven't been saved with Save() or Write() are lost.
+         */
+        ~ResultTree();
+
+        ResultTree(const ResultTree&) = delete;
+
+        ResultTree& operator=(const ResultTree&) = delete;
+
+        /*
+         * Adds a row for a shower and the result of its reconstruction. Reconstructed fields are zero if the
+         * corresponding reconstruction wasn't performed.
+         */
+        void Fill(unsigned int seed, uint64_t id, uint64_t attempt, double weight, const Shower& shower,
+                  const Reconstructor::Result& result);
+
+        /*
+         * Appends a copy of a row of another results tree, such as one from a different shard of the run, with its ID
+         * replaced. The branches of the source tree are pointed at this tree's buffers.
+         */
+        void Append(TTree& source, uint64_t row, uint64_t new_id);
+
+        /*
+         * Returns the number of rows in the tree.
+         */
+        uint64_t NRows() const;
+
+        /*
+         * Saves the tree and the directory it belongs to, so that the rows so far can be recovered if the program is
+         * killed before Write() is called.
+         */
+        void Save();
+
+        /*
+         * Writes the tree to the directory it was created in.
+         */
+        void Write();
+
+    private:
+
+        /*
+         * The buffers for a single reconstructed shower. Branch addresses point into these.
+         */
+        struct Recon
+        {
+            double psi;
+            double im;
+            double gnd;
+            double dir[3];
+            double impact[3];
+            double t0;
+        };
+
+        Plane ground_plane;
+        TTree* tree;
+        TTree* source;
+
+        UInt_t seed;
+        ULong64_t id;
+        ULong64_t attempt;
+        double weight;
+        double energy;
+        Recon truth;
+        Bool_t trig;
+        Recon mono;
+        double mono_chi2;
+        Bool_t mono_conv;
+        Bool_t chkv;
+        Recon chkv_recon;
+        double chkv_chi2;
+        Bool_t chkv_conv;
+
+        /*
+         * Creates the branches of the target tree if create is true. Otherwise, points the existing branches of the
+         * target at the buffers.
+         */
+        void MakeBranches(TTree& target, bool create);
+
+        /*
+         * Creates or connects the branches for a reconstructed shower, with names starting with the prefix.
+         */
+        static void MakeBranches(TTree& target, bool create, std::string prefix, Recon& recon);
+
+        /*
+         * Creates a single branch whose leaf has the branch's name followed by the type suffix (such as "/D" or
+         * "[3]/D"), or points the existing branch at the address.
+         */
+        static void MakeBranch(TTree& target, bool create, std::string name, void* address, std::string type);
+
+        /*
+         * Copies the parameters of the shower into the buffers.
+         */
+        void SetRecon(const Shower& shower, Recon& recon) const;
+    };
+}
+
+#endif
@@ -0,0 +1,141 @@
+// ShardMerger.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of ShardMerger.h
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <vector>
+#include <TFile.h>
+#include <TKey.h>
+#include <TTree.h>
+
+#include "ResultTree.h"
+#include "ShardMerger.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+    string ShardMerger::ShardName(string output_file, unsigned int shard)
+    {
+        return output_file + "_shard" + to_string(shard);
+    }
+
+    void ShardMerger::Merge(string output_file, unsigned int n_shards)
+    {
+        if (n_shards == 0) throw runtime_error("There are no shards to merge");
+
+        // Read the CSV rows of each shard, and the stream position of each row from its result tree.
+        vector<unique_ptr<TFile>> files = vector<unique_ptr<TFile>>();
+        vector<TTree*> trees = vector<TTree*>();
+        vector<vector<string>> lines = vector<vector<string>>(n_shards);
+        vector<Row> rows = vector<Row>();
+        string header;
+        UInt_t run_seed = 0;
+        for (unsigned int shard = 0; shard < n_shards; shard++)
+        {
+            string name = ShardName(output_file, shard);
+            files.emplace_back(TFile::Open((name + ".root").c_str()));
+            if (!files.back() || files.back()->IsZombie()) throw runtime_error("Could not open " + name + ".root");
+            TTree* tree = files.back()->Get<TTree>("results");
+            if (tree == nullptr) throw runtime_error(name + ".root has no results tree");
+            trees.push_back(tree);
+
+            ifstream csv = ifstream(name + ".csv");
+            if (!csv) throw runtime_error("Could not open " + name + ".csv");
+            string shard_header;
+            getline(csv, shard_header);
+            if (shard == 0) header = shard_header;
+            else if (shard_header != header) throw runtime_error(name + ".csv has a different header from shard 0");
+            string line;
+            while (getline(csv, line))
+                if (!line.empty()) lines[shard].push_back(line);
+            if (lines[shard].size() != (size_t) tree->GetEntries())
+                throw runtime_error(name + ".csv and " + name + ".root have different numbers of rows");
+
+            // Shards only make up a single run if they all draw from the stream of the same seed.
+            UInt_t seed;
+            ULong64_t attempt, id;
+            tree->SetBranchAddress("seed", &seed);
+            tree->SetBranchAddress("attempt", &attempt);
+            tree->SetBranchAddress("id", &id);
+            for (uint64_t row = 0; row < lines[shard].size(); row++)
+            {
+                tree->GetEntry((Long64_t) row);
+                if (rows.empty()) run_seed = seed;
+                if (seed != run_seed) throw runtime_error(name + " has a different seed from the other shards");
+                const string& csv_line = lines[shard][row];
+                size_t id_bgn = csv_line.find(',') + 1;
+                size_t id_end = csv_line.find(',', id_bgn);
+                if (id_bgn == 0 || csv_line.substr(0, id_bgn - 1) != to_string(seed) ||
+                    csv_line.substr(id_bgn, id_end - id_bgn) != to_string(id))
+                    throw runtime_error(name + ".csv and " + name + ".root have different rows");
+                rows.push_back({attempt, shard, row, id});
+            }
+            tree->ResetBranchAddresses();
+        }
+        sort(rows.begin(), rows.end(), [](const Row& a, const Row& b)
+        {
+            return a.attempt < b.attempt || (a.attempt == b.attempt && a.shard < b.shard);
+        });
+
+        // Write the rows in stream order with global IDs, which replace the second CSV field.
+        TFile output((output_file + ".root").c_str(), "RECREATE");
+        ofstream csv = ofstream(output_file + ".csv");
+        csv << header << "\n";
+        vector<map<uint64_t, uint64_t>> global_ids = vector<map<uint64_t, uint64_t>>(n_shards);
+        {
+            ResultTree results((Plane()));
+            for (uint64_t i = 0; i < rows.size(); i++)
+            {
+                const Row& row = rows[i];
+                uint64_t global_id = i + 1;
+                global_ids[row.shard][row.local_id] = global_id;
+                const string& line = lines[row.shard][row.row];
+                size_t id_bgn = line.find(',') + 1;
+                size_t id_end = line.find(',', id_bgn);
+                csv << line.substr(0, id_bgn) << global_id << line.substr(id_end) << "\n";
+                results.Append(*trees[row.shard], row.row, global_id);
+            }
+            output.cd();
+            results.Write();
+        }
+
+        // Copy the latest cycle of each diagnostic product. Keys are listed with the latest cycle first.
+        for (unsigned int shard = 0; shard < n_shards; shard++)
+        {
+            set<string> copied = set<string>();
+            TIter next(files[shard]->GetListOfKeys());
+            while (TKey* key = (TKey*) next())
+            {
+                uint64_t local_id;
+                string suffix;
+                if (!ParseProductName(key->GetName(), local_id, suffix) || !copied.insert(key->GetName()).second)
+                    continue;
+                auto global_id = global_ids[shard].find(local_id);
+                if (global_id == global_ids[shard].end()) continue;
+                unique_ptr<TObject> object = unique_ptr<TObject>(key->ReadObj());
+                output.cd();
+                object->Write((to_string(global_id->second) + suffix).c_str(), TObject::kOverwrite);
+            }
+        }
+    }
+
+    bool ShardMerger::ParseProductName(string name, uint64_t& local_id, string& suffix)
+    {
+        size_t split = name.find('_');
+        if (split == 0 || split == string::npos) return false;
+        for (size_t i = 0; i < split; i++)
+            if (!isdigit(name[i])) return false;
+        local_id = stoull(name.substr(0, split));
+        suffix = name.substr(split);
+        return true;
+    }
+}
@@ -0,0 +1,59 @@
+// ShardMerger.h
+//
+// Author: Matthew Dutson
+//
+// Definition of ShardMerger class
+
+#ifndef SHARD_MERGER_H
+#define SHARD_MERGER_H
+
+#include <cstdint>
+#include <string>
+
+namespace cherenkov_simulator
+{
+    /*
+     * Combines the outputs of a sharded Monte Carlo run. Each shard is a separate process which simulates the
+     * positions in the shower stream equal to its index modulo the number of shards, and numbers its showers from one.
+     * The merged output looks like the output of a single process: rows are ordered by their position in the stream
+     * and numbered from one.
+     */
+    class ShardMerger
+    {
+    public:
+
+        /*
+         * Returns the name of the outputs of a shard of a run, without an extension.
+         */
+        static std::string ShardName(std::string output_file, unsigned int shard);
+
+        /*
+         * Merges the CSV files, result trees, and diagnostic products of n_shards shards into output_file.csv and
+         * output_file.root. Diagnostic products are renamed with the global ID of their shower. Event files are not
+         * merged. Throws a runtime_error if the outputs of a shard are missing, if its CSV file and result tree have
+         * different rows, or if its CSV header or seed differs from that of the first shard.
+         */
+        static void Merge(std::string output_file, unsigned int n_shards);
+
+    private:
+
+        /*
+         * The location of a row in the outputs of a shard.
+         */
+        struct Row
+        {
+            uint64_t attempt;
+            unsigned int shard;
+            uint64_t row;
+            uint64_t local_id;
+        };
+
+        /*
+         * Returns true if the name starts with a shower ID followed by an underscore, in which case the ID and the rest
+         * of the name, starting with the underscore, are stored in local_id and suffix.
+         */
+        static bool ParseProductName(std::string name, uint64_t& local_id, std::string& suffix);
+    };
+}
+
+#endif
@@ -4,13 +4,17 @@
 //
 // Implementation of Simulator.h
 
-#include <TMath.h>
+#include <map>
+#include <tuple>
 
+#include "Numeric.h"
+#include "Profile.h"
+#include "Random.h"
 #include "Simulator.h"
 
 using namespace std;
 using namespace boost::property_tree;
-using namespace TMath;
+using namespace cherenkov_simulator::numeric;
 
 namespace cherenkov_simulator
 {
@@ -21,10 +25,12 @@ namespace cherenkov_simulator
         flor_thin = config.get<int>("simulation.flor_thin");
         chkv_thin = config.get<int>("simulation.chkv_thin");
 
-        TVector3 ground_norm = Utility::ToVector(config.get<string>("surroundings.ground_norm"));
-        TVector3 ground_fixd = Utility::ToVector(config.get<string>("surroundings.ground_fixd"));
+        Vec3 ground_norm = Utility::ToVector(config.get<string>("surroundings.ground_norm"));
+        Vec3 ground_fixd = Utility::ToVector(config.get<string>("surroundings.ground_fixd"));
         ground_plane = Plane(ground_norm, ground_fixd);
-        rot_to_world = Utility::MakeRotation(config.get<double>("surroundings.elevation_angle"));
+        site_posn = Utility::ToVector(config.get<string>("surroundings.site_posn"));
+        rot_to_world = Utility::MakeRotation(config.get<double>("surroundings.elevation_angle"),
+                                             config.get<double>("surroundings.azimuth_angle"));
 
         auto view_rad = config.get<double>("detector.view_rad");
         mirror_radius = config.get<double>("detector.mirror_radius");
@@ -38,38 +44,121 @@ namespace cherenkov_simulator
         count_params.lin_size = pmtclust_size / count_params.n_pixels;
         count_params.ang_size = count_params.lin_size / (mirror_radius / 2.0);
 
-        ckv_integrator = TF1("ckv_integrator", ckv_func, 0.0, Infinity(), 3);
-        ckv_integrator.SetParNames("age", "rho", "del");
+        detector_axis = rot_to_world * Vec3(0, 0, 1);
+        static KeyedCache<TracedOptics> cache;
+        vector<double> key = {mirror_radius, stop_diameter, mainmirr_size, pmtclust_size,
+                              (double) count_params.n_pixels};
+        shared_ptr<const TracedOptics> optics = cache.Get(key, [this]()
+        {
+            MeasurePointSpread();
+            TracedOptics traced = TracedOptics();
+            traced.accept_cos = Cos(AcceptanceAngle());
+            traced.psf_peak = psf_peak;
+            traced.psf_radius = psf_radius;
+            return traced;
+        });
+        accept_cos = optics->accept_cos;
+        psf_peak = optics->psf_peak;
+        psf_radius = optics->psf_radius;
     }
 
     PhotonCount Simulator::SimulateShower(Shower shower) const
     {
-        TF1 integrator = TF1(ckv_integrator);
-
         PhotonCount photon_count = PhotonCount(count_params, MinTime(shower), MaxTime(shower));
         while (shower.TimeToPlane(ground_plane) > 0)
         {
-            shower.IncrementDepth(depth_step);
-            ViewFluorescencePhotons(shower, photon_count);
-            ViewCherenkovPhotons(shower, ground_plane, photon_count, integrator);
+            {
+                PROFILE_STAGE(stepping);
+                shower.IncrementDepth(depth_step);
+            }
+            ViewFluorescencePhotons(shower, photon_count, FluorescenceTotal(shower));
+            ViewCherenkovPhotons(shower, ground_plane, photon_count, CherenkovTotal(shower));
         }
         photon_count.Trim();
         return photon_count;
     }
 
+    double Simulator::PeakSignalToNoise(Shower shower) const
+    {
+        // Cells are keyed by index so that showers with very long arrival windows don't need a dense array. A pixel
+        // collects light from spots centered within psf_radius of it, plus a pixel of margin for the jitter of photons
+        // across their step, so cells of this size put all of those spots in the 2x2 block of cells around it.
+        double min_time = MinTime(shower);
+        double cell_size = 2.0 * (psf_radius + 1.0) + 1.0;
+        Mat3 to_detector = rot_to_world.Inverse();
+        map<tuple<long long, long long, long long>, double> cells;
+        auto add_light = [&](double time, Vec3 view_point, double light)
+        {
+            double x, y;
+            CameraPosition(to_detector * view_point, x, y);
+            auto bin = (long long) Floor((time - min_time) / count_params.bin_size);
+            cells[make_tuple(bin, (long long) Floor(x / cell_size), (long long) Floor(y / cell_size))] += light;
+        };
+
+        // The ground impact of the axis doesn't move, so the Cherenkov integral is only needed if it's in view. The
+        // totals change slowly with depth, so they are evaluated on a coarse grid of steps, and the larger of the
+        // totals at either end of each interval is used across it.
+        int n_coarse = 10;
+        Vec3 ground_impact = shower.PlaneImpact(ground_plane) - site_posn;
+        bool impact_in_view = WithinView(ground_impact);
+        double flor_total = 0.0;
+        double chkv_total = 0.0;
+        for (int step = 0; shower.TimeToPlane(ground_plane) > 0; step++)
+        {
+            shower.IncrementDepth(depth_step);
+            if (step % n_coarse == 0)
+            {
+                Shower ahead = shower;
+                ahead.IncrementDepth(n_coarse * depth_step);
+                flor_total = Max(FluorescenceTotal(shower), FluorescenceTotal(ahead));
+                if (impact_in_view) chkv_total = Max(CherenkovTotal(shower), CherenkovTotal(ahead));
+            }
+            Vec3 position = shower.Position() - site_posn;
+            if (WithinView(position))
+                add_light(shower.Time() + position.Mag() / c_cent, position, FluorescenceYield(shower, flor_total));
+            if (impact_in_view)
+            {
+                double time = shower.Time() + shower.TimeToPlane(ground_plane) + ground_impact.Mag() / c_cent;
+                add_light(time, ground_impact, CherenkovYield(shower, chkv_total));
+            }
+        }
+
+        // Photons are jittered across each step, so light from one step can spill into the following bin. Every block
+        // of two bins and 2x2 cells which holds a nonempty cell is summed.
+        auto light_in = [&](long long bin, long long x, long long y)
+        {
+            auto cell = cells.find(make_tuple(bin, x, y));
+            return cell == cells.end() ? 0.0 : cell->second;
+        };
+        double peak = 0.0;
+        for (const auto& cell : cells)
+        {
+            long long bin = get<0>(cell.first);
+            long long x = get<1>(cell.first);
+            long long y = get<2>(cell.first);
+            for (long long b = bin - 1; b <= bin; b++)
+                for (long long i = x - 1; i <= x; i++)
+                    for (long long j = y - 1; j <= y; j++)
+                    {
+                        double sum = 0.0;
+                        for (long long k = 0; k < 8; k++)
+                            sum += light_in(b + k / 4, i + k / 2 % 2, j + k % 2);
+                        peak = Max(peak, sum);
+                    }
+        }
+
+        double noise_rate = Sq(stop_diameter / 2.0) * Pi() * glob_sky_noise;
+        double noise_mean = noise_rate * Sq(count_params.ang_size) * count_params.bin_size;
+        return psf_peak * peak / Sqrt(noise_mean);
+    }
+
     Plane Simulator::GroundPlane() const
     {
         return ground_plane;
     }
 
-    double Simulator::CherenkovFunc::operator()(double* x, double* p)
+    double Simulator::CherenkovIntegrand(double dep, double age, double rho, double del)
     {
-        // Parameters are named in the simulator constructor.
-        double dep = x[0];
-        double age = p[0];
-        double rho = p[1];
-        double del = p[2];
-
         double k_out = 2 * Pi() * fine_s / rho * (1 / lambda_min - 1 / lambda_max);
         double k_1 = k_out * 2 * del;
         double k_2 = k_out * Sq(mass_e);
@@ -80,80 +169,238 @@ namespace cherenkov_simulator
         return a0 * Exp(dep) / ((a1 + Exp(dep)) * Power(a2 + Exp(dep), age)) * (k_1 - k_2 * Exp(-2.0 * dep));
     }
 
-    void Simulator::ViewFluorescencePhotons(Shower shower, PhotonCount& photon_count) const
+    void Simulator::ViewFluorescencePhotons(Shower shower, PhotonCount& photon_count, double total) const
     {
-        int n_loops = NumberFluorescenceLoops(shower);
+        PROFILE_STAGE(fluorescence);
+        int n_loops = NumberFluorescenceLoops(shower, total);
+        PROFILE_COUNT(flor_photons, n_loops / flor_thin);
         for (int i = 0; i < n_loops / flor_thin; i++)
         {
-            TVector3 lens_impact = rot_to_world * RandomStopImpact();
+            Vec3 lens_impact = site_posn + rot_to_world * RandomStopImpact();
             Ray photon = JitteredRay(shower, lens_impact - shower.Position());
             photon.PropagateToPoint(lens_impact);
             SimulateOptics(photon, photon_count, flor_thin);
         }
     }
 
-    void Simulator::ViewCherenkovPhotons(Shower shower, Plane ground_plane, PhotonCount& photon_count, TF1 integrator) const
+    void Simulator::ViewCherenkovPhotons(Shower shower, Plane ground_plane, PhotonCount& photon_count,
+                                         double total) const
     {
-        int n_loops = NumberCherenkovLoops(shower, integrator);
+        PROFILE_STAGE(cherenkov);
+        int n_loops = NumberCherenkovLoops(shower, total);
+        PROFILE_COUNT(chkv_photons, n_loops);
         for (int i = 0; i < n_loops; i++)
         {
             Ray photon = GenerateCherenkovPhoton(shower);
             photon.PropagateToPlane(ground_plane);
-            TVector3 stop_impact = rot_to_world * RandomStopImpact();
+            Vec3 stop_impact = site_posn + rot_to_world * RandomStopImpact();
             photon.PropagateToPoint(stop_impact);
             SimulateOptics(photon, photon_count, chkv_thin);
         }
     }
 
-    int Simulator::NumberFluorescenceLoops(Shower shower) const
+    int Simulator::NumberFluorescenceLoops(Shower shower, double total) const
+    {
+        return Utility::RandomRound(FluorescenceYield(shower, total) / (double) flor_thin);
+    }
+
+    double Simulator::FluorescenceTotal(Shower shower) const
     {
         double rho = shower.LocalRho();
         double term_1 = fluor_a1 / (1 + fluor_b1 * rho * Sqrt(atm_temp));
         double term_2 = fluor_a2 / (1 + fluor_b2 * rho * Sqrt(atm_temp));
         double yield = IonizationLossRate(shower) / edep_1_4 * (term_1 + term_2);
+        return yield * shower.GaisserHillas() * depth_step;
+    }
 
-        double total = yield * shower.GaisserHillas() * depth_step;
-        double fraction = SphereFraction(shower.Position()) * DetectorEfficiency();
-        return Utility::RandomRound(total * fraction / (double) flor_thin);
+    double Simulator::FluorescenceYield(Shower shower, double total) const
+    {
+        double fraction = SphereFraction(shower.Position() - site_posn) * DetectorEfficiency();
+        return total * fraction;
     }
 
-    int Simulator::NumberCherenkovLoops(Shower shower, TF1 integrator) const
+    int Simulator::NumberCherenkovLoops(Shower shower, double total) const
     {
-        integrator.SetParameter("age", shower.Age());
-        integrator.SetParameter("rho", shower.LocalRho());
-        integrator.SetParameter("del", shower.LocalDelta());
-        double yield = integrator.Integral(Log(shower.EThresh()), Log(shower.EnergyMeV()));
+        return Utility::RandomRound(CherenkovYield(shower, total) / (double) chkv_thin);
+    }
 
-        double total = yield * shower.GaisserHillas() * depth_step;
-        TVector3 ground_impact = shower.PlaneImpact(ground_plane);
+    double Simulator::CherenkovTotal(Shower shower) const
+    {
+        double age = shower.Age();
+        double rho = shower.LocalRho();
+        double del = shower.LocalDelta();
+        double yield = Utility::Integrate([=](double dep) { return CherenkovIntegrand(dep, age, rho, del); },
+                                          Log(shower.EThresh()), Log(shower.EnergyMeV()));
+        return yield * shower.GaisserHillas() * depth_step;
+    }
+
+    double Simulator::CherenkovYield(Shower shower, double total) const
+    {
+        Vec3 ground_impact = shower.PlaneImpact(ground_plane) - site_posn;
         double cos_theta = Abs(Cos(ground_impact.Angle(ground_plane.Normal())));
         double fraction = 4.0 * SphereFraction(ground_impact) * cos_theta * DetectorEfficiency();
-        return Utility::RandomRound(total * fraction / (double) chkv_thin);
+        return total * fraction;
+    }
+
+    bool Simulator::WithinView(Vec3 view_point) const
+    {
+        Vec3 detector_axis = rot_to_world * Vec3(0, 0, 1);
+        double half_angle = ASin(pmtclust_size / mirror_radius) + count_params.ang_size;
+        return detector_axis.Angle(view_point) < half_angle;
+    }
+
+    void Simulator::CameraPosition(Vec3 direction, double& x, double& y) const
+    {
+        double elevate = ATan2(direction.Y(), direction.Z());
+        double azimuth = ATan2(direction.X(), direction.Z());
+        x = azimuth / count_params.ang_size / Cos(elevate);
+        y = elevate / count_params.ang_size;
+    }
+
+    void Simulator::MeasurePointSpread()
+    {
+        // Every grid point on the stop carries the same share of the light, including points whose rays are lost.
+        int n_grid = 24;
+        int n_angles = 5;
+        int n_shifts = 4;
+        double max_angle = ASin(pmtclust_size / mirror_radius);
+        psf_peak = 0.0;
+        psf_radius = 0.0;
+        for (int a = 0; a < n_angles; a++)
+        {
+            double angle = max_angle * a / (n_angles - 1);
+            Vec3 source = Vec3(Sin(angle), 0, Cos(angle));
+            double source_x, source_y;
+            CameraPosition(source, source_x, source_y);
+            vector<double> offset_x = vector<double>();
+            vector<double> offset_y = vector<double>();
+            int n_rays = 0;
+            for (int i = 0; i < n_grid; i++)
+            {
+                for (int j = 0; j < n_grid; j++)
+                {
+                    Vec3 stop_impact = Vec3(((i + 0.5) / n_grid - 0.5) * stop_diameter,
+                                            ((j + 0.5) / n_grid - 0.5) * stop_diameter, 0);
+                    if (!Utility::WithinXYDisk(stop_impact, stop_diameter / 2.0)) continue;
+                    n_rays++;
+                    Ray photon = Ray(stop_impact, -source, 0);
+                    Vec3 camera_impact;
+                    if (!TraceOptics(photon, camera_impact)) continue;
+                    double x, y;
+                    CameraPosition(-camera_impact, x, y);
+                    offset_x.push_back(x - source_x);
+                    offset_y.push_back(y - source_y);
+                    psf_radius = Max(psf_radius, Sqrt(Sq(x - source_x) + Sq(y - source_y)));
+                }
+            }
+            for (int i = 0; i < n_shifts * n_shifts; i++)
+            {
+                map<pair<long long, long long>, int> pixels;
+                for (size_t k = 0; k < offset_x.size(); k++)
+                {
+                    auto pixel_x = (long long) Floor(offset_x[k] + (double) (i / n_shifts) / n_shifts);
+                    auto pixel_y = (long long) Floor(offset_y[k] + (double) (i % n_shifts) / n_shifts);
+                    pixels[make_pair(pixel_x, pixel_y)]++;
+                }
+                for (const auto& pixel : pixels) psf_peak = Max(psf_peak, pixel.second / (double) n_rays);
+            }
+        }
     }
 
     void Simulator::SimulateOptics(Ray photon, PhotonCount& photon_count, int thinning) const
     {
+        PROFILE_STAGE(optics);
+        if (-photon.Direction().Dot(detector_axis) < accept_cos)
+        {
+            PROFILE_COUNT(cone_culled, 1);
+            photon_count.TallyPhoton(false);
+            return;
+        }
+
+        photon.Translate(-site_posn);
         photon.Transform(rot_to_world.Inverse());
-        if (!DeflectFromLens(photon)) return;
+        Vec3 camera_impact;
+        if (!TraceOptics(photon, camera_impact)) return;
+        photon_count.AddPhoton(photon.Time(), camera_impact, thinning);
+        photon_count.TallyPhoton(true);
+        PROFILE_COUNT(accepted, 1);
+    }
 
-        TVector3 camera_impact;
-        if (CameraImpactPoint(photon, camera_impact)) return;
+    bool Simulator::TraceOptics(Ray& photon, Vec3& camera_impact) const
+    {
+        if (!DeflectFromLens(photon))
+        {
+            PROFILE_COUNT(lens_missed, 1);
+            return false;
+        }
 
-        TVector3 reflect_point;
-        if (!MirrorImpactPoint(photon, reflect_point)) return;
+        if (CameraImpactPoint(photon, camera_impact))
+        {
+            PROFILE_COUNT(camera_shadow, 1);
+            return false;
+        }
+
+        Vec3 reflect_point;
+        if (!MirrorImpactPoint(photon, reflect_point))
+        {
+            PROFILE_COUNT(mirror_missed, 1);
+            return false;
+        }
         photon.PropagateToPoint(reflect_point);
         photon.Reflect(MirrorNormal(reflect_point));
 
-        if (!CameraImpactPoint(photon, camera_impact)) return;
+        if (!CameraImpactPoint(photon, camera_impact))
+        {
+            PROFILE_COUNT(camera_missed, 1);
+            return false;
+        }
         photon.PropagateToPoint(camera_impact);
-        photon_count.AddPhoton(photon.Time(), camera_impact, thinning);
+        return true;
+    }
+
+    double Simulator::AcceptanceAngle() const
+    {
+        // A coarse scan down from the horizon finds the first angle where some ray is accepted, then a fine scan down
+        // from the last rejected angle refines it. Two fine steps are added as a margin for the gaps in the grid.
+        double coarse_step = 0.01;
+        double fine_step = count_params.ang_size / 4.0;
+        double angle = PiOver2();
+        while (angle > 0.0 && !AnyAccepted(angle))
+            angle -= coarse_step;
+        if (angle <= 0.0) return PiOver2();
+        angle = Min(angle + coarse_step, PiOver2());
+        while (!AnyAccepted(angle))
+            angle -= fine_step;
+        return angle + 2.0 * fine_step;
+    }
+
+    bool Simulator::AnyAccepted(double angle) const
+    {
+        // The optics are symmetric about the detector axis, so only directions in the x-z plane need to be checked.
+        // The widest angles are accepted just inside the uncorrected center of the lens, so its edge is on the grid.
+        int n_radii = 8;
+        int n_phis = 24;
+        Vec3 direction = Vec3(Sin(angle), 0, -Cos(angle));
+        for (int i = 0; i <= n_radii + 1; i++)
+        {
+            double radius = stop_diameter / 2.0 * i / n_radii;
+            if (i > n_radii) radius = stop_diameter / (2.0 * Sqrt(2)) * (1.0 - 1e-9);
+            for (int j = 0; j < n_phis; j++)
+            {
+                double phi = TwoPi() * j / n_phis;
+                Ray photon = Ray(Vec3(radius * Cos(phi), radius * Sin(phi), 0), direction, 0);
+                Vec3 camera_impact;
+                if (TraceOptics(photon, camera_impact)) return true;
+            }
+        }
+        return false;
     }
 
-    TVector3 Simulator::RandomStopImpact() const
+    Vec3 Simulator::RandomStopImpact() const
     {
         double r_rand = Utility::RandLinear(0.0, stop_diameter / 2.0);
-        double phi_rand = gRandom->Uniform(TwoPi());
-        return TVector3(r_rand * Cos(phi_rand), r_rand * Sin(phi_rand), 0);
+        double phi_rand = Random::Shared().Uniform(TwoPi());
+        return Vec3(r_rand * Cos(phi_rand), r_rand * Sin(phi_rand), 0);
     }
 
     bool Simulator::DeflectFromLens(Ray& photon) const
@@ -165,23 +412,23 @@ namespace cherenkov_simulator
             return photon.Direction().Z() < 0;
 
         double z_norm = (ref_lens - 1) * Power(mirror_radius, 3) / (Sq(x) + Sq(y));
-        TVector3 norm = TVector3(-x, -y, z_norm).Unit();
+        Vec3 norm = Vec3(-x, -y, z_norm).Unit();
         bool success = photon.Refract(norm, 1, ref_lens);
-        return success && photon.Refract(TVector3(0, 0, 1), ref_lens, 1);
+        return success && photon.Refract(Vec3(0, 0, 1), ref_lens, 1);
     }
 
-    bool Simulator::MirrorImpactPoint(Ray ray, TVector3& point) const
+    bool Simulator::MirrorImpactPoint(Ray ray, Vec3& point) const
     {
         NegSphereImpact(move(ray), point, mirror_radius);
         return Utility::WithinXYDisk(point, mainmirr_size / 2.0) && point.Z() < 0.0;
     }
 
-    TVector3 Simulator::MirrorNormal(TVector3 point) const
+    Vec3 Simulator::MirrorNormal(Vec3 point) const
     {
         return -point.Unit();
     }
 
-    bool Simulator::CameraImpactPoint(Ray ray, TVector3& point) const
+    bool Simulator::CameraImpactPoint(Ray ray, Vec3& point) const
     {
         NegSphereImpact(move(ray), point, mirror_radius / 2.0);
         return Utility::WithinXYDisk(point, pmtclust_size / 2.0) && point.Z() < 0;
@@ -193,9 +440,9 @@ namespace cherenkov_simulator
         return ion_c1 / Power(ion_c2 + age, ion_c3) + ion_c4 + ion_c5 * age;
     }
 
-    double Simulator::SphereFraction(TVector3 view_point) const
+    double Simulator::SphereFraction(Vec3 view_point) const
     {
-        TVector3 detector_axis = rot_to_world * TVector3(0, 0, 1);
+        Vec3 detector_axis = rot_to_world * Vec3(0, 0, 1);
         double cosine = Cos(detector_axis.Angle(view_point));
         cosine = cosine < 0.0 ? 0.0 : cosine;
         double area_fraction = Sq(stop_diameter / 2.0) / (4.0 * view_point.Mag2());
@@ -209,9 +456,9 @@ namespace cherenkov_simulator
 
     Ray Simulator::GenerateCherenkovPhoton(Shower shower) const
     {
-        TVector3 direction = shower.Direction();
-        TVector3 rotation_axis = Utility::RandNormal(shower.Velocity().Unit());
-        direction.Rotate(gRandom->Exp(ThetaC(shower)), rotation_axis);
+        Vec3 direction = shower.Direction();
+        Vec3 rotation_axis = Utility::RandNormal(shower.Velocity().Unit());
+        direction.Rotate(Random::Shared().Exp(ThetaC(shower)), rotation_axis);
         return JitteredRay(shower, direction);
     }
 
@@ -220,19 +467,19 @@ namespace cherenkov_simulator
         return chkv_k1 * Power(shower.EThresh(), chkv_k2);
     }
 
-    Ray Simulator::JitteredRay(Shower shower, TVector3 direction) const
+    Ray Simulator::JitteredRay(Shower shower, Vec3 direction) const
     {
         double step_time = depth_step / shower.LocalRho() / c_cent;
-        double offset = gRandom->Uniform(-0.5 * step_time, 0.5 * step_time);
+        double offset = Random::Shared().Uniform(-0.5 * step_time, 0.5 * step_time);
         double time = shower.Time() + offset;
-        TVector3 position = shower.Position() + shower.Velocity() * offset;
+        Vec3 position = shower.Position() + shower.Velocity() * offset;
         return Ray(position, direction, time);
     }
 
     double Simulator::MinTime(Shower shower) const
     {
         double time = shower.Time();
-        time += shower.Position().Mag() / c_cent;
+        time += (shower.Position() - site_posn).Mag() / c_cent;
         return time;
     }
 
@@ -240,11 +487,11 @@ namespace cherenkov_simulator
     {
         double time = shower.Time();
         time += shower.TimeToPlane(ground_plane);
-        time += shower.PlaneImpact(ground_plane).Mag() * back_toler / c_cent;
+        time += (shower.PlaneImpact(ground_plane) - site_posn).Mag() * back_toler / c_cent;
         return time;
     }
 
-    bool Simulator::NegSphereImpact(Ray ray, TVector3& point, double radius)
+    bool Simulator::NegSphereImpact(Ray ray, Vec3& point, double radius)
     {
         double a = ray.Velocity().Mag2();
         double b = 2 * ray.Position().Dot(ray.Velocity());
@@ -253,15 +500,15 @@ namespace cherenkov_simulator
         double b4ac = Sq(b) - 4 * a * c;
         if (b4ac < 0)
         {
-            point = TVector3();
+            point = Vec3();
             return false;
         }
         else
         {
             double root1 = (-b + Sqrt(b4ac)) / (2 * a);
             double root2 = (-b - Sqrt(b4ac)) / (2 * a);
-            TVector3 point1 = ray.Position() + root1 * ray.Velocity();
-            TVector3 point2 = ray.Position() + root2 * ray.Velocity();
+            Vec3 point1 = ray.Position() + root1 * ray.Velocity();
+            Vec3 point2 = ray.Position() + root2 * ray.Velocity();
             point = point1.Z() < point2.Z() ? point1 : point2;
             return true;
         }
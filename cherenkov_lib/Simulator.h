@@ -8,9 +8,6 @@
 #define SIMULATOR_H
 
 #include <boost/property_tree/ptree.hpp>
-#include <TF1.h>
-#include <TRandom3.h>
-#include <TRotation.h>
 
 #include "DataStructures.h"
 #include "Geometric.h"
@@ -37,6 +34,19 @@ namespace cherenkov_simulator
          */
         PhotonCount SimulateShower(Shower shower) const;
 
+        /*
+         * Estimates the peak per-pixel signal-to-noise ratio of a shower without ray tracing any photons. The expected
+         * number of detected photons is found at each depth step and binned by arrival time and by the camera cell
+         * its spot is centered in. Cells are wide enough that a pixel only collects light from spots centered in the
+         * 2x2 block of cells around it, and it collects at most psf_peak of each spot, so the brightest block bounds
+         * the expected count in the brightest pixel. Light from outside the field of view is dropped. The shower's
+         * photon totals are only evaluated every ten steps, taking the larger at either end of each interval, and the
+         * Cherenkov integral is skipped if the ground impact is out of view. The result is divided by the standard
+         * deviation of the sky noise in one pixel and time bin. No random numbers are drawn, so calling this doesn't
+         * change the result of SimulateShower().
+         */
+        double PeakSignalToNoise(Shower shower) const;
+
         /*
          * Returns a copy of the ground plane.
          */
@@ -45,20 +55,10 @@ namespace cherenkov_simulator
 
     private:
 
-        /*
-         * Represents the integrand of the Cherenkov yield.
-         */
-        class CherenkovFunc
-        {
-        public:
-
-            /*
-             * Defined as required by TF1.Integral(). Returns the value of the integrand. Allows for a computation of
-             * the integral over the electron energy spectrum (see Nerling).
-             * p[0] = age, p[1] = rho, p[2] = delta
-             */
-            double operator()(double* x, double* p);
-        };
+        friend class KernelBench;
+        friend class SampleEvents;
+        friend class Station;
+        friend class Stereo;
 
         // Parameters related to the behavior of the simulation (cgs)
         int flor_thin;
@@ -66,13 +66,31 @@ namespace cherenkov_simulator
         double back_toler;
         double depth_step;
 
-        // Miscellaneous non-constant parameters
+        // Miscellaneous non-constant parameters. The detector sits at site_posn in the world frame.
         Plane ground_plane;
-        TRotation rot_to_world;
-        CherenkovFunc ckv_func;
-        TF1 ckv_integrator;
+        Vec3 site_posn;
+        Mat3 rot_to_world;
+        Vec3 detector_axis;
+        double accept_cos;
         PhotonCount::Params count_params;
 
+        // The point spread function of the optics, from MeasurePointSpread(). psf_peak is the largest fraction of the
+        // light reaching the stop from one direction which lands in a single pixel, and psf_radius is the furthest
+        // any of that light lands from the nominal position of the direction, in pixels.
+        double psf_peak;
+        double psf_radius;
+
+        /*
+         * The results of tracing the optics when a Simulator is constructed. These only depend on the geometry of the
+         * optics and the number of pixels, so they're traced once for each detector and shared by every Simulator.
+         */
+        struct TracedOptics
+        {
+            double accept_cos;
+            double psf_peak;
+            double psf_radius;
+        };
+
         // Setup of the detector (cgs)
         double mirror_radius;
         double stop_diameter;
@@ -80,41 +98,117 @@ namespace cherenkov_simulator
         double pmtclust_size;
 
         /*
-         * Simulate the production and detection of the fluorescence photons.
+         * Simulate the production and detection of the fluorescence photons. The total is the number of photons
+         * emitted over the depth step, from FluorescenceTotal().
          */
-        void ViewFluorescencePhotons(Shower shower, PhotonCount& photon_count) const;
+        void ViewFluorescencePhotons(Shower shower, PhotonCount& photon_count, double total) const;
 
         /*
          * Simulate the production and detection of the Cherenkov photons. Only Cherenkov photons reflected from the
-         * ground are recorded (no back scattering).
+         * ground are recorded (no back scattering). The total is the number of photons reaching the ground from the
+         * depth step, from CherenkovTotal().
          */
-        void ViewCherenkovPhotons(Shower shower, Plane ground_plane, PhotonCount& photon_count, TF1 integrator) const;
+        void ViewCherenkovPhotons(Shower shower, Plane ground_plane, PhotonCount& photon_count, double total) const;
 
         /*
          * Determines the total number of Fluorescence photons produced by the shower at a particular point.
          */
-        int NumberFluorescenceLoops(Shower shower) const;
+        int NumberFluorescenceLoops(Shower shower, double total) const;
+
+        /*
+         * Returns the number of fluorescence photons emitted in all directions over the shower's current depth step.
+         * This doesn't depend on the detector, so it can be shared between sites.
+         */
+        double FluorescenceTotal(Shower shower) const;
+
+        /*
+         * Returns the expected number of fluorescence photons from the shower's current depth step which reach the
+         * stop and are detected, before thinning.
+         */
+        double FluorescenceYield(Shower shower, double total) const;
 
         /*
          * Determines the total number of Cherenkov photons produced by the shower at a particular point. This doesn't
          * need the distance traveled because the form for Cherenkov yield gives the number of photons per electron per
          * slant depth.
          */
-        int NumberCherenkovLoops(Shower shower, TF1 integrator) const;
+        int NumberCherenkovLoops(Shower shower, double total) const;
+
+        /*
+         * Returns the number of Cherenkov photons from the shower's current depth step which reach the ground. This
+         * requires an integral over the electron energy spectrum, and doesn't depend on the detector, so it can be
+         * shared between sites.
+         */
+        double CherenkovTotal(Shower shower) const;
+
+        /*
+         * Returns the expected number of Cherenkov photons from the shower's current depth step which are reflected
+         * from the ground, reach the stop, and are detected, before thinning.
+         */
+        double CherenkovYield(Shower shower, double total) const;
+
+        /*
+         * Returns the Cherenkov yield per electron per slant depth, per unit of the logarithm of the electron energy
+         * dep (in MeV), for a shower of the specified age in air of the specified density and refractivity. The yield
+         * of a depth step is found by integrating this over the electron energy spectrum (see Nerling).
+         */
+        static double CherenkovIntegrand(double dep, double age, double rho, double del);
+
+        /*
+         * Returns true if light arriving from the specified point, relative to the detector, could land on the camera.
+         * A margin of one pixel is added to the half-angle of the field of view.
+         */
+        bool WithinView(Vec3 view_point) const;
+
+        /*
+         * Finds the nominal position on the camera of light arriving from the specified direction in the detector
+         * frame, in pixels from the center of the camera. This is the mapping used by PhotonCount::AddPhoton(), which
+         * is passed the camera impact point, the negative of the direction.
+         */
+        void CameraPosition(Vec3 direction, double& x, double& y) const;
+
+        /*
+         * Sets psf_peak and psf_radius by tracing rays from a fixed grid of points over the stop, arriving from
+         * directions across the field of view. Each spot is shifted across a pixel in quarter-pixel steps to find the
+         * most light a single pixel can collect. No random numbers are drawn.
+         */
+        void MeasurePointSpread();
 
         /*
          * Takes a photon which is assumed to lie at the corrector plate and simulates its motion through the detector
          * optics. If the photon is somehow blocked or doesn't reach the photomultiplier array, no change to the photon
          * count structure is made. Otherwise, the appropriate bin of the photon counter is incremented. Takes a
          * parameter which represents the rate of computational thinning. This is passed to the photon count container
-         * to allow it to increment bins by the correct amount.
+         * to allow it to increment bins by the correct amount. Photons culled by the acceptance cone and photons which
+         * reach the camera are added to the count's tallies.
          */
         void SimulateOptics(Ray photon, PhotonCount& photon_count, int thinning) const;
 
+        /*
+         * Traces a photon in detector coordinates from the corrector plate to the camera, leaving it at the camera
+         * impact point. Returns false if the photon is lost at the lens, in the shadow of the camera, at the edge of
+         * the mirror, or off the edge of the camera.
+         */
+        bool TraceOptics(Ray& photon, Vec3& camera_impact) const;
+
+        /*
+         * Finds the largest angle between an incoming photon and the detector axis at which the photon can reach the
+         * camera, by tracing a grid of rays over the stop. SimulateOptics() drops photons outside this cone with a
+         * single dot product before rotating or tracing them. The margin makes the cull conservative, so it changes
+         * the speed of the simulation but not its results.
+         */
+        double AcceptanceAngle() const;
+
+        /*
+         * Returns true if any ray on a grid of points over the stop, arriving at the specified angle to the detector
+         * axis, reaches the camera.
+         */
+        bool AnyAccepted(double angle) const;
+
         /*
          * Generates a random point on the circle of the refracting lens.
          */
-        TVector3 RandomStopImpact() const;
+        Vec3 RandomStopImpact() const;
 
         /*
          * Refracts a ray across the Schmidt corrector. The Schmidt corrector is assumed to have zero thickness.
@@ -125,20 +219,20 @@ namespace cherenkov_simulator
          * Takes a ray which has just been refracted by the corrector. Finds the point on the mirror where that ray will
          * reflect. If the ray misses the mirror, false is returned.
          */
-        bool MirrorImpactPoint(Ray ray, TVector3& point) const;
+        bool MirrorImpactPoint(Ray ray, Vec3& point) const;
 
         /*
          * Returns the normal vector at some point on the mirror. Behavior is undefined if the passed point is not on or
          * near the mirror.
          */
-        TVector3 MirrorNormal(TVector3 point) const;
+        Vec3 MirrorNormal(Vec3 point) const;
 
         /*
          * Finds the point where some ray will impact the photomultiplier surface. This can be used both to check
          * whether photons are blocked by the photomultipliers and to find where they are detected after being reflected
          * by the mirror. Returns false if the ray will not hit the photomultiplier array.
          */
-        bool CameraImpactPoint(Ray ray, TVector3& point) const;
+        bool CameraImpactPoint(Ray ray, Vec3& point) const;
 
         /*
          * Calculates the effective ionization loss rate for a shower (alpha_eff).
@@ -146,10 +240,10 @@ namespace cherenkov_simulator
         double IonizationLossRate(Shower shower) const;
 
         /*
-         * Calculates how large, as a fraction of a sphere, the detector stop appears from some point. This accounts
-         * both for the inverse square dependance and the orientation of the detector.
+         * Calculates how large, as a fraction of a sphere, the detector stop appears from some point relative to the
+         * detector. This accounts both for the inverse square dependance and the orientation of the detector.
          */
-        double SphereFraction(TVector3 view_point) const;
+        double SphereFraction(Vec3 view_point) const;
 
         /*
          * Returns the product of the quantum efficiency, filter transmittance, and mirror reflectance.
@@ -170,7 +264,7 @@ namespace cherenkov_simulator
         /*
          * Generates a time which is randomly offset from the shower time.
          */
-        Ray JitteredRay(Shower shower, TVector3 direction) const;
+        Ray JitteredRay(Shower shower, Vec3 direction) const;
 
         /*
          * Determines the time when we want to start recording photons for the shower. This is calculated by taking the
@@ -191,7 +285,7 @@ namespace cherenkov_simulator
          * to the intersection with the smallest (negative) z-coordinate and "true" is returned. The intersection is
          * found by solving for the roots of a quadratic polynomial.
          */
-        static bool NegSphereImpact(Ray ray, TVector3& point, double radius);
+        static bool NegSphereImpact(Ray ray, Vec3& point, double radius);
     };
 }
 
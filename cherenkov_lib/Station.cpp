@@ -0,0 +1,221 @@
+// Station.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of Station.h
+
+#include <stdexcept>
+
+#include "Numeric.h"
+#include "Profile.h"
+#include "Station.h"
+
+using namespace std;
+using namespace boost::property_tree;
+using namespace cherenkov_simulator::numeric;
+
+namespace cherenkov_simulator
+{
+    Station::Station(const ptree& config)
+    {
+        index_bins = config.get<size_t>("station.index_bins");
+        route_margin = config.get<double>("station.route_margin");
+        if (index_bins < 1) throw invalid_argument("The angular index must have at least one bin");
+        vector<string> elevs = Utility::SplitList(config.get<string>("station.unit_elevs"));
+        vector<string> azims = Utility::SplitList(config.get<string>("station.unit_azims"));
+        if (elevs.empty() || elevs.size() != azims.size())
+            throw invalid_argument("Each mirror unit must have an elevation angle and an azimuth angle");
+
+        site_posn = Utility::ToVector(config.get<string>("surroundings.site_posn"));
+        vector<double> route_angles = vector<double>();
+        for (size_t i = 0; i < elevs.size(); i++)
+        {
+            ptree unit_config = config;
+            unit_config.put("surroundings.elevation_angle", elevs[i]);
+            unit_config.put("surroundings.azimuth_angle", azims[i]);
+            simulators.push_back(Simulator(unit_config));
+            reconstructors.push_back(Reconstructor(unit_config));
+            reconstructors.back().ShareNoiseBanks(reconstructors.front());
+
+            // Light from outside the acceptance cone can't reach the camera, so it doesn't need to be routed.
+            route_angles.push_back(ACos(simulators.back().accept_cos) + route_margin);
+            route_cos.push_back(route_angles.back() < Pi() ? Cos(route_angles.back()) : -Infinity());
+            unit_axes.push_back(simulators.back().detector_axis);
+        }
+
+        // A cell lists a unit if the unit's cone reaches within the cell's angular radius of the cell's center.
+        double cell_radius = Pi() / index_bins;
+        index = vector<vector<size_t>>(2 * index_bins * index_bins);
+        for (size_t cell = 0; cell < index.size(); cell++)
+        {
+            Vec3 center = CellCenter(cell);
+            for (size_t i = 0; i < unit_axes.size(); i++)
+                if (center.Angle(unit_axes[i]) < route_angles[i] + cell_radius) index[cell].push_back(i);
+        }
+    }
+
+    size_t Station::NUnits() const
+    {
+        return simulators.size();
+    }
+
+    Plane Station::GroundPlane() const
+    {
+        return simulators.front().GroundPlane();
+    }
+
+    vector<PhotonCount> Station::SimulateShower(Shower shower) const
+    {
+        // Bins are only allocated for a unit once some light is routed to it.
+        const Simulator& primary = simulators.front();
+        double min_time = primary.MinTime(shower);
+        double max_time = primary.MaxTime(shower);
+        vector<PhotonCount> counts = vector<PhotonCount>(simulators.size());
+        vector<bool> started = vector<bool>(simulators.size(), false);
+        auto unit_count = [&](size_t i) -> PhotonCount&
+        {
+            if (!started[i]) counts[i] = PhotonCount(primary.count_params, min_time, max_time);
+            started[i] = true;
+            return counts[i];
+        };
+
+        // The units differ only in orientation, so the photon totals of the first unit apply to all of them. The
+        // totals are skipped entirely for steps which no unit can see.
+        vector<size_t> flor_units = vector<size_t>();
+        vector<size_t> chkv_units = vector<size_t>();
+        while (shower.TimeToPlane(primary.ground_plane) > 0)
+        {
+            {
+                PROFILE_STAGE(stepping);
+                shower.IncrementDepth(primary.depth_step);
+                Route(shower.Position() - site_posn, flor_units);
+                Route(shower.PlaneImpact(primary.ground_plane) - site_posn, chkv_units);
+            }
+            double flor_total = flor_units.empty() ? 0.0 : primary.FluorescenceTotal(shower);
+            double chkv_total = chkv_units.empty() ? 0.0 : primary.CherenkovTotal(shower);
+
+            for (size_t i : flor_units)
+                simulators[i].ViewFluorescencePhotons(shower, unit_count(i), flor_total);
+            for (size_t i : chkv_units)
+                simulators[i].ViewCherenkovPhotons(shower, primary.ground_plane, unit_count(i), chkv_total);
+        }
+        for (size_t i = 0; i < counts.size(); i++)
+            if (started[i]) counts[i].Trim();
+        return counts;
+    }
+
+    double Station::PeakSignalToNoise(Shower shower) const
+    {
+        double peak = 0.0;
+        for (const Simulator& simulator : simulators) peak = Max(peak, simulator.PeakSignalToNoise(shower));
+        return peak;
+    }
+
+    Reconstructor::Result Station::Reconstruct(vector<PhotonCount>& data) const
+    {
+        if (data.size() != reconstructors.size()) throw invalid_argument("There must be one PhotonCount for each unit");
+        vector<size_t> triggered = vector<size_t>();
+        for (size_t i = 0; i < data.size(); i++)
+        {
+            if (data[i].Empty()) continue;
+            const Reconstructor& unit = reconstructors[i];
+            unit.AddNoise(data[i]);
+            if (unit.ClearNoise(data[i])) triggered.push_back(i);
+        }
+        Reconstructor::Result result = Reconstructor::Result();
+        if (triggered.empty()) return result;
+        result.triggered = true;
+
+        // The moment tensors of the units are rotated to the world frame and summed. With one triggered unit this is
+        // the same as the monocular fit.
+        Mat3 to_sdp;
+        if (triggered.size() == 1) to_sdp = reconstructors[triggered[0]].FitSDPlane(data[triggered[0]]);
+        else
+        {
+            Mat3 total = Mat3(Vec3(), Vec3(), Vec3());
+            for (size_t i : triggered)
+            {
+                double matrix[3][3];
+                reconstructors[i].PlaneMoments(data[i], matrix);
+                Mat3 local = Mat3(Vec3(matrix[0][0], matrix[0][1], matrix[0][2]),
+                                  Vec3(matrix[1][0], matrix[1][1], matrix[1][2]),
+                                  Vec3(matrix[2][0], matrix[2][1], matrix[2][2]));
+                const Mat3& rotation = reconstructors[i].rot_to_world;
+                Mat3 world = rotation * local * rotation.Inverse();
+                total.row_x += world.row_x;
+                total.row_y += world.row_y;
+                total.row_z += world.row_z;
+            }
+            double matrix[3][3] = {{total.XX(), total.XY(), total.XZ()},
+                                   {total.YX(), total.YY(), total.YZ()},
+                                   {total.ZX(), total.ZY(), total.ZZ()}};
+            to_sdp = Reconstructor::MakeSDPFrame(Utility::MinEigenvector(matrix));
+        }
+
+        // Angles within the shower-detector plane are measured in the world frame, so the points of all units can be
+        // fit together.
+        FitPoints unsorted = FitPoints();
+        for (size_t i : triggered)
+        {
+            FitPoints points = reconstructors[i].GetFitPoints(data[i], to_sdp);
+            unsorted.angles.insert(unsorted.angles.end(), points.angles.begin(), points.angles.end());
+            unsorted.times.insert(unsorted.times.end(), points.times.begin(), points.times.end());
+            unsorted.time_err.insert(unsorted.time_err.end(), points.time_err.begin(), points.time_err.end());
+        }
+        FitPoints points = Reconstructor::SortFitPoints(unsorted);
+        {
+            PROFILE_STAGE(fits);
+            result.mono_fit = ProfileFitter::FitMonocular(points);
+        }
+        result.mono_recon = Reconstructor::MakeShower(result.mono_fit.t_0, result.mono_fit.r_p, result.mono_fit.psi,
+                                                      to_sdp);
+
+        // The Cherenkov reconstruction uses the first triggered unit which sees the expected ground impact.
+        for (size_t i : triggered)
+        {
+            const Reconstructor& unit = reconstructors[i];
+            Vec3 direction = unit.rot_to_world.Inverse() * result.mono_recon.PlaneImpact(unit.ground_plane);
+            if (direction.Theta() >= data[i].DetectorAxisAngle() - unit.impact_buffr) continue;
+            Vec3 impact;
+            if (unit.FindGroundImpact(data[i], impact))
+            {
+                PROFILE_STAGE(fits);
+                double impact_distance = impact.Mag();
+                result.chkv_fit = ProfileFitter::FitHybrid(points, impact_distance, (to_sdp * impact).Phi());
+                double r_p = impact_distance * Sin(result.chkv_fit.psi);
+                result.chkv_recon = Reconstructor::MakeShower(result.chkv_fit.t_0, r_p, result.chkv_fit.psi, to_sdp);
+                result.chkv_tried = true;
+            }
+            break;
+        }
+        result.mono_recon.Translate(site_posn);
+        result.chkv_recon.Translate(site_posn);
+        return result;
+    }
+
+    void Station::Route(Vec3 direction, vector<size_t>& units) const
+    {
+        units.clear();
+        Vec3 unit_direction = direction.Unit();
+        for (size_t i : index[CellIndex(direction)])
+            if (unit_direction.Dot(unit_axes[i]) > route_cos[i]) units.push_back(i);
+    }
+
+    size_t Station::CellIndex(Vec3 direction) const
+    {
+        double bin_size = Pi() / index_bins;
+        auto elev_bin = (size_t) Max(Floor((ATan2(direction.Z(), direction.Perp()) + PiOver2()) / bin_size), 0.0);
+        auto azim_bin = (size_t) Max(Floor((direction.Phi() + Pi()) / bin_size), 0.0);
+        elev_bin = Min(elev_bin, index_bins - 1);
+        azim_bin = Min(azim_bin, 2 * index_bins - 1);
+        return elev_bin * 2 * index_bins + azim_bin;
+    }
+
+    Vec3 Station::CellCenter(size_t cell) const
+    {
+        double bin_size = Pi() / index_bins;
+        double elev = -PiOver2() + (cell / (2 * index_bins) + 0.5) * bin_size;
+        double azim = -Pi() + (cell % (2 * index_bins) + 0.5) * bin_size;
+        return Vec3(Cos(elev) * Cos(azim), Cos(elev) * Sin(azim), Sin(elev));
+    }
+}
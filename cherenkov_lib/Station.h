@@ -0,0 +1,100 @@
+// Station.h
+//
+// Author: Matthew Dutson
+//
+// Definition of Station class
+
+#ifndef STATION_H
+#define STATION_H
+
+#include <vector>
+#include <boost/property_tree/ptree.hpp>
+
+#include "DataStructures.h"
+#include "Geometric.h"
+#include "Reconstructor.h"
+#include "Simulator.h"
+
+namespace cherenkov_simulator
+{
+    /*
+     * A detector site with several mirror units, each with its own orientation and camera. The units share the site
+     * position in the surroundings section of the configuration, and their elevation and azimuth angles are listed in
+     * the station section. Light from each shower step is only simulated for the units which can see it, so adding
+     * units which don't see a shower doesn't add to its cost.
+     */
+    class Station
+    {
+    public:
+
+        /*
+         * Constructs a Simulator and Reconstructor for each unit, and builds the angular index used to route light to
+         * the units. An invalid_argument exception is thrown if the lists of units are empty or have different
+         * lengths.
+         */
+        explicit Station(const boost::property_tree::ptree& config);
+
+        /*
+         * Returns the number of mirror units.
+         */
+        size_t NUnits() const;
+
+        /*
+         * Returns the ground plane in the world frame.
+         */
+        Plane GroundPlane() const;
+
+        /*
+         * Simulates the shower, returning the noise-free photon counts of each unit. Units which weren't routed any
+         * light are left as empty default PhotonCounts, without allocating their bins.
+         */
+        std::vector<PhotonCount> SimulateShower(Shower shower) const;
+
+        /*
+         * Returns the largest Simulator::PeakSignalToNoise() of any unit.
+         */
+        double PeakSignalToNoise(Shower shower) const;
+
+        /*
+         * Adds noise to and clears noise from the data of each unit, modifying it in place. The station is triggered
+         * if any unit is triggered. The shower-detector plane and the time profile are then fit to the pixels of every
+         * triggered unit together, and the Cherenkov reconstruction uses the unit which sees the ground impact of the
+         * monocular fit.
+         */
+        Reconstructor::Result Reconstruct(std::vector<PhotonCount>& data) const;
+
+    private:
+
+        friend class StationTest;
+
+        // The angular index divides directions from the site into cells of equal azimuth and elevation, each listing
+        // the units which might see some direction in the cell.
+        size_t index_bins;
+        double route_margin;
+        std::vector<std::vector<size_t>> index;
+
+        Vec3 site_posn;
+        std::vector<Vec3> unit_axes;
+        std::vector<double> route_cos;
+        std::vector<Simulator> simulators;
+        std::vector<Reconstructor> reconstructors;
+
+        /*
+         * Fills units with the units whose acceptance cone, widened by route_margin, contains the direction from the
+         * site.
+         */
+        void Route(Vec3 direction, std::vector<size_t>& units) const;
+
+        /*
+         * Returns the index cell which contains the direction.
+         */
+        size_t CellIndex(Vec3 direction) const;
+
+        /*
+         * Returns the direction at the center of an index cell.
+         */
+        Vec3 CellCenter(size_t cell) const;
+    };
+}
+
+#endif
@@ -0,0 +1,172 @@
+// Stereo.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of Stereo.h
+
+#include <stdexcept>
+
+#include "Numeric.h"
+#include "Profile.h"
+#include "Stereo.h"
+
+using namespace std;
+using namespace boost::property_tree;
+using namespace cherenkov_simulator::numeric;
+
+namespace cherenkov_simulator
+{
+    Stereo::Result::Result()
+    {
+        reconstructed = false;
+        open_angle = 0.0;
+    }
+
+    string Stereo::Result::Header(size_t n_sites)
+    {
+        string header;
+        for (size_t i = 0; i < n_sites; i++) header += Reconstructor::Result::Header() + ",";
+        return header + "Stereo," + Shower::Header() + ",Opening(deg)";
+    }
+
+    string Stereo::Result::ToString(Plane ground_plane) const
+    {
+        string result;
+        for (const Reconstructor::Result& site : sites) result += site.ToString(ground_plane) + ",";
+        if (reconstructed)
+            result += "1," + stereo_recon.ToString(ground_plane) + "," + to_string(open_angle * 180.0 / Pi());
+        else result += "0,0,0,0,0";
+        return result;
+    }
+
+    Stereo::Stereo(const ptree& config)
+    {
+        min_angle = config.get<double>("stereo.min_angle");
+        vector<string> posns = Utility::SplitList(config.get<string>("stereo.site_posns"));
+        vector<string> azims = Utility::SplitList(config.get<string>("stereo.site_azims"));
+        if (posns.size() != azims.size())
+            throw invalid_argument("Each additional stereo site must have a position and an azimuth angle");
+
+        // The primary site keeps the surroundings of the configuration.
+        posns.insert(posns.begin(), config.get<string>("surroundings.site_posn"));
+        azims.insert(azims.begin(), config.get<string>("surroundings.azimuth_angle"));
+        for (size_t i = 0; i < posns.size(); i++)
+        {
+            ptree site_config = config;
+            site_config.put("surroundings.site_posn", posns[i]);
+            site_config.put("surroundings.azimuth_angle", azims[i]);
+            site_posns.push_back(Utility::ToVector(posns[i]));
+            simulators.push_back(Simulator(site_config));
+            reconstructors.push_back(Reconstructor(site_config));
+            reconstructors.back().ShareNoiseBanks(reconstructors.front());
+        }
+    }
+
+    size_t Stereo::NSites() const
+    {
+        return simulators.size();
+    }
+
+    Plane Stereo::GroundPlane() const
+    {
+        return simulators.front().GroundPlane();
+    }
+
+    vector<PhotonCount> Stereo::SimulateShower(Shower shower) const
+    {
+        vector<PhotonCount> counts = vector<PhotonCount>();
+        for (const Simulator& simulator : simulators)
+            counts.push_back(PhotonCount(simulator.count_params, simulator.MinTime(shower), simulator.MaxTime(shower)));
+
+        // The sites differ only in position and orientation, so the photon totals of the primary site apply to all.
+        const Simulator& primary = simulators.front();
+        while (shower.TimeToPlane(primary.ground_plane) > 0)
+        {
+            {
+                PROFILE_STAGE(stepping);
+                shower.IncrementDepth(primary.depth_step);
+            }
+            double flor_total = primary.FluorescenceTotal(shower);
+            double chkv_total = primary.CherenkovTotal(shower);
+            for (size_t i = 0; i < simulators.size(); i++)
+            {
+                simulators[i].ViewFluorescencePhotons(shower, counts[i], flor_total);
+                simulators[i].ViewCherenkovPhotons(shower, primary.ground_plane, counts[i], chkv_total);
+            }
+        }
+        for (PhotonCount& count : counts) count.Trim();
+        return counts;
+    }
+
+    double Stereo::PeakSignalToNoise(Shower shower) const
+    {
+        double peak = 0.0;
+        for (const Simulator& simulator : simulators) peak = Max(peak, simulator.PeakSignalToNoise(shower));
+        return peak;
+    }
+
+    Stereo::Result Stereo::Reconstruct(vector<PhotonCount>& data) const
+    {
+        if (data.size() != simulators.size()) throw invalid_argument("There must be one PhotonCount for each site");
+        Result result = Result();
+        for (size_t i = 0; i < data.size(); i++)
+        {
+            Reconstructor::Result site_result = Reconstructor::Result();
+            if (!data[i].Empty())
+            {
+                reconstructors[i].AddNoise(data[i]);
+                if (reconstructors[i].ClearNoise(data[i])) site_result = reconstructors[i].Reconstruct(data[i], true);
+            }
+            result.sites.push_back(site_result);
+        }
+
+        // Planes which are nearly parallel intersect poorly, so the most open pair of planes is used.
+        bool pair_found = false;
+        size_t best_1 = 0;
+        size_t best_2 = 0;
+        for (size_t i = 0; i < data.size(); i++)
+        {
+            if (!result.sites[i].triggered) continue;
+            Vec3 normal_i = PlaneNormal(result.sites[i].mono_recon, site_posns[i]);
+            for (size_t j = i + 1; j < data.size(); j++)
+            {
+                if (!result.sites[j].triggered) continue;
+                double angle = normal_i.Angle(PlaneNormal(result.sites[j].mono_recon, site_posns[j]));
+                angle = Min(angle, Pi() - angle);
+                if (angle <= result.open_angle) continue;
+                result.open_angle = angle;
+                pair_found = true;
+                best_1 = i;
+                best_2 = j;
+            }
+        }
+        if (pair_found && result.open_angle >= min_angle)
+        {
+            result.stereo_recon = IntersectPlanes(result.sites[best_1].mono_recon, site_posns[best_1],
+                                                  result.sites[best_2].mono_recon, site_posns[best_2]);
+            result.reconstructed = true;
+        }
+        return result;
+    }
+
+    Shower Stereo::IntersectPlanes(const Shower& mono_1, Vec3 site_1, const Shower& mono_2, Vec3 site_2) const
+    {
+        Vec3 normal_1 = PlaneNormal(mono_1, site_1);
+        Vec3 normal_2 = PlaneNormal(mono_2, site_2);
+        Vec3 direction = normal_1.Cross(normal_2).Unit();
+        if (direction.Z() > 0.0) direction = -direction;
+
+        // Solve for the point in both planes which is also in the plane through the origin normal to the axis.
+        double height_1 = normal_1.Dot(site_1);
+        double height_2 = normal_2.Dot(site_2);
+        Vec3 point = (normal_2.Cross(direction) * height_1 + direction.Cross(normal_1) * height_2) /
+                     normal_1.Dot(normal_2.Cross(direction));
+        double time = mono_1.Time() + (point - mono_1.Position()).Dot(direction) / c_cent;
+        return Shower(1.0, 1.0, point, direction, time);
+    }
+
+    Vec3 Stereo::PlaneNormal(const Shower& mono_recon, Vec3 site_posn)
+    {
+        return (mono_recon.Position() - site_posn).Cross(mono_recon.Direction()).Unit();
+    }
+}
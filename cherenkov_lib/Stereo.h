@@ -0,0 +1,118 @@
+// Stereo.h
+//
+// Author: Matthew Dutson
+//
+// Definition of Stereo class
+
+#ifndef STEREO_H
+#define STEREO_H
+
+#include <string>
+#include <vector>
+#include <boost/property_tree/ptree.hpp>
+
+#include "DataStructures.h"
+#include "Geometric.h"
+#include "Reconstructor.h"
+#include "Simulator.h"
+
+namespace cherenkov_simulator
+{
+    /*
+     * Simulates and reconstructs showers seen by several detector sites at once. The primary site is the one described
+     * by the surroundings section of the configuration, and the additional sites are listed in the stereo section. The
+     * shower is stepped once, and the photon totals of each step (including the Cherenkov integral) are computed once
+     * and then passed to the optics of every site.
+     */
+    class Stereo
+    {
+    public:
+
+        /*
+         * The results of reconstruction at each site, along with the stereo reconstruction from the pair of triggered
+         * sites whose shower-detector planes are furthest from parallel.
+         */
+        struct Result
+        {
+            std::vector<Reconstructor::Result> sites;
+            bool reconstructed;
+            Shower stereo_recon;
+            double open_angle;
+
+            /*
+             * The default constructor.
+             */
+            Result();
+
+            /*
+             * Creates a header for rows of data created with ToString(), with a Reconstructor::Result header for each
+             * of n_sites sites.
+             */
+            static std::string Header(size_t n_sites);
+
+            /*
+             * Creates a string with comma separated fields, with the opening angle in degrees.
+             */
+            std::string ToString(Plane ground_plane) const;
+        };
+
+        /*
+         * Constructs a Simulator and Reconstructor for each site. Each site uses a copy of the configuration with its
+         * own position and azimuth angle. An invalid_argument exception is thrown if the lists of additional sites
+         * don't have the same length.
+         */
+        explicit Stereo(const boost::property_tree::ptree& config);
+
+        /*
+         * Returns the number of sites, including the primary site.
+         */
+        size_t NSites() const;
+
+        /*
+         * Returns the ground plane in the world frame.
+         */
+        Plane GroundPlane() const;
+
+        /*
+         * Simulates the shower, returning the noise-free photon counts of each site in the order of NSites().
+         */
+        std::vector<PhotonCount> SimulateShower(Shower shower) const;
+
+        /*
+         * Returns the largest Simulator::PeakSignalToNoise() of any site.
+         */
+        double PeakSignalToNoise(Shower shower) const;
+
+        /*
+         * Adds noise to, clears noise from, and reconstructs the data of each site, then intersects the shower-detector
+         * planes of the two triggered sites whose planes are furthest from parallel. The stereo reconstruction is only
+         * made if there are two such sites and the angle between their planes is at least min_angle. The data is
+         * modified in place.
+         */
+        Result Reconstruct(std::vector<PhotonCount>& data) const;
+
+    private:
+
+        friend class StereoTest;
+
+        double min_angle;
+        std::vector<Vec3> site_posns;
+        std::vector<Simulator> simulators;
+        std::vector<Reconstructor> reconstructors;
+
+        /*
+         * Finds the shower axis as the intersection of the shower-detector planes of two sites. The returned shower
+         * passes through the point on the axis closest to the origin, at the time given by the monocular fit of the
+         * first site.
+         */
+        Shower IntersectPlanes(const Shower& mono_1, Vec3 site_1, const Shower& mono_2, Vec3 site_2) const;
+
+        /*
+         * Returns the normal to the shower-detector plane of a site, given the monocular reconstruction in the world
+         * frame.
+         */
+        static Vec3 PlaneNormal(const Shower& mono_recon, Vec3 site_posn);
+    };
+}
+
+#endif
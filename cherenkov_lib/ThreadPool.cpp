@@ -0,0 +1,129 @@
+// ThreadPool.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of ThreadPool.h
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+#include "ThreadPool.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+    ThreadPool::ThreadPool(size_t n_threads)
+    {
+        stop = false;
+        for (size_t i = 1; i < n_threads; i++)
+            workers.emplace_back(&ThreadPool::Work, this);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (thread& worker : workers)
+            worker.join();
+    }
+
+    size_t ThreadPool::Size() const
+    {
+        return workers.size() + 1;
+    }
+
+    void ThreadPool::ParallelFor(size_t n_items, const function<void(size_t, size_t)>& body)
+    {
+        if (n_items == 0) return;
+        if (workers.empty())
+        {
+            body(0, n_items);
+            return;
+        }
+
+        // Use a few chunks per thread so that uneven chunks don't leave threads idle.
+        struct Batch
+        {
+            atomic<size_t> next;
+            size_t n_chunks;
+            size_t n_done;
+            std::mutex mutex;
+            condition_variable finished;
+            exception_ptr error;
+        };
+        shared_ptr<Batch> batch = make_shared<Batch>();
+        batch->next = 0;
+        batch->n_chunks = min(n_items, 4 * Size());
+        batch->n_done = 0;
+
+        // The body is only referenced while a chunk is claimed, and all chunks finish before this method returns.
+        const function<void(size_t, size_t)>* body_ptr = &body;
+        function<void()> drain = [batch, body_ptr, n_items]()
+        {
+            for (size_t chunk = batch->next++; chunk < batch->n_chunks; chunk = batch->next++)
+            {
+                try
+                {
+                    (*body_ptr)(chunk * n_items / batch->n_chunks, (chunk + 1) * n_items / batch->n_chunks);
+                }
+                catch (...)
+                {
+                    lock_guard<std::mutex> lock(batch->mutex);
+                    if (!batch->error) batch->error = current_exception();
+                }
+                lock_guard<std::mutex> lock(batch->mutex);
+                if (++batch->n_done == batch->n_chunks) batch->finished.notify_all();
+            }
+        };
+
+        {
+            lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < min(workers.size(), batch->n_chunks - 1); i++)
+                tasks.push(drain);
+        }
+        wake.notify_all();
+
+        // The calling thread claims chunks as well, so nested calls from a worker can't deadlock.
+        drain();
+        unique_lock<std::mutex> lock(batch->mutex);
+        batch->finished.wait(lock, [&batch]() { return batch->n_done == batch->n_chunks; });
+        if (batch->error) rethrow_exception(batch->error);
+    }
+
+    ThreadPool& ThreadPool::Shared()
+    {
+        return *SharedPointer();
+    }
+
+    void ThreadPool::SetShared(size_t n_threads)
+    {
+        SharedPointer().reset(new ThreadPool(n_threads));
+    }
+
+    void ThreadPool::Work()
+    {
+        while (true)
+        {
+            function<void()> task;
+            {
+                unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return stop || !tasks.empty(); });
+                if (stop && tasks.empty()) return;
+                task = move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+    unique_ptr<ThreadPool>& ThreadPool::SharedPointer()
+    {
+        static unique_ptr<ThreadPool> shared = unique_ptr<ThreadPool>(new ThreadPool(1));
+        return shared;
+    }
+}
@@ -0,0 +1,81 @@
+// ThreadPool.h
+//
+// Author: Matthew Dutson
+//
+// Definition of ThreadPool class
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace cherenkov_simulator
+{
+    /*
+     * A fixed set of worker threads used to run the data-parallel stages of the simulation and reconstruction. A single
+     * shared pool is used by all classes so that nested stages don't oversubscribe the machine.
+     */
+    class ThreadPool
+    {
+    public:
+
+        /*
+         * Creates a pool which runs work on the specified total number of threads, including the calling thread. A
+         * pool of size one (or zero) runs everything on the calling thread.
+         */
+        explicit ThreadPool(size_t n_threads);
+
+        /*
+         * Stops and joins all worker threads. Work which has already been queued is finished first.
+         */
+        ~ThreadPool();
+
+        /*
+         * Returns the total number of threads used by ParallelFor(), including the calling thread.
+         */
+        size_t Size() const;
+
+        /*
+         * Splits the range [0, n_items) into contiguous chunks and calls body(begin, end) on each chunk, using the
+         * workers and the calling thread. Blocks until all chunks are done. If any call throws, the first exception is
+         * rethrown on the calling thread once all chunks have finished.
+         */
+        void ParallelFor(size_t n_items, const std::function<void(size_t, size_t)>& body);
+
+        /*
+         * Returns the pool shared by the whole application. It has a single thread until SetShared() is called.
+         */
+        static ThreadPool& Shared();
+
+        /*
+         * Replaces the shared pool with one of the specified size. Must not be called while the shared pool is in use.
+         */
+        static void SetShared(size_t n_threads);
+
+    private:
+
+        std::vector<std::thread> workers;
+        std::queue<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stop;
+
+        /*
+         * The loop run by each worker thread. Pops and runs tasks until the pool is stopped.
+         */
+        void Work();
+
+        /*
+         * Returns the storage for the shared pool.
+         */
+        static std::unique_ptr<ThreadPool>& SharedPointer();
+    };
+}
+
+#endif
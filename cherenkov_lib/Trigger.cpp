@@ -0,0 +1,234 @@
+// Trigger.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of Trigger.h
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "Trigger.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+    TriggerEngine::Pattern TriggerEngine::ParsePattern(const string& name)
+    {
+        if (name == "cluster") return cluster;
+        if (name == "line") return line;
+        throw runtime_error("Unrecognized trigger pattern: " + name);
+    }
+
+    TriggerEngine::TriggerEngine() : TriggerEngine(0, 0, cluster, 0) {}
+
+    TriggerEngine::TriggerEngine(size_t n_rows, size_t n_cols, Pattern pattern, int pattern_size)
+    {
+        this->n_rows = n_rows;
+        this->n_cols = n_cols;
+        this->pattern = pattern;
+        this->pattern_size = pattern_size;
+        n_words = BitFrame(1, n_cols).NWords();
+        remaining = vector<uint64_t>(n_rows * n_words, 0);
+        region = vector<uint64_t>(n_rows * n_words, 0);
+        shifted = vector<uint64_t>(n_rows * n_words, 0);
+    }
+
+    bool TriggerEngine::Push(const BitFrame& frame)
+    {
+        if (frame.NRows() != n_rows || frame.NCols() != n_cols)
+            throw invalid_argument("The frame dimensions don't match the trigger engine");
+
+        bool triggered;
+        if (pattern_size <= 0) triggered = true;
+        else if (pattern == cluster) triggered = FindCluster(frame);
+        else triggered = FindLine(frame);
+
+        if (triggered && (decisions.empty() || !decisions.back())) trigger_times.push_back(decisions.size());
+        decisions.push_back(triggered);
+        return triggered;
+    }
+
+    void TriggerEngine::Reset()
+    {
+        decisions.clear();
+        trigger_times.clear();
+    }
+
+    size_t TriggerEngine::NFrames() const
+    {
+        return decisions.size();
+    }
+
+    bool TriggerEngine::Triggered() const
+    {
+        return !trigger_times.empty();
+    }
+
+    const Bool1D& TriggerEngine::Decisions() const
+    {
+        return decisions;
+    }
+
+    const vector<size_t>& TriggerEngine::TriggerTimes() const
+    {
+        return trigger_times;
+    }
+
+    bool TriggerEngine::FindCluster(const BitFrame& frame)
+    {
+        // A lone pixel never triggers, as with the breadth-first search this replaced. Most noise-only frames have too
+        // few pixels to contain a cluster at all.
+        auto min_size = (size_t) max(pattern_size, 2);
+        size_t total = 0;
+        for (size_t x = 0; x < n_rows; x++)
+        {
+            copy(frame.Row(x), frame.Row(x) + n_words, &remaining[x * n_words]);
+            total += Count(frame.Row(x));
+        }
+
+        size_t x_seed = 0;
+        while (total >= min_size)
+        {
+            // Seed a new region with the lowest remaining pixel.
+            while (!Any(&remaining[x_seed * n_words]))
+                x_seed++;
+            size_t w_seed = 0;
+            while (remaining[x_seed * n_words + w_seed] == 0)
+                w_seed++;
+            uint64_t seed_word = remaining[x_seed * n_words + w_seed];
+            fill(region.begin(), region.end(), 0);
+            region[x_seed * n_words + w_seed] = seed_word & (~seed_word + 1);
+
+            // Grow the region until it stops changing. Only rows within one of the region's bounds can change.
+            size_t x_bgn = x_seed;
+            size_t x_end = x_seed + 1;
+            size_t size = 1;
+            bool changed = true;
+            while (changed && size < min_size)
+            {
+                changed = false;
+                size_t grow_bgn = x_bgn == 0 ? 0 : x_bgn - 1;
+                size_t grow_end = min(x_end + 1, n_rows);
+                for (size_t x = grow_bgn; x < grow_end; x++)
+                {
+                    uint64_t* out = &shifted[x * n_words];
+                    fill(out, out + n_words, 0);
+                    for (size_t x_adj = (x == 0 ? 0 : x - 1); x_adj <= x + 1 && x_adj < n_rows; x_adj++)
+                        for (size_t w = 0; w < n_words; w++)
+                            out[w] |= region[x_adj * n_words + w];
+                }
+                for (size_t x = grow_bgn; x < grow_end; x++)
+                {
+                    uint64_t* row = &shifted[x * n_words];
+                    uint64_t* out = &region[x * n_words];
+                    const uint64_t* mask = &remaining[x * n_words];
+                    for (size_t w = 0; w < n_words; w++)
+                    {
+                        uint64_t lower = row[w] >> 1 | (w + 1 < n_words ? row[w + 1] << 63 : 0);
+                        uint64_t upper = row[w] << 1 | (w > 0 ? row[w - 1] >> 63 : 0);
+                        uint64_t grown = (row[w] | lower | upper) & mask[w];
+                        if (grown != out[w])
+                        {
+                            size += __builtin_popcountll(grown & ~out[w]);
+                            out[w] = grown;
+                            changed = true;
+                            x_bgn = min(x_bgn, x);
+                            x_end = max(x_end, x + 1);
+                        }
+                    }
+                }
+            }
+            if (size >= min_size) return true;
+
+            // Remove the finished region from the frame.
+            for (size_t x = x_bgn; x < x_end; x++)
+                for (size_t w = 0; w < n_words; w++)
+                    remaining[x * n_words + w] &= ~region[x * n_words + w];
+            total -= size;
+        }
+        return false;
+    }
+
+    bool TriggerEngine::FindLine(const BitFrame& frame)
+    {
+        size_t length = (size_t) pattern_size;
+        uint64_t* acc = region.data();
+        uint64_t* temp = shifted.data();
+
+        // Along each row, bit y of the accumulator stays set only if bits y through y + length - 1 are all set.
+        for (size_t x = 0; x < n_rows; x++)
+        {
+            copy(frame.Row(x), frame.Row(x) + n_words, acc);
+            for (size_t k = 1; k < length && Any(acc); k++)
+            {
+                Shift(frame.Row(x), (int) k, temp);
+                for (size_t w = 0; w < n_words; w++)
+                    acc[w] &= temp[w];
+            }
+            if (Any(acc)) return true;
+        }
+
+        // Along columns and both diagonals, AND together rows x through x + length - 1, shifting row x + k by 0, k,
+        // or -k bits.
+        if (length > n_rows) return false;
+        for (int direction = -1; direction <= 1; direction++)
+        {
+            for (size_t x = 0; x + length <= n_rows; x++)
+            {
+                copy(frame.Row(x), frame.Row(x) + n_words, acc);
+                for (size_t k = 1; k < length && Any(acc); k++)
+                {
+                    Shift(frame.Row(x + k), direction * (int) k, temp);
+                    for (size_t w = 0; w < n_words; w++)
+                        acc[w] &= temp[w];
+                }
+                if (Any(acc)) return true;
+            }
+        }
+        return false;
+    }
+
+    bool TriggerEngine::Any(const uint64_t* row) const
+    {
+        for (size_t w = 0; w < n_words; w++)
+            if (row[w] != 0) return true;
+        return false;
+    }
+
+    size_t TriggerEngine::Count(const uint64_t* row) const
+    {
+        size_t count = 0;
+        for (size_t w = 0; w < n_words; w++)
+            count += __builtin_popcountll(row[w]);
+        return count;
+    }
+
+    void TriggerEngine::Shift(const uint64_t* row, int shift, uint64_t* output) const
+    {
+        size_t amount = (size_t) abs(shift);
+        size_t word_shift = amount / 64;
+        size_t bit_shift = amount % 64;
+        for (size_t w = 0; w < n_words; w++)
+        {
+            uint64_t value = 0;
+            if (shift >= 0)
+            {
+                size_t src = w + word_shift;
+                if (src < n_words) value = row[src] >> bit_shift;
+                if (bit_shift > 0 && src + 1 < n_words) value |= row[src + 1] << (64 - bit_shift);
+            }
+            else if (w >= word_shift)
+            {
+                size_t src = w - word_shift;
+                value = row[src] << bit_shift;
+                if (bit_shift > 0 && src > 0) value |= row[src - 1] >> (64 - bit_shift);
+            }
+            output[w] = value;
+        }
+
+        // Clear any bits shifted past the end of the row.
+        if (n_cols % 64 != 0) output[n_words - 1] &= (uint64_t(1) << (n_cols % 64)) - 1;
+    }
+}
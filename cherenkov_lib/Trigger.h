@@ -0,0 +1,134 @@
+// Trigger.h
+//
+// Author: Matthew Dutson
+//
+// Definition of TriggerEngine class
+
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Clustering.h"
+#include "Utility.h"
+
+namespace cherenkov_simulator
+{
+    /*
+     * Applies a hardware-style trigger to a stream of threshold frames, one frame at a time. Each frame is checked for
+     * a pattern of above-threshold pixels using bitwise operations on its packed rows, so no per-pixel search is
+     * needed. The decision for each frame and the times at which the trigger turns on are recorded as frames arrive.
+     */
+    class TriggerEngine
+    {
+    public:
+
+        /*
+         * The supported trigger patterns. "cluster" requires a group of at least pattern_size pixels connected
+         * through their eight neighbors, and never less than two pixels. "line" requires pattern_size adjacent pixels
+         * in a straight row, column, or diagonal.
+         */
+        enum Pattern
+        {
+            cluster,
+            line
+        };
+
+        /*
+         * Converts the name of a pattern (as used in the config file) to a Pattern. Throws runtime_error for
+         * unrecognized names.
+         */
+        static Pattern ParsePattern(const std::string& name);
+
+        /*
+         * The default constructor. Creates an engine for frames with no rows.
+         */
+        TriggerEngine();
+
+        /*
+         * Creates an engine for frames of the specified size. A non-positive pattern_size triggers every frame.
+         */
+        TriggerEngine(size_t n_rows, size_t n_cols, Pattern pattern, int pattern_size);
+
+        /*
+         * Applies the trigger to the next frame in the stream and returns whether it was triggered. Throws
+         * invalid_argument if the frame has the wrong dimensions.
+         */
+        bool Push(const BitFrame& frame);
+
+        /*
+         * Clears all decisions so that a new stream can be processed.
+         */
+        void Reset();
+
+        /*
+         * Returns the number of frames which have been pushed since the last reset.
+         */
+        size_t NFrames() const;
+
+        /*
+         * Returns true if any frame pushed so far was triggered.
+         */
+        bool Triggered() const;
+
+        /*
+         * Returns the trigger decision for each frame pushed so far.
+         */
+        const Bool1D& Decisions() const;
+
+        /*
+         * Returns the index of each triggered frame which follows an untriggered frame (or starts the stream).
+         */
+        const std::vector<size_t>& TriggerTimes() const;
+
+    private:
+
+        friend class TriggerTest;
+
+        size_t n_rows;
+        size_t n_cols;
+        size_t n_words;
+        Pattern pattern;
+        int pattern_size;
+
+        Bool1D decisions;
+        std::vector<size_t> trigger_times;
+
+        // Work buffers, each holding one full frame, which are kept between frames to avoid reallocation
+        std::vector<uint64_t> remaining;
+        std::vector<uint64_t> region;
+        std::vector<uint64_t> shifted;
+
+        /*
+         * Returns true if the frame contains a cluster of at least pattern_size (and at least two) connected pixels.
+         * Clusters are grown from a single pixel by repeated dilation with the 3x3 neighborhood, masked by the frame.
+         */
+        bool FindCluster(const BitFrame& frame);
+
+        /*
+         * Returns true if the frame contains pattern_size adjacent pixels along a row, column, or diagonal. Each
+         * direction is checked by AND-ing together copies of the frame shifted by one step at a time.
+         */
+        bool FindLine(const BitFrame& frame);
+
+        /*
+         * Returns true if any bit of the packed row is set.
+         */
+        bool Any(const uint64_t* row) const;
+
+        /*
+         * Returns the number of set bits in the packed row.
+         */
+        size_t Count(const uint64_t* row) const;
+
+        /*
+         * Writes the packed row shifted toward lower y by the specified number of bits (toward higher y if negative)
+         * to the output. Bits shifted past either end of the row are dropped.
+         */
+        void Shift(const uint64_t* row, int shift, uint64_t* output) const;
+    };
+}
+
+#endif
@@ -4,29 +4,40 @@
 //
 // Implementation of Utility.h
 
+#include <algorithm>
 #include <fstream>
+#include <sstream>
 #include <boost/property_tree/xml_parser.hpp>
-#include <TRandom3.h>
-#include <TRotation.h>
 
+#include "Numeric.h"
+#include "Random.h"
 #include "Utility.h"
 
 using namespace std;
 using namespace boost::property_tree;
-using namespace TMath;
+using namespace cherenkov_simulator::numeric;
 
 namespace cherenkov_simulator
 {
-    TVector3 Utility::ToVector(string s)
+    Vec3 Utility::ToVector(string s)
     {
         size_t current = s.find('(');
         s.erase(0, current + 1);
 
-        TVector3 output = TVector3();
-        output.SetX(ParseTo(s, ','));
-        output.SetY(ParseTo(s, ','));
-        output.SetZ(ParseTo(s, ')'));
-        return output;
+        double x = ParseTo(s, ',');
+        double y = ParseTo(s, ',');
+        double z = ParseTo(s, ')');
+        return Vec3(x, y, z);
+    }
+
+    vector<string> Utility::SplitList(const string& list, char delimiter)
+    {
+        vector<string> items = vector<string>();
+        istringstream stream = istringstream(list);
+        string item;
+        while (getline(stream, item, delimiter))
+            if (item.find_first_not_of(" \t\n") != string::npos) items.push_back(item);
+        return items;
     }
 
     ptree Utility::ParseXMLFile(string filename)
@@ -50,29 +61,30 @@ namespace cherenkov_simulator
         }
     }
 
-    TRotation Utility::MakeRotation(double elevation_angle)
+    Mat3 Utility::MakeRotation(double elevation_angle, double azimuth_angle)
     {
-        TRotation rotate = TRotation();
+        Mat3 rotate = Mat3();
         rotate.RotateX(-PiOver2() + elevation_angle);
+        rotate.RotateZ(azimuth_angle);
         return rotate;
     }
 
-    bool Utility::WithinXYDisk(TVector3 vec, double radius)
+    bool Utility::WithinXYDisk(Vec3 vec, double radius)
     {
         return Sqrt(Sq(vec.X()) + Sq(vec.Y())) < radius;
     }
 
-    TVector3 Utility::RandNormal(TVector3 vec)
+    Vec3 Utility::RandNormal(Vec3 vec)
     {
         if (vec.Mag2() == 0)
         {
-            return TVector3(1, 0, 0);
+            return Vec3(1, 0, 0);
         }
         else
         {
-            TVector3 other_vec = vec + TVector3(1, 0, 0);
-            TVector3 normal = (vec.Cross(other_vec)).Unit();
-            normal.Rotate(gRandom->Uniform(2 * TMath::Pi()), vec);
+            Vec3 other_vec = vec + Vec3(1, 0, 0);
+            Vec3 normal = (vec.Cross(other_vec)).Unit();
+            normal.Rotate(Random::Shared().Uniform(TwoPi()), vec);
             return normal;
         }
     }
@@ -83,12 +95,12 @@ namespace cherenkov_simulator
             throw runtime_error("The bounds must be non-negative");
         if (min >= max)
             throw runtime_error("The min bound must be less than the max bound");
-        return Sqrt((Sq(max) - Sq(min)) * gRandom->Rndm() + Sq(min));
+        return Sqrt((Sq(max) - Sq(min)) * Random::Shared().Rndm() + Sq(min));
     }
 
     double Utility::RandCosine()
     {
-        return ASin(gRandom->Rndm());
+        return ASin(Random::Shared().Rndm());
     }
 
     double Utility::RandPower(double min, double max, double pow)
@@ -100,24 +112,42 @@ namespace cherenkov_simulator
 
         if (pow == -1)
         {
-            return min * Power(max / min, gRandom->Rndm());
+            return min * Power(max / min, Random::Shared().Rndm());
         }
         else
         {
             double a = Power(min, pow + 1);
             double b = Power(max, pow + 1);
-            return Power((b - a) * gRandom->Rndm() + a, 1.0 / (pow + 1));
+            return Power((b - a) * Random::Shared().Rndm() + a, 1.0 / (pow + 1));
         }
     }
 
+    double Utility::PowerDensity(double x, double min, double max, double pow)
+    {
+        if (x < min || x > max) return 0.0;
+        if (pow == -1) return 1.0 / (x * Log(max / min));
+        else return (pow + 1) * Power(x, pow) / (Power(max, pow + 1) - Power(min, pow + 1));
+    }
+
     int Utility::RandomRound(double value)
     {
         double decimal = value - Floor(value);
         auto base = (int) (value - decimal);
-        if (gRandom->Rndm() < decimal) return base + 1;
+        if (Random::Shared().Rndm() < decimal) return base + 1;
         else return base;
     }
 
+    unsigned int Utility::StreamSeed(unsigned int run_seed, uint64_t position)
+    {
+        // The splitmix64 finalizer.
+        uint64_t z = ((uint64_t) run_seed << 32 ^ position) + 0x9e3779b97f4a7c15;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        z = z ^ (z >> 31);
+        auto seed = (unsigned int) (z >> 32);
+        return seed == 0 ? 1 : seed;
+    }
+
     double Utility::ParseTo(string& s, char c)
     {
         size_t index = s.find(c);
@@ -135,4 +165,112 @@ namespace cherenkov_simulator
     {
         return to_string(cent / 1e5);
     }
+
+    Vec3 Utility::MinEigenvector(const double matrix[3][3])
+    {
+        // Find the smallest eigenvalue with the trigonometric solution of the characteristic cubic.
+        double off_diag = Sq(matrix[0][1]) + Sq(matrix[0][2]) + Sq(matrix[1][2]);
+        double trace = (matrix[0][0] + matrix[1][1] + matrix[2][2]) / 3.0;
+        double min_val;
+        if (off_diag == 0.0)
+        {
+            min_val = Min(matrix[0][0], Min(matrix[1][1], matrix[2][2]));
+        }
+        else
+        {
+            double width = Sqrt((Sq(matrix[0][0] - trace) + Sq(matrix[1][1] - trace) + Sq(matrix[2][2] - trace) +
+                                 2.0 * off_diag) / 6.0);
+            double b[3][3];
+            for (int i = 0; i < 3; i++)
+                for (int j = 0; j < 3; j++)
+                    b[i][j] = (matrix[i][j] - (i == j ? trace : 0.0)) / width;
+            double det = b[0][0] * (b[1][1] * b[2][2] - b[1][2] * b[2][1]) -
+                         b[0][1] * (b[1][0] * b[2][2] - b[1][2] * b[2][0]) +
+                         b[0][2] * (b[1][0] * b[2][1] - b[1][1] * b[2][0]);
+            double phi = ACos(Max(-1.0, Min(1.0, det / 2.0))) / 3.0;
+            min_val = trace + 2.0 * width * Cos(phi + 2.0 * Pi() / 3.0);
+        }
+
+        // The eigenvector is perpendicular to every row of the shifted matrix, so take the best-conditioned cross
+        // product of two rows.
+        Vec3 rows[3];
+        for (int i = 0; i < 3; i++)
+        {
+            rows[i] = Vec3(matrix[i][0], matrix[i][1], matrix[i][2]);
+            rows[i][i] -= min_val;
+        }
+        Vec3 best = Vec3();
+        for (int i = 0; i < 3; i++)
+        {
+            Vec3 cross = rows[i].Cross(rows[(i + 1) % 3]);
+            if (cross.Mag2() > best.Mag2()) best = cross;
+        }
+        double scale = Max(rows[0].Mag2(), Max(rows[1].Mag2(), rows[2].Mag2()));
+        if (best.Mag2() > 1e-20 * Sq(scale)) return best.Unit();
+
+        // The shifted matrix has rank one or zero, so any vector perpendicular to its largest row will do.
+        Vec3 largest = rows[0];
+        for (int i = 1; i < 3; i++)
+            if (rows[i].Mag2() > largest.Mag2()) largest = rows[i];
+        if (largest.Mag2() == 0.0) return Vec3(1, 0, 0);
+        return largest.Orthogonal().Unit();
+    }
+
+    double Utility::Integrate(const function<double(double)>& integrand, double a, double b, double tolerance)
+    {
+        // Nodes and weights of the 15-point Kronrod rule on [-1, 1], from the outermost node to the center. The
+        // embedded 7-point Gauss rule uses every other node, starting with the second.
+        static const double nodes[8] = {
+                0.991455371120812639, 0.949107912342758525, 0.864864423359769073, 0.741531185599394440,
+                0.586087235467691130, 0.405845151377397167, 0.207784955007898468, 0.0};
+        static const double kronrod[8] = {
+                0.022935322010529225, 0.063092092629978553, 0.104790010322250184, 0.140653259715525919,
+                0.169004726639267903, 0.190350578064785410, 0.204432940075298892, 0.209482141084727828};
+        static const double gauss[4] = {
+                0.129484966168869693, 0.279705391489276668, 0.381830050505118945, 0.417959183673469388};
+
+        struct Interval
+        {
+            double a;
+            double b;
+            double value;
+            double error;
+        };
+        auto apply_rule = [&](double a, double b)
+        {
+            double center = (a + b) / 2.0;
+            double half = (b - a) / 2.0;
+            double f_center = integrand(center);
+            double k_sum = kronrod[7] * f_center;
+            double g_sum = gauss[3] * f_center;
+            for (int i = 0; i < 7; i++)
+            {
+                double f_sum = integrand(center - half * nodes[i]) + integrand(center + half * nodes[i]);
+                k_sum += kronrod[i] * f_sum;
+                if (i % 2 == 1) g_sum += gauss[i / 2] * f_sum;
+            }
+            return Interval{a, b, k_sum * half, Abs((k_sum - g_sum) * half)};
+        };
+
+        vector<Interval> intervals = {apply_rule(a, b)};
+        double value = intervals[0].value;
+        double error = intervals[0].error;
+        while (error > tolerance * Abs(value) && intervals.size() < 1000)
+        {
+            auto worst = max_element(intervals.begin(), intervals.end(),
+                                     [](const Interval& x, const Interval& y) { return x.error < y.error; });
+            Interval split = *worst;
+            double center = (split.a + split.b) / 2.0;
+            *worst = apply_rule(split.a, center);
+            intervals.push_back(apply_rule(center, split.b));
+            value = 0.0;
+            error = 0.0;
+            for (const Interval& interval : intervals)
+            {
+                value += interval.value;
+                error += interval.error;
+            }
+        }
+        return value;
+    }
 }
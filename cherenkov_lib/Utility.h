@@ -8,10 +8,16 @@
 #ifndef UTILITY_H
 #define UTILITY_H
 
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <boost/property_tree/ptree.hpp>
-#include <TVector3.h>
+
+#include "Vec3.h"
 
 namespace cherenkov_simulator
 {
@@ -66,6 +72,13 @@ namespace cherenkov_simulator
     const double lambda_max = 4.0e-5; // Maximum Cherenkov wavelength
     const double chkv_k1 = 0.83;      // Parameter in Cherenkov angular distribution
     const double chkv_k2 = -0.67;     // Parameter in Cherenkov angular distribution
+
+    const double noise_skip = 1.0;   // Per-bin noise mean below which noise is sampled from arrival times
+    const double noise_table = 500.0; // Per-bin noise mean below which noise is sampled from a tabulated CDF
+
+    const int fit_scan = 180;       // Number of psi values tried when choosing a starting point for a profile fit
+    const int fit_iters = 200;      // Maximum number of Levenberg-Marquardt iterations in a profile fit
+    const double fit_toler = 1e-10; // Relative chi-square improvement at which a profile fit has converged
     
     typedef std::vector<bool> Bool1D;
     typedef std::vector<std::vector<bool>> Bool2D;
@@ -75,7 +88,39 @@ namespace cherenkov_simulator
     typedef std::vector<std::vector<short>> Short2D;
     typedef std::vector<std::vector<std::vector<short>>> Short3D;
 
+    typedef std::vector<int> Int1D;
+    typedef std::vector<std::vector<int>> Int2D;
+
     typedef std::vector<double> Double1D;
+    typedef std::vector<std::vector<double>> Double2D;
+
+    /*
+     * A table of values which are expensive to compute and depend only on a few numbers, such as the configuration
+     * parameters they're derived from. Each value is computed the first time its key is requested and kept for the
+     * life of the table, so objects which hold a value can share it with any other object built from the same numbers.
+     * This is safe to use from several threads. A thread requesting a value which is being computed waits for it.
+     */
+    template <class T>
+    class KeyedCache
+    {
+    public:
+
+        /*
+         * Returns the value for the key, calling compute to create it if it doesn't exist yet.
+         */
+        std::shared_ptr<const T> Get(const std::vector<double>& key, const std::function<T()>& compute)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::shared_ptr<const T>& value = values[key];
+            if (!value) value = std::make_shared<const T>(compute());
+            return value;
+        }
+
+    private:
+
+        std::mutex mutex;
+        std::map<std::vector<double>, std::shared_ptr<const T>> values;
+    };
 
     /*
      * Defines miscellaneous static methods which are globally accessible throughout the cherenkov_lib project (Utility
@@ -86,9 +131,14 @@ namespace cherenkov_simulator
     public:
         
         /*
-         * Reads the string and converts it to a TVector3 object.
+         * Reads the string and converts it to a Vec3 object.
          */
-        static TVector3 ToVector(std::string s);
+        static Vec3 ToVector(std::string s);
+
+        /*
+         * Splits a list at each occurrence of the delimiter, skipping blank entries. Used for lists in the config.
+         */
+        static std::vector<std::string> SplitList(const std::string& list, char delimiter = ';');
 
         /*
          * Reads the file with the specified filename and parses it to XML. Throws exceptions with an informative
@@ -99,18 +149,20 @@ namespace cherenkov_simulator
         /*
          * Determines whether the xy projection of the vector lies within a disk centered at the origin.
          */
-        static bool WithinXYDisk(TVector3 vec, double radius);
+        static bool WithinXYDisk(Vec3 vec, double radius);
 
         /*
-         * Constructs the rotation used by MonteCarlo and Simulator classes.
+         * Constructs the rotation from the detector frame to the world frame used by the Simulator and Reconstructor
+         * classes. The detector axis is raised by the elevation angle above the horizon, and is then turned by the
+         * azimuth angle about the vertical. With an azimuth of zero, the detector looks along the y-axis.
          */
-        static TRotation MakeRotation(double elevation_angle);
+        static Mat3 MakeRotation(double elevation_angle, double azimuth_angle = 0.0);
 
         /*
          * Generates a randomly rotated vector perpendicular to the input. If the input vector is zero, (1, 0, 0) is
          * returned.
          */
-        static TVector3 RandNormal(TVector3 vec);
+        static Vec3 RandNormal(Vec3 vec);
 
         /*
          * Returns a random, linearly distributed value constrained between zero and some maximum.
@@ -127,12 +179,25 @@ namespace cherenkov_simulator
          */
         static double RandPower(double min, double max, double pow);
 
+        /*
+         * Returns the probability density of the power law distribution drawn from by RandPower() at the value x. A
+         * power of one gives the density of RandLinear().
+         */
+        static double PowerDensity(double x, double min, double max, double pow);
+
         /*
          * Returns an integer which is randomly rounded up or down from the input double based on its decimal. For
          * instance, 3.2 would be rounded up to 4 20% of the time and down to 3 80% of the time.
          */
         static int RandomRound(double value);
 
+        /*
+         * Returns the seed for one shower in the random stream of a run, given the run's seed and the shower's position
+         * in the stream. Seeds are spread by a 64-bit mixing function and are never zero, since Random treats a zero
+         * seed as a request for a nondeterministic one.
+         */
+        static unsigned int StreamSeed(unsigned int run_seed, uint64_t position);
+
         /*
          * Calculates the percent error between the actual and expected values. If the expected value is zero, the
          * actual value is returned.
@@ -144,6 +209,22 @@ namespace cherenkov_simulator
          */
         static std::string KmString(double cent);
 
+        /*
+         * Returns the unit eigenvector of a symmetric 3x3 matrix which has the smallest eigenvalue. The eigenvalues are
+         * found in closed form from the characteristic cubic, and the eigenvector from cross products of the rows of
+         * the shifted matrix. If the smallest eigenvalue is repeated, an arbitrary vector from its eigenspace is
+         * returned.
+         */
+        static Vec3 MinEigenvector(const double matrix[3][3]);
+
+        /*
+         * Integrates a smooth integrand from a to b with adaptive 15-point Gauss-Kronrod quadrature. The subinterval
+         * with the largest error estimate is bisected until the total error estimate is below tolerance times the
+         * magnitude of the integral, which is the default tolerance of TF1::Integral().
+         */
+        static double Integrate(const std::function<double(double)>& integrand, double a, double b,
+                                double tolerance = 1e-12);
+
     private:
 
         /*
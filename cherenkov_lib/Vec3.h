@@ -0,0 +1,320 @@
+// Vec3.h
+//
+// Author: Matthew Dutson
+//
+// Definition of the Vec3 and Mat3 classes
+
+#ifndef VEC3_H
+#define VEC3_H
+
+#include <cmath>
+
+namespace cherenkov_simulator
+{
+    /*
+     * A three-vector of doubles. Unlike TVector3, this is trivially copyable and has no virtual methods, so it can be
+     * kept in registers and stored densely. Methods with the same names as TVector3 methods behave the same way.
+     * Conversions to ROOT types happen only where vectors are written to ROOT files.
+     */
+    class Vec3
+    {
+    public:
+
+        double x;
+        double y;
+        double z;
+
+        /*
+         * The default constructor. Creates a zero vector.
+         */
+        constexpr Vec3() : x(0.0), y(0.0), z(0.0) {}
+
+        /*
+         * Creates a vector with the specified components.
+         */
+        constexpr Vec3(double x, double y, double z) : x(x), y(y), z(z) {}
+
+        constexpr double X() const { return x; }
+
+        constexpr double Y() const { return y; }
+
+        constexpr double Z() const { return z; }
+
+        /*
+         * Returns a component by index (0, 1, or 2).
+         */
+        double operator[](int i) const { return i == 0 ? x : (i == 1 ? y : z); }
+
+        double& operator[](int i) { return i == 0 ? x : (i == 1 ? y : z); }
+
+        /*
+         * Copies the components into an array of three doubles.
+         */
+        void GetXYZ(double* output) const
+        {
+            output[0] = x;
+            output[1] = y;
+            output[2] = z;
+        }
+
+        constexpr double Dot(const Vec3& other) const { return x * other.x + y * other.y + z * other.z; }
+
+        constexpr Vec3 Cross(const Vec3& other) const
+        {
+            return Vec3(y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x);
+        }
+
+        constexpr double Mag2() const { return x * x + y * y + z * z; }
+
+        double Mag() const { return std::sqrt(Mag2()); }
+
+        /*
+         * Returns the length of the projection onto the xy plane.
+         */
+        double Perp() const { return std::sqrt(x * x + y * y); }
+
+        /*
+         * Returns a unit vector in the same direction. The zero vector is returned unchanged.
+         */
+        Vec3 Unit() const
+        {
+            double mag2 = Mag2();
+            double scale = mag2 > 0.0 ? 1.0 / std::sqrt(mag2) : 1.0;
+            return Vec3(x * scale, y * scale, z * scale);
+        }
+
+        /*
+         * Returns the angle to another vector, or zero if either vector is zero.
+         */
+        double Angle(const Vec3& other) const
+        {
+            double mag2 = Mag2() * other.Mag2();
+            if (mag2 <= 0.0) return 0.0;
+            double arg = Dot(other) / std::sqrt(mag2);
+            return std::acos(arg > 1.0 ? 1.0 : (arg < -1.0 ? -1.0 : arg));
+        }
+
+        /*
+         * Returns the azimuthal angle about the z axis, measured from the x axis.
+         */
+        double Phi() const { return x == 0.0 && y == 0.0 ? 0.0 : std::atan2(y, x); }
+
+        /*
+         * Returns the polar angle from the z axis.
+         */
+        double Theta() const { return x == 0.0 && y == 0.0 && z == 0.0 ? 0.0 : std::atan2(Perp(), z); }
+
+        /*
+         * Returns the cosine of the polar angle, or one for the zero vector.
+         */
+        double CosTheta() const
+        {
+            double mag = Mag();
+            return mag == 0.0 ? 1.0 : z / mag;
+        }
+
+        /*
+         * Returns a vector perpendicular to this one, with the same magnitude.
+         */
+        Vec3 Orthogonal() const
+        {
+            double abs_x = std::fabs(x);
+            double abs_y = std::fabs(y);
+            double abs_z = std::fabs(z);
+            if (abs_x < abs_y) return abs_x < abs_z ? Vec3(0.0, z, -y) : Vec3(y, -x, 0.0);
+            return abs_y < abs_z ? Vec3(-z, 0.0, x) : Vec3(y, -x, 0.0);
+        }
+
+        /*
+         * Rotates the vector about the x, y, or z axis by a right-handed angle.
+         */
+        void RotateX(double angle);
+
+        void RotateY(double angle);
+
+        void RotateZ(double angle);
+
+        /*
+         * Rotates the vector by a right-handed angle about an arbitrary axis. Nothing is done if the axis is zero.
+         */
+        void Rotate(double angle, const Vec3& axis);
+
+        constexpr Vec3 operator-() const { return Vec3(-x, -y, -z); }
+
+        constexpr Vec3 operator+(const Vec3& other) const { return Vec3(x + other.x, y + other.y, z + other.z); }
+
+        constexpr Vec3 operator-(const Vec3& other) const { return Vec3(x - other.x, y - other.y, z - other.z); }
+
+        constexpr Vec3 operator*(double scale) const { return Vec3(x * scale, y * scale, z * scale); }
+
+        constexpr Vec3 operator/(double scale) const { return Vec3(x / scale, y / scale, z / scale); }
+
+        constexpr bool operator==(const Vec3& other) const { return x == other.x && y == other.y && z == other.z; }
+
+        constexpr bool operator!=(const Vec3& other) const { return !(*this == other); }
+
+        Vec3& operator+=(const Vec3& other)
+        {
+            x += other.x;
+            y += other.y;
+            z += other.z;
+            return *this;
+        }
+
+        Vec3& operator-=(const Vec3& other)
+        {
+            x -= other.x;
+            y -= other.y;
+            z -= other.z;
+            return *this;
+        }
+
+        Vec3& operator*=(double scale)
+        {
+            x *= scale;
+            y *= scale;
+            z *= scale;
+            return *this;
+        }
+    };
+
+    constexpr Vec3 operator*(double scale, const Vec3& vec)
+    {
+        return vec * scale;
+    }
+
+    /*
+     * A 3x3 matrix, used for rotations, stored as three rows. Like TRotation, the Rotate methods multiply the matrix
+     * on the left, so they are applied after the existing rotation, and Inverse() is the transpose.
+     */
+    class Mat3
+    {
+    public:
+
+        Vec3 row_x;
+        Vec3 row_y;
+        Vec3 row_z;
+
+        /*
+         * The default constructor. Creates the identity.
+         */
+        constexpr Mat3() : row_x(1.0, 0.0, 0.0), row_y(0.0, 1.0, 0.0), row_z(0.0, 0.0, 1.0) {}
+
+        /*
+         * Creates a matrix with the specified rows.
+         */
+        constexpr Mat3(const Vec3& row_x, const Vec3& row_y, const Vec3& row_z) :
+            row_x(row_x), row_y(row_y), row_z(row_z) {}
+
+        constexpr double XX() const { return row_x.x; }
+
+        constexpr double XY() const { return row_x.y; }
+
+        constexpr double XZ() const { return row_x.z; }
+
+        constexpr double YX() const { return row_y.x; }
+
+        constexpr double YY() const { return row_y.y; }
+
+        constexpr double YZ() const { return row_y.z; }
+
+        constexpr double ZX() const { return row_z.x; }
+
+        constexpr double ZY() const { return row_z.y; }
+
+        constexpr double ZZ() const { return row_z.z; }
+
+        constexpr Vec3 operator*(const Vec3& vec) const { return Vec3(row_x.Dot(vec), row_y.Dot(vec), row_z.Dot(vec)); }
+
+        constexpr Mat3 operator*(const Mat3& other) const
+        {
+            return Mat3(other.row_x * row_x.x + other.row_y * row_x.y + other.row_z * row_x.z,
+                        other.row_x * row_y.x + other.row_y * row_y.y + other.row_z * row_y.z,
+                        other.row_x * row_z.x + other.row_y * row_z.y + other.row_z * row_z.z);
+        }
+
+        /*
+         * Returns the transpose, which is the inverse of a rotation.
+         */
+        constexpr Mat3 Inverse() const
+        {
+            return Mat3(Vec3(row_x.x, row_y.x, row_z.x), Vec3(row_x.y, row_y.y, row_z.y),
+                        Vec3(row_x.z, row_y.z, row_z.z));
+        }
+
+        /*
+         * Follows the current rotation with a right-handed rotation about the x, y, or z axis.
+         */
+        Mat3& RotateX(double angle)
+        {
+            double c = std::cos(angle);
+            double s = std::sin(angle);
+            return *this = Mat3(Vec3(1.0, 0.0, 0.0), Vec3(0.0, c, -s), Vec3(0.0, s, c)) * *this;
+        }
+
+        Mat3& RotateY(double angle)
+        {
+            double c = std::cos(angle);
+            double s = std::sin(angle);
+            return *this = Mat3(Vec3(c, 0.0, s), Vec3(0.0, 1.0, 0.0), Vec3(-s, 0.0, c)) * *this;
+        }
+
+        Mat3& RotateZ(double angle)
+        {
+            double c = std::cos(angle);
+            double s = std::sin(angle);
+            return *this = Mat3(Vec3(c, -s, 0.0), Vec3(s, c, 0.0), Vec3(0.0, 0.0, 1.0)) * *this;
+        }
+
+        /*
+         * Follows the current rotation with a right-handed rotation about an arbitrary axis. Nothing is done if the
+         * axis is zero.
+         */
+        Mat3& Rotate(double angle, const Vec3& axis)
+        {
+            double mag = axis.Mag();
+            if (angle == 0.0 || mag == 0.0) return *this;
+            double c = std::cos(angle);
+            double s = std::sin(angle);
+            Vec3 u = axis / mag;
+            double k = 1.0 - c;
+            Mat3 rotation = Mat3(Vec3(c + k * u.x * u.x, k * u.x * u.y - s * u.z, k * u.x * u.z + s * u.y),
+                                 Vec3(k * u.y * u.x + s * u.z, c + k * u.y * u.y, k * u.y * u.z - s * u.x),
+                                 Vec3(k * u.z * u.x - s * u.y, k * u.z * u.y + s * u.x, c + k * u.z * u.z));
+            return *this = rotation * *this;
+        }
+
+        /*
+         * Follows the current rotation with the one which takes the x, y, and z axes to the specified orthonormal
+         * axes.
+         */
+        Mat3& RotateAxes(const Vec3& new_x, const Vec3& new_y, const Vec3& new_z)
+        {
+            Mat3 rotation = Mat3(Vec3(new_x.x, new_y.x, new_z.x), Vec3(new_x.y, new_y.y, new_z.y),
+                                 Vec3(new_x.z, new_y.z, new_z.z));
+            return *this = rotation * *this;
+        }
+    };
+
+    inline void Vec3::RotateX(double angle)
+    {
+        *this = Mat3().RotateX(angle) * *this;
+    }
+
+    inline void Vec3::RotateY(double angle)
+    {
+        *this = Mat3().RotateY(angle) * *this;
+    }
+
+    inline void Vec3::RotateZ(double angle)
+    {
+        *this = Mat3().RotateZ(angle) * *this;
+    }
+
+    inline void Vec3::Rotate(double angle, const Vec3& axis)
+    {
+        *this = Mat3().Rotate(angle, axis) * *this;
+    }
+}
+
+#endif
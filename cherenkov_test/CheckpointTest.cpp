@@ -0,0 +1,66 @@
+// CheckpointTest.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of Checkpoint.h
+
+#include <fstream>
+#include <stdexcept>
+#include <gtest/gtest.h>
+
+#include "Checkpoint.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+    /*
+     * Every field should be read back as it was saved, including counts too large for 32 bits.
+     */
+    TEST(CheckpointTest, RoundTrip)
+    {
+        Checkpoint state = Checkpoint();
+        state.seed = 4000000000u;
+        state.shard = 2;
+        state.n_shards = 3;
+        state.next_attempt = 12345678901ull;
+        state.next_id = 42;
+        state.n_rejected = 7;
+        state.n_culled = 23456789012ull;
+        state.n_accepted = 345;
+        state.n_rows = 41;
+        state.n_chkv = 5;
+        state.csv_bytes = 9876543210ull;
+        state.event_bytes = 123;
+        state.n_events = 4;
+        state.Save("CheckpointRoundTrip.chk");
+
+        Checkpoint read = Checkpoint::Load("CheckpointRoundTrip.chk");
+        ASSERT_EQ(state.seed, read.seed);
+        ASSERT_EQ(state.shard, read.shard);
+        ASSERT_EQ(state.n_shards, read.n_shards);
+        ASSERT_EQ(state.next_attempt, read.next_attempt);
+        ASSERT_EQ(state.next_id, read.next_id);
+        ASSERT_EQ(state.n_rejected, read.n_rejected);
+        ASSERT_EQ(state.n_culled, read.n_culled);
+        ASSERT_EQ(state.n_accepted, read.n_accepted);
+        ASSERT_EQ(state.n_rows, read.n_rows);
+        ASSERT_EQ(state.n_chkv, read.n_chkv);
+        ASSERT_EQ(state.csv_bytes, read.csv_bytes);
+        ASSERT_EQ(state.event_bytes, read.event_bytes);
+        ASSERT_EQ(state.n_events, read.n_events);
+    }
+
+    /*
+     * Missing and incomplete checkpoints should be reported as runtime errors.
+     */
+    TEST(CheckpointTest, Incomplete)
+    {
+        ASSERT_THROW(Checkpoint::Load("NoSuchCheckpoint.chk"), runtime_error);
+        {
+            ofstream file = ofstream("CheckpointIncomplete.chk");
+            file << "<checkpoint><seed>1</seed><shard>0</shard></checkpoint>" << endl;
+        }
+        ASSERT_THROW(Checkpoint::Load("CheckpointIncomplete.chk"), runtime_error);
+    }
+}
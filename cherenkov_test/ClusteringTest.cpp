@@ -0,0 +1,130 @@
+// ClusteringTest.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of Clustering.h
+
+#include <gtest/gtest.h>
+
+#include "Clustering.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+
+/*
+ * Note: this class will be able to access private members of the ClusterLabeler class.
+ */
+class ClusteringTest : public ::testing::Test
+{
+public:
+
+    /*
+     * Returns the number of runs found by the labeler.
+     */
+    static size_t NRuns(const ClusterLabeler& labeler)
+    {
+        return labeler.runs.size();
+    }
+};
+
+    /*
+     * Check that values can be set and cleared, including across word boundaries.
+     */
+    TEST_F(ClusteringTest, BitFrameSetGet)
+    {
+        BitFrame frame = BitFrame(3, 130);
+        ASSERT_EQ(3, frame.NWords());
+        ASSERT_TRUE(frame.Empty());
+        frame.Set(1, 63);
+        frame.Set(1, 64);
+        frame.Set(2, 129);
+        ASSERT_TRUE(frame.Get(1, 63));
+        ASSERT_TRUE(frame.Get(1, 64));
+        ASSERT_TRUE(frame.Get(2, 129));
+        ASSERT_FALSE(frame.Get(0, 63));
+        frame.Set(1, 63, false);
+        ASSERT_FALSE(frame.Get(1, 63));
+        ASSERT_FALSE(frame.Empty());
+    }
+
+    /*
+     * Check that a 3D matrix is packed into one frame per time bin.
+     */
+    TEST_F(ClusteringTest, FromMatrix)
+    {
+        Bool3D matrix = Bool3D(4, Bool2D(5, Bool1D(3, false)));
+        matrix[2][4][1] = true;
+        vector<BitFrame> frames = BitFrame::FromMatrix(matrix);
+        ASSERT_EQ(3, frames.size());
+        ASSERT_TRUE(frames[0].Empty());
+        ASSERT_TRUE(frames[1].Get(2, 4));
+        ASSERT_TRUE(frames[2].Empty());
+    }
+
+    /*
+     * Check that diagonal neighbors are joined, and that cells two apart are not.
+     */
+    TEST_F(ClusteringTest, SpatialConnectivity)
+    {
+        BitFrame frame = BitFrame(6, 6);
+        frame.Set(0, 0);
+        frame.Set(1, 1);
+        frame.Set(2, 2);
+        frame.Set(2, 3);
+        frame.Set(5, 0);
+        frame.Set(5, 2);
+        ClusterLabeler labeler = ClusterLabeler(vector<BitFrame>(1, frame), false);
+        ASSERT_EQ(5, NRuns(labeler));
+        ASSERT_EQ(3, labeler.NClusters());
+        ASSERT_EQ(labeler.Label(0, 0, 0), labeler.Label(2, 3, 0));
+        ASSERT_EQ(4, labeler.ClusterSize(labeler.Label(1, 1, 0)));
+        ASSERT_NE(labeler.Label(5, 0, 0), labeler.Label(5, 2, 0));
+        ASSERT_EQ(-1, labeler.Label(3, 3, 0));
+    }
+
+    /*
+     * Check that the same pixel in adjacent frames is only joined when time connections are enabled, and that
+     * diagonal neighbors in adjacent frames are never joined.
+     */
+    TEST_F(ClusteringTest, TimeConnectivity)
+    {
+        vector<BitFrame> frames = vector<BitFrame>(4, BitFrame(3, 3));
+        frames[0].Set(1, 1);
+        frames[1].Set(1, 1);
+        frames[2].Set(2, 2);
+        ClusterLabeler separate = ClusterLabeler(frames, false);
+        ASSERT_EQ(3, separate.NClusters());
+        ClusterLabeler joined = ClusterLabeler(frames, true);
+        ASSERT_EQ(2, joined.NClusters());
+        ASSERT_EQ(joined.Label(1, 1, 0), joined.Label(1, 1, 1));
+        ASSERT_NE(joined.Label(1, 1, 1), joined.Label(2, 2, 2));
+    }
+
+    /*
+     * Check the largest cluster in each frame, and that marking a cluster sets exactly its cells.
+     */
+    TEST_F(ClusteringTest, LargestAndMark)
+    {
+        vector<BitFrame> frames = vector<BitFrame>(3, BitFrame(4, 4));
+        frames[0].Set(0, 0);
+        frames[1].Set(0, 0);
+        frames[1].Set(3, 1);
+        frames[1].Set(3, 2);
+        frames[1].Set(3, 3);
+        ClusterLabeler labeler = ClusterLabeler(frames, true);
+        vector<size_t> largest = labeler.LargestInFrame();
+        ASSERT_EQ(2, largest[0]);
+        ASSERT_EQ(3, largest[1]);
+        ASSERT_EQ(0, largest[2]);
+
+        vector<bool> keep = vector<bool>(labeler.NClusters(), false);
+        keep[labeler.Label(0, 0, 0)] = true;
+        Bool3D matrix = Bool3D(4, Bool2D(4, Bool1D(3, false)));
+        labeler.Mark(keep, matrix);
+        ASSERT_TRUE(matrix[0][0][0]);
+        ASSERT_TRUE(matrix[0][0][1]);
+        ASSERT_FALSE(matrix[3][1][1]);
+    }
+}
@@ -6,6 +6,7 @@
 
 #include <gtest/gtest.h>
 #include <TFile.h>
+#include <TMath.h>
 
 #include "DataStructures.h"
 #include "Analysis.h"
@@ -70,6 +71,11 @@ namespace cherenkov_simulator
         {
             return data.RealNoiseRate(rate);
         }
+
+        void FriendIncrementCell(PhotonCount& data, int inc, size_t x, size_t y, size_t t)
+        {
+            data.IncrementCell(inc, x, y, t);
+        }
     };
 
     /*
@@ -227,6 +233,23 @@ namespace cherenkov_simulator
         }
     }
 
+    /*
+     * Counts with the same pixels should share their direction tables, including copies, and counts with different
+     * pixels shouldn't.
+     */
+    TEST_F(DataStructuresTest, SharedTables)
+    {
+        PhotonCount data = CopyEmpty();
+        PhotonCount::Params params = CopyParams();
+        PhotonCount same = PhotonCount(params, 0.0, 0.5);
+        params.ang_size = 0.09;
+        PhotonCount other = PhotonCount(params, 0.0, 0.5);
+        ASSERT_EQ(&data.Directions(), &same.Directions());
+        ASSERT_EQ(&data.Directions(), &CopySample().Directions());
+        ASSERT_NE(&data.Directions(), &other.Directions());
+        ASSERT_NE(data.Directions()[0][1], other.Directions()[0][1]);
+    }
+
     /*
      * Check that the correct pixels are marked as positive.
      */
@@ -378,17 +401,17 @@ namespace cherenkov_simulator
     {
         PhotonCount data0 = CopyEmpty();
         ASSERT_TRUE(data0.Empty());
-        data0.AddPhoton(0.2, TVector3(0.0, 0.0, -1.0), 1);
+        data0.AddPhoton(0.2, Vec3(0.0, 0.0, -1.0), 1);
         ASSERT_FALSE(data0.Empty());
 
         PhotonCount data1 = CopyEmpty();
         ASSERT_TRUE(data1.Empty());
-        data1.AddPhoton(-0.3, TVector3(0.0, 0.0, -1.0), 1);
+        data1.AddPhoton(-0.3, Vec3(0.0, 0.0, -1.0), 1);
         ASSERT_TRUE(data1.Empty());
 
         PhotonCount data2 = CopyEmpty();
         ASSERT_TRUE(data2.Empty());
-        data2.AddPhoton(0.2, TVector3(0.0, 1.0, 0.0), 1);
+        data2.AddPhoton(0.2, Vec3(0.0, 1.0, 0.0), 1);
         ASSERT_TRUE(data2.Empty());
 
         PhotonCount data3 = CopyEmpty();
@@ -493,7 +516,7 @@ namespace cherenkov_simulator
         iter.Next();
         iter.Next();
 
-        TVector3 direction = TVector3(0, 0, 1);
+        Vec3 direction = Vec3(0, 0, 1);
         direction.RotateX(0.04);
         direction.RotateY(-0.04);
         ASSERT_TRUE(Helper::VectorsEqual(direction, data.Direction(iter), 1e-3));
@@ -634,7 +657,7 @@ namespace cherenkov_simulator
     TEST_F(DataStructuresTest, AddValidPhoton)
     {
         PhotonCount data = CopyEmpty();
-        TVector3 direction = TVector3(0, 0, 1);
+        Vec3 direction = Vec3(0, 0, 1);
         direction.RotateX(0.12);
         direction.RotateY(-0.04);
         data.AddPhoton(0.45, -direction, 3);
@@ -653,7 +676,7 @@ namespace cherenkov_simulator
     TEST_F(DataStructuresTest, AddInvalidPosition)
     {
         PhotonCount data = CopyEmpty();
-        data.AddPhoton(0.45, TVector3(0.0, 1.0, 0.0), 1);
+        data.AddPhoton(0.45, Vec3(0.0, 1.0, 0.0), 1);
         ASSERT_TRUE(data.Empty());
 
         PhotonCount::Iterator iter = data.GetIterator();
@@ -670,14 +693,14 @@ namespace cherenkov_simulator
         PhotonCount data = CopyEmpty();
         try
         {
-            data.AddPhoton(0.35, TVector3(0, 0, 0), 1);
+            data.AddPhoton(0.35, Vec3(0, 0, 0), 1);
             FAIL() << "Exception not thrown";
         }
         catch (invalid_argument& err)
         {
             ASSERT_EQ(string("Direction cannot be a zero vector"), err.what());
         }
-        data.AddPhoton(0.35, TVector3(1, 1, 0), 1);
+        data.AddPhoton(0.35, Vec3(1, 1, 0), 1);
     }
 
     /*
@@ -686,7 +709,7 @@ namespace cherenkov_simulator
     TEST_F(DataStructuresTest, AddInvalidTime)
     {
         PhotonCount data = CopyEmpty();
-        data.AddPhoton(-0.1, TVector3(0, 0, 1), 1);
+        data.AddPhoton(-0.1, Vec3(0, 0, 1), 1);
         ASSERT_TRUE(data.Empty());
 
         PhotonCount::Iterator iter = data.GetIterator();
@@ -714,6 +737,93 @@ namespace cherenkov_simulator
         ASSERT_EQ(expected, data.SumBins(iter));
     }
 
+    /*
+     * Check that the bulk noise generator produces the right average number of photons, both in the low-rate regime
+     * (sampled arrival times) and in the high-rate regime (tabulated CDF). Note that a universal rate of 1e4 implies a
+     * real rate of 6.4 per bin.
+     */
+    TEST_F(DataStructuresTest, AddBulkNoise)
+    {
+        for (double universal_rate : {1e2, 1e4})
+        {
+            PhotonCount empty = CopyEmpty();
+            double mean = FriendRealNoiseRate(empty, universal_rate);
+            Double2D rates = Double2D(empty.Size(), Double1D(empty.Size(), universal_rate));
+
+            int n_trials = 2000;
+            double n_bins = 0;
+            double total = 0;
+            for (int i = 0; i < n_trials; i++)
+            {
+                PhotonCount data = CopyEmpty();
+                data.AddNoise(rates);
+                PhotonCount::Iterator iter = data.GetIterator();
+                while (iter.Next())
+                {
+                    total += data.SumBins(iter);
+                    n_bins += data.NBins();
+                }
+            }
+            double expected = mean * n_bins;
+            ASSERT_LT(Abs(total - expected), 5.0 * Sqrt(expected));
+        }
+    }
+
+    /*
+     * Check that noise read from a NoiseBank triggers at the same rate as freshly generated noise. For each source,
+     * count the bins above a two sigma threshold and the frames with at least one such bin, then compare the two
+     * sources with a two-proportion z-test.
+     */
+    TEST_F(DataStructuresTest, NoiseBankTriggerRate)
+    {
+        for (double universal_rate : {1e2, 1e4})
+        {
+            PhotonCount empty = CopyEmpty();
+            int thresh = empty.FindThreshold(universal_rate, 2.0);
+            Double2D rates = Double2D(empty.Size(), Double1D(empty.Size(), universal_rate));
+            NoiseBank bank = NoiseBank(empty.RealNoiseRate(universal_rate), 64, 1000);
+
+            int n_trials = 5000;
+            double n_bins = 0;
+            double n_frames = 0;
+            double above[2] = {0, 0};
+            double trigd[2] = {0, 0};
+            for (int source = 0; source < 2; source++)
+            {
+                for (int i = 0; i < n_trials; i++)
+                {
+                    PhotonCount data = CopyEmpty();
+                    if (source == 0) data.AddNoise(rates);
+                    else data.AddNoise(rates, {&bank});
+
+                    Bool1D frame_trigd = Bool1D(data.NBins(), false);
+                    PhotonCount::Iterator iter = data.GetIterator();
+                    while (iter.Next())
+                    {
+                        Bool1D pixel_above = data.AboveThreshold(iter, thresh);
+                        for (size_t t = 0; t < data.NBins(); t++)
+                        {
+                            above[source] += pixel_above[t];
+                            frame_trigd[t] = frame_trigd[t] || pixel_above[t];
+                        }
+                        if (source == 0) n_bins += data.NBins();
+                    }
+                    for (bool state : frame_trigd)
+                        trigd[source] += state;
+                    if (source == 0) n_frames += data.NBins();
+                }
+            }
+
+            double bin_rate = (above[0] + above[1]) / (2.0 * n_bins);
+            double bin_err = Sqrt(2.0 * bin_rate * (1.0 - bin_rate) / n_bins);
+            ASSERT_LT(Abs(above[0] - above[1]) / n_bins, 4.0 * bin_err);
+
+            double frame_rate = (trigd[0] + trigd[1]) / (2.0 * n_frames);
+            double frame_err = Sqrt(2.0 * frame_rate * (1.0 - frame_rate) / n_frames);
+            ASSERT_LT(Abs(trigd[0] - trigd[1]) / n_frames, 4.0 * frame_err);
+        }
+    }
+
     /*
      * Tests the AboveThreshold function.
      */
@@ -734,6 +844,43 @@ namespace cherenkov_simulator
         ASSERT_EQ(expected, data.AboveThreshold(iter, 6));
     }
 
+    /*
+     * Checks that the pyramid search of CellsAbove() finds exactly the cells found by scanning every cell, including
+     * negative counts and thresholds, and blocks cut off at the edges of the array.
+     */
+    TEST_F(DataStructuresTest, CellsAbove)
+    {
+        PhotonCount::Params params = CopyParams();
+        params.n_pixels = 22;
+        PhotonCount data = PhotonCount(params, 0.0, 3.65);
+        Random random = Random(3);
+        Int2D thresholds = Int2D(data.Size(), Int1D(data.Size()));
+        for (size_t x = 0; x < data.Size(); x++)
+        {
+            for (size_t y = 0; y < data.Size(); y++)
+            {
+                thresholds[x][y] = (int) random.Integer(4) - 1;
+                for (size_t t = 0; t < data.NBins(); t++)
+                    FriendIncrementCell(data, random.Poisson(0.2) - (int) random.Integer(2), x, y, t);
+            }
+        }
+
+        Bool3D above = data.GetFalseMatrix();
+        PhotonCount::Iterator iter = data.GetIterator();
+        while (iter.Next())
+            above[iter.X()][iter.Y()] = data.AboveThreshold(iter, thresholds[iter.X()][iter.Y()]);
+        vector<vector<size_t>> expected = vector<vector<size_t>>();
+        for (size_t t = 0; t < data.NBins(); t++)
+            for (size_t x = 0; x < data.Size(); x++)
+                for (size_t y = 0; y < data.Size(); y++)
+                    if (above[x][y][t]) expected.push_back({x, y, t});
+        vector<vector<size_t>> found = vector<vector<size_t>>();
+        for (const PhotonCount::Cell& cell : data.CellsAbove(thresholds)) found.push_back({cell.x, cell.y, cell.t});
+        ASSERT_FALSE(expected.empty());
+        ASSERT_EQ(expected, found);
+        ASSERT_TRUE(PhotonCount().CellsAbove(Int2D()).empty());
+    }
+
     /*
      * Make sure FindThreshold correctly sets the threshold based on Gaussian probabilities. Note that, for the sample
      * data set, a universal noise rate of 1e4 implies a real noise rate of 6.4. The integral of a Gaussian above three
@@ -0,0 +1,251 @@
+// Equivalence.cpp
+//
+// Author: Matthew Dutson
+//
+// Implementation of Equivalence.h
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <TMath.h>
+
+#include "Analysis.h"
+#include "Equivalence.h"
+#include "Random.h"
+
+using namespace std;
+using namespace boost::property_tree;
+using namespace TMath;
+
+namespace cherenkov_simulator
+{
+    bool Equivalence::Report::Passed() const
+    {
+        for (const Check& check : checks)
+            if (!check.passed) return false;
+        return true;
+    }
+
+    double Equivalence::Report::Speedup() const
+    {
+        return ref_seconds / cand_seconds;
+    }
+
+    string Equivalence::Report::ToString() const
+    {
+        ostringstream output;
+        for (const Check& check : checks)
+        {
+            output << check.name << ": statistic = " << check.statistic << ", p = " << check.p_value << ", "
+                   << (check.passed ? "pass" : "FAIL") << "\n";
+        }
+        output << (Passed() ? "Equivalent" : "NOT equivalent") << ", speedup = " << Speedup() << " (" << ref_seconds
+               << " s reference, " << cand_seconds << " s candidate)\n";
+        return output.str();
+    }
+
+    Equivalence::Equivalence(const ptree& reference, const ptree& candidate, double alpha) :
+        ref_simulator(reference), ref_reconstructor(reference), cand_simulator(candidate),
+        cand_reconstructor(candidate), alpha(alpha)
+    {
+        if (reference.get<size_t>("detector.n_pixels") != candidate.get<size_t>("detector.n_pixels") ||
+            reference.get<double>("detector.view_rad") != candidate.get<double>("detector.view_rad"))
+            throw invalid_argument("The reference and candidate must have the same pixel array");
+
+        ref_thinning = Thinning(reference);
+        cand_thinning = Thinning(candidate);
+
+        // Time profiles are compared on the coarser of the two binnings.
+        time_width = Max(reference.get<double>("simulation.bin_size"), candidate.get<double>("simulation.bin_size"));
+    }
+
+    Equivalence::Report Equivalence::Compare(const vector<Shower>& showers, int n_repeats) const
+    {
+        Sample ref = Run(ref_simulator, ref_reconstructor, ref_thinning, showers, n_repeats, 1);
+        Sample cand = Run(cand_simulator, cand_reconstructor, cand_thinning, showers, n_repeats, 2);
+        Report report = Report();
+        report.ref_seconds = ref.seconds;
+        report.cand_seconds = cand.seconds;
+
+        double statistic;
+        double p_value = ChiSquareTest(ref.pixl_sums, cand.pixl_sums, statistic);
+        AddCheck(report, "Pixel sums", statistic, p_value);
+
+        // Line up the time profiles, filling in bins which only one of the samples reached.
+        vector<double> ref_profile = vector<double>();
+        vector<double> cand_profile = vector<double>();
+        for (const pair<const long long, double>& bin : ref.time_profile)
+            cand.time_profile[bin.first] += 0.0;
+        for (const pair<const long long, double>& bin : cand.time_profile)
+        {
+            ref_profile.push_back(ref.time_profile[bin.first]);
+            cand_profile.push_back(bin.second);
+        }
+        p_value = ChiSquareTest(ref_profile, cand_profile, statistic);
+        AddCheck(report, "Time profile", statistic, p_value);
+
+        p_value = ChiSquareTest(ref.noise_sums, cand.noise_sums, statistic);
+        AddCheck(report, "Noise pixel sums", statistic, p_value);
+        p_value = KolmogorovTest(ref.noise_totals, cand.noise_totals, statistic);
+        AddCheck(report, "Noise totals", statistic, p_value);
+
+        p_value = ProportionTest(ref.n_triggered, ref.n_runs, cand.n_triggered, cand.n_runs, statistic);
+        AddCheck(report, "Trigger rate", statistic, p_value);
+        p_value = KolmogorovTest(ref.im_resid, cand.im_resid, statistic);
+        AddCheck(report, "Impact residual", statistic, p_value);
+        p_value = KolmogorovTest(ref.psi_resid, cand.psi_resid, statistic);
+        AddCheck(report, "Angle residual", statistic, p_value);
+        return report;
+    }
+
+    double Equivalence::ChiSquareTest(const vector<double>& a, const vector<double>& b, double& statistic)
+    {
+        if (a.size() != b.size()) throw invalid_argument("The histograms must have the same number of bins");
+        double sum_a = 0.0;
+        double sum_b = 0.0;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            sum_a += a[i];
+            sum_b += b[i];
+        }
+        statistic = 0.0;
+        if (sum_a == 0.0 || sum_b == 0.0) return sum_a == sum_b ? 1.0 : 0.0;
+
+        // Each bin contributes (sqrt(B / A) a - sqrt(A / B) b)^2 / (a + b), which allows for different totals.
+        double scale_a = Sqrt(sum_b / sum_a);
+        double scale_b = Sqrt(sum_a / sum_b);
+        double small_a = 0.0;
+        double small_b = 0.0;
+        int n_bins = 0;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            if (a[i] + b[i] < 10.0)
+            {
+                small_a += a[i];
+                small_b += b[i];
+                continue;
+            }
+            statistic += Sq(scale_a * a[i] - scale_b * b[i]) / (a[i] + b[i]);
+            n_bins++;
+        }
+        if (small_a + small_b > 0.0)
+        {
+            statistic += Sq(scale_a * small_a - scale_b * small_b) / (small_a + small_b);
+            n_bins++;
+        }
+        if (n_bins < 2) return 1.0;
+        return Prob(statistic, n_bins - 1);
+    }
+
+    double Equivalence::KolmogorovTest(vector<double> a, vector<double> b, double& statistic)
+    {
+        statistic = 0.0;
+        if (a.empty() || b.empty()) return 1.0;
+        sort(a.begin(), a.end());
+        sort(b.begin(), b.end());
+
+        // Step through both samples in order, tracking the gap between the empirical distributions.
+        size_t i = 0;
+        size_t j = 0;
+        while (i < a.size() && j < b.size())
+        {
+            double value = Min(a[i], b[j]);
+            while (i < a.size() && a[i] == value) i++;
+            while (j < b.size() && b[j] == value) j++;
+            statistic = Max(statistic, Abs((double) i / a.size() - (double) j / b.size()));
+        }
+        return TMath::KolmogorovTest((Int_t) a.size(), a.data(), (Int_t) b.size(), b.data(), "");
+    }
+
+    double Equivalence::ProportionTest(uint64_t k_a, uint64_t n_a, uint64_t k_b, uint64_t n_b, double& statistic)
+    {
+        statistic = 0.0;
+        if (n_a == 0 || n_b == 0) return 1.0;
+        double pooled = (double) (k_a + k_b) / (n_a + n_b);
+        double error = Sqrt(pooled * (1.0 - pooled) * (1.0 / n_a + 1.0 / n_b));
+        if (error == 0.0) return 1.0;
+        statistic = ((double) k_a / n_a - (double) k_b / n_b) / error;
+        return Erfc(Abs(statistic) / Sqrt(2.0));
+    }
+
+    Equivalence::Sample Equivalence::Run(const Simulator& simulator, const Reconstructor& reconstructor,
+                                         double thinning, const vector<Shower>& showers, int n_repeats,
+                                         unsigned int run_seed) const
+    {
+        Sample sample = Sample();
+        sample.n_runs = 0;
+        sample.n_triggered = 0;
+        sample.seconds = 0.0;
+        for (int repeat = 0; repeat < n_repeats; repeat++)
+        {
+            for (size_t s = 0; s < showers.size(); s++)
+            {
+                const Shower& shower = showers[s];
+                Random::Shared().SetSeed(Utility::StreamSeed(run_seed, repeat * showers.size() + s));
+                auto start = chrono::steady_clock::now();
+                PhotonCount data = simulator.SimulateShower(shower);
+                chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+                sample.seconds += elapsed.count();
+
+                // Time bins are keyed by shower and by their offset from the first possible arrival time.
+                Snapshot snapshot = Analysis::TakeSnapshot(data);
+                double origin = shower.Time() + shower.Position().Mag() / c_cent;
+                for (size_t i = 0; i < snapshot.counts.size(); i++)
+                {
+                    auto bin = (long long) Floor((snapshot.times[i] - origin) / time_width + 1e-6);
+                    sample.time_profile[((long long) s << 40) + bin] += snapshot.counts[i] / thinning;
+                }
+                size_t n_pixels = snapshot.pixl_sums.size();
+                sample.pixl_sums.resize(showers.size() * n_pixels * n_pixels, 0.0);
+                for (size_t x = 0; x < n_pixels; x++)
+                    for (size_t y = 0; y < n_pixels; y++)
+                        sample.pixl_sums[(s * n_pixels + x) * n_pixels + y] += snapshot.pixl_sums[x][y] / thinning;
+
+                start = chrono::steady_clock::now();
+                reconstructor.AddNoise(data);
+                elapsed = chrono::steady_clock::now() - start;
+                sample.seconds += elapsed.count();
+
+                // Noise photons aren't thinned, so the noise in each pixel is compared without scaling.
+                Int2D noisy_sums = data.PixelSums();
+                double noise_total = 0.0;
+                sample.noise_sums.resize(showers.size() * n_pixels * n_pixels, 0.0);
+                for (size_t x = 0; x < n_pixels; x++)
+                {
+                    for (size_t y = 0; y < n_pixels; y++)
+                    {
+                        double noise = noisy_sums[x][y] - snapshot.pixl_sums[x][y];
+                        sample.noise_sums[(s * n_pixels + x) * n_pixels + y] += noise;
+                        noise_total += noise;
+                    }
+                }
+                sample.noise_totals.push_back(noise_total);
+
+                start = chrono::steady_clock::now();
+                Reconstructor::Result result = Reconstructor::Result();
+                if (reconstructor.ClearNoise(data)) result = reconstructor.Reconstruct(data, true);
+                elapsed = chrono::steady_clock::now() - start;
+                sample.seconds += elapsed.count();
+
+                sample.n_runs++;
+                if (!result.triggered) continue;
+                sample.n_triggered++;
+                double im_par = shower.ImpactParam();
+                sample.im_resid.push_back((result.mono_recon.ImpactParam() - im_par) / im_par);
+                sample.psi_resid.push_back(result.mono_recon.ImpactAngle() - shower.ImpactAngle());
+            }
+        }
+        return sample;
+    }
+
+    double Equivalence::Thinning(const ptree& config)
+    {
+        return Max(config.get<double>("simulation.flor_thin"), config.get<double>("simulation.chkv_thin"));
+    }
+
+    void Equivalence::AddCheck(Report& report, string name, double statistic, double p_value) const
+    {
+        report.checks.push_back({name, statistic, p_value, p_value >= alpha});
+    }
+}
@@ -0,0 +1,150 @@
+// Equivalence.h
+//
+// Author: Matthew Dutson
+//
+// Definition of the Equivalence class used to validate fast paths against the reference implementation.
+
+#ifndef EQUIVALENCE_H
+#define EQUIVALENCE_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/property_tree/ptree.hpp>
+
+#include "Reconstructor.h"
+#include "Simulator.h"
+
+namespace cherenkov_simulator
+{
+    /*
+     * Compares a candidate configuration, such as one which enables an approximate or optimized path, against a
+     * reference configuration. Both are run on the same shower fixtures many times, with independent random streams,
+     * and their outputs are compared as distributions rather than bit for bit:
+     *  - the noise-free pixel sums and time profile, summed over all repeats, with chi-squared tests of homogeneity
+     *  - the noise added to each pixel, summed over all repeats, with a chi-squared test of homogeneity
+     *  - the total noise added to each run, with a Kolmogorov-Smirnov test
+     *  - the trigger rate after noise is added and cleared, with a two-proportion z-test
+     *  - the fractional impact parameter and angle residuals of the monocular fit, with Kolmogorov-Smirnov tests
+     * Each test passes if its p-value is at least alpha. The time spent on each configuration is also reported.
+     * The chi-squared tests assume Poisson counts. A thinned photon adds the thinning factor to its bin, so the
+     * noise-free counts of each configuration are divided by its larger thinning factor, which leaves them no more
+     * dispersed than Poisson counts.
+     */
+    class Equivalence
+    {
+    public:
+
+        /*
+         * The outcome of a single statistical test.
+         */
+        struct Check
+        {
+            std::string name;
+            double statistic;
+            double p_value;
+            bool passed;
+        };
+
+        /*
+         * The outcome of a comparison. Passed() is true only if every check passed.
+         */
+        struct Report
+        {
+            std::vector<Check> checks;
+            double ref_seconds;
+            double cand_seconds;
+
+            /*
+             * Returns true if all checks passed.
+             */
+            bool Passed() const;
+
+            /*
+             * Returns the ratio of the reference time to the candidate time.
+             */
+            double Speedup() const;
+
+            /*
+             * Returns a table with one line per check, followed by the overall result and the speedup.
+             */
+            std::string ToString() const;
+        };
+
+        /*
+         * Creates a harness for two configurations. Throws an invalid_argument if they have different pixel arrays, so
+         * pixel sums can't be compared.
+         */
+        Equivalence(const boost::property_tree::ptree& reference, const boost::property_tree::ptree& candidate,
+                    double alpha = 1e-3);
+
+        /*
+         * Runs each shower n_repeats times with each configuration and compares the results.
+         */
+        Report Compare(const std::vector<Shower>& showers, int n_repeats) const;
+
+        /*
+         * Returns the p-value of a chi-squared test that two histograms with the same binning were drawn from the same
+         * distribution, and stores the chi-squared value in statistic. Bins with fewer than ten combined counts are
+         * merged into one.
+         */
+        static double ChiSquareTest(const std::vector<double>& a, const std::vector<double>& b, double& statistic);
+
+        /*
+         * Returns the p-value of a two-sample Kolmogorov-Smirnov test, and stores the largest difference between the
+         * empirical distributions in statistic. Returns one if either sample is empty.
+         */
+        static double KolmogorovTest(std::vector<double> a, std::vector<double> b, double& statistic);
+
+        /*
+         * Returns the two-sided p-value of a z-test that two success fractions are equal, and stores z in statistic.
+         */
+        static double ProportionTest(uint64_t k_a, uint64_t n_a, uint64_t k_b, uint64_t n_b, double& statistic);
+
+    private:
+
+        /*
+         * The outputs of one configuration, summed or collected over all repeats.
+         */
+        struct Sample
+        {
+            std::vector<double> pixl_sums;
+            std::map<long long, double> time_profile;
+            std::vector<double> noise_sums;
+            std::vector<double> noise_totals;
+            uint64_t n_runs;
+            uint64_t n_triggered;
+            std::vector<double> im_resid;
+            std::vector<double> psi_resid;
+            double seconds;
+        };
+
+        Simulator ref_simulator;
+        Reconstructor ref_reconstructor;
+        Simulator cand_simulator;
+        Reconstructor cand_reconstructor;
+        double ref_thinning;
+        double cand_thinning;
+        double time_width;
+        double alpha;
+
+        /*
+         * Runs every shower n_repeats times through one configuration. Repeats are seeded from the stream of run_seed.
+         * Noise-free counts are divided by the thinning factor.
+         */
+        Sample Run(const Simulator& simulator, const Reconstructor& reconstructor, double thinning,
+                   const std::vector<Shower>& showers, int n_repeats, unsigned int run_seed) const;
+
+        /*
+         * Returns the larger of the fluorescence and Cherenkov thinning factors of a configuration.
+         */
+        static double Thinning(const boost::property_tree::ptree& config);
+
+        /*
+         * Adds a check with the statistic and p-value to the report.
+         */
+        void AddCheck(Report& report, std::string name, double statistic, double p_value) const;
+    };
+}
+
+#endif
@@ -0,0 +1,47 @@
+// EquivalenceTest.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of Equivalence.h
+
+#include <gtest/gtest.h>
+#include <TMath.h>
+
+#include "Equivalence.h"
+#include "Random.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+    /*
+     * Samples from the same distribution should pass each test, while shifted samples should fail.
+     */
+    TEST(EquivalenceTest, StatisticalTests)
+    {
+        Random::Shared().SetSeed(1);
+        vector<double> hist_a = vector<double>(20, 0.0);
+        vector<double> hist_b = vector<double>(20, 0.0);
+        vector<double> hist_c = vector<double>(20, 0.0);
+        vector<double> norm_a, norm_b, norm_c;
+        for (int i = 0; i < 5000; i++)
+        {
+            hist_a[(size_t) Random::Shared().Uniform(20)]++;
+            hist_b[(size_t) Random::Shared().Uniform(20)]++;
+            hist_c[(size_t) TMath::Min(Random::Shared().Exp(8.0), 19.0)]++;
+            norm_a.push_back(Random::Shared().Gaus(0, 1));
+            norm_b.push_back(Random::Shared().Gaus(0, 1));
+            norm_c.push_back(Random::Shared().Gaus(0.2, 1));
+        }
+
+        double statistic;
+        EXPECT_GT(Equivalence::ChiSquareTest(hist_a, hist_b, statistic), 1e-3);
+        EXPECT_LT(Equivalence::ChiSquareTest(hist_a, hist_c, statistic), 1e-3);
+        EXPECT_GT(Equivalence::KolmogorovTest(norm_a, norm_b, statistic), 1e-3);
+        EXPECT_LT(Equivalence::KolmogorovTest(norm_a, norm_c, statistic), 1e-3);
+        EXPECT_GT(Equivalence::ProportionTest(500, 1000, 510, 1000, statistic), 1e-3);
+        EXPECT_LT(Equivalence::ProportionTest(500, 1000, 600, 1000, statistic), 1e-3);
+        EXPECT_EQ(1.0, Equivalence::KolmogorovTest(norm_a, vector<double>(), statistic));
+        EXPECT_THROW(Equivalence::ChiSquareTest(hist_a, vector<double>(3, 0.0), statistic), invalid_argument);
+    }
+}
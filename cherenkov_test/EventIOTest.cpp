@@ -0,0 +1,146 @@
+// EventIOTest.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of EventIO.h
+
+#include <fstream>
+#include <stdexcept>
+#include <gtest/gtest.h>
+
+#include "EventIO.h"
+#include "Random.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+    /*
+     * Write two events and check that they are read back exactly, along with their origins.
+     */
+    TEST(EventIOTest, RoundTrip)
+    {
+        PhotonCount::Params params = PhotonCount::Params();
+        params.n_pixels = 6;
+        params.max_byte = 4000000;
+        params.bin_size = 0.1;
+        params.ang_size = 0.08;
+        params.lin_size = 2.5;
+        PhotonCount data = PhotonCount(params, 0.0, 9.95);
+
+        // Noise is only added to the time range of the signal, so a signal spanning the whole range comes first.
+        data.AddPhoton(0.05, Vec3(0, 0, -1), 1);
+        data.AddPhoton(9.9, Vec3(0, 0, -1), 1);
+        Random::Shared().SetSeed(1);
+        PhotonCount::Iterator iter = data.GetIterator();
+        while (iter.Next())
+            data.AddNoise(1000.0, iter);
+        data.Trim();
+        Shower shower = Shower(2.7e19, 150000, Vec3(0, 0, 2000000), Vec3(1, -1, -3), 1e-5);
+
+        EventOrigin origin = EventOrigin();
+        origin.attempt = 12345678901ull;
+        origin.id = 17;
+        origin.weight = 0.125;
+        {
+            EventWriter writer = EventWriter("EventRoundTrip.evt");
+            ASSERT_EQ(1, writer.Write(shower, data, origin));
+            ASSERT_EQ(2, writer.Write(shower, PhotonCount(params, 0.0, 0.95)));
+        }
+
+        EventReader reader("EventRoundTrip.evt");
+        uint64_t id;
+        Shower read_shower;
+        PhotonCount read_data;
+        EventOrigin read_origin;
+        ASSERT_TRUE(reader.Next(id, read_shower, read_data, read_origin));
+        ASSERT_EQ(1, id);
+        ASSERT_EQ(origin.attempt, read_origin.attempt);
+        ASSERT_EQ(origin.id, read_origin.id);
+        ASSERT_EQ(origin.weight, read_origin.weight);
+        ASSERT_EQ(shower.Position(), read_shower.Position());
+        ASSERT_EQ(shower.Direction(), read_shower.Direction());
+        ASSERT_EQ(shower.Time(), read_shower.Time());
+        ASSERT_EQ(shower.EnergyeV(), read_shower.EnergyeV());
+        ASSERT_EQ(shower.Elevation(), read_shower.Elevation());
+        ASSERT_EQ(data.NBins(), read_data.NBins());
+        ASSERT_EQ(data.Time(0), read_data.Time(0));
+        ASSERT_EQ(data.Empty(), read_data.Empty());
+        iter.Reset();
+        while (iter.Next())
+        {
+            ASSERT_EQ(data.Signal(iter), read_data.Signal(iter));
+            ASSERT_EQ(data.SumBins(iter), read_data.SumBins(iter));
+        }
+
+        ASSERT_TRUE(reader.Next(id, read_shower, read_data, read_origin));
+        ASSERT_EQ(2, id);
+        ASSERT_EQ(0u, read_origin.id);
+        ASSERT_EQ(1.0, read_origin.weight);
+        ASSERT_TRUE(read_data.Empty());
+        ASSERT_FALSE(reader.Next(id, read_shower, read_data, read_origin));
+    }
+
+    /*
+     * Reopen a file as if resuming from a checkpoint taken after the first event. The second event, written after the
+     * checkpoint, should be replaced by the one written after reopening.
+     */
+    TEST(EventIOTest, Resume)
+    {
+        PhotonCount::Params params = PhotonCount::Params();
+        params.n_pixels = 4;
+        params.max_byte = 4000000;
+        params.bin_size = 0.1;
+        params.ang_size = 0.08;
+        params.lin_size = 2.5;
+        Shower shower_1 = Shower(1e18, 150000, Vec3(0, 0, 2000000), Vec3(0, 0, -1));
+        Shower shower_2 = Shower(2e18, 150000, Vec3(0, 0, 2000000), Vec3(0, 0, -1));
+        Shower shower_3 = Shower(3e18, 150000, Vec3(0, 0, 2000000), Vec3(0, 0, -1));
+
+        uint64_t n_written, n_bytes;
+        {
+            EventWriter writer = EventWriter("EventResume.evt");
+            writer.Write(shower_1, PhotonCount(params, 0.0, 0.95));
+            writer.Flush();
+            n_written = writer.NWritten();
+            n_bytes = writer.NBytes();
+            writer.Write(shower_2, PhotonCount(params, 0.0, 0.95));
+        }
+        {
+            EventWriter writer = EventWriter("EventResume.evt", n_written, n_bytes);
+            ASSERT_EQ(2, writer.Write(shower_3, PhotonCount(params, 0.0, 0.95)));
+        }
+        ASSERT_THROW(EventWriter("EventResume.evt", n_written, 1 << 20), runtime_error);
+
+        EventReader reader("EventResume.evt");
+        uint64_t id;
+        Shower read_shower;
+        PhotonCount read_data;
+        EventOrigin read_origin;
+        ASSERT_TRUE(reader.Next(id, read_shower, read_data, read_origin));
+        ASSERT_EQ(shower_1.EnergyeV(), read_shower.EnergyeV());
+        ASSERT_TRUE(reader.Next(id, read_shower, read_data, read_origin));
+        ASSERT_EQ(2, id);
+        ASSERT_EQ(shower_3.EnergyeV(), read_shower.EnergyeV());
+        ASSERT_FALSE(reader.Next(id, read_shower, read_data, read_origin));
+    }
+
+    /*
+     * Files without the event header, or written with an older format version, should be rejected.
+     */
+    TEST(EventIOTest, BadHeader)
+    {
+        {
+            ofstream file = ofstream("EventBadHeader.evt");
+            file << "Seed,ID,Energy" << endl;
+        }
+        ASSERT_THROW(EventReader("EventBadHeader.evt"), runtime_error);
+        {
+            ofstream file = ofstream("EventOldVersion.evt", ios::binary);
+            file.write(event_magic, sizeof(event_magic));
+            file.write("\x01\0\0\0", 4);
+        }
+        ASSERT_THROW(EventReader("EventOldVersion.evt"), runtime_error);
+        ASSERT_THROW(EventReader("EventMissing.evt"), runtime_error);
+    }
+}
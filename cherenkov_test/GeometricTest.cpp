@@ -29,9 +29,9 @@ private:
 
     virtual void SetUp()
     {
-        test_ray_1 = Ray(TVector3(7, 2, 3), TVector3(8, 8, 8), 1.7);
-        test_ray_2 = Ray(TVector3(0, 0, 0), TVector3(-1, 2, -1), -0.8);
-        test_shower = Shower(2.7e19, 150000, TVector3(0, 0, 2000000), TVector3(1, -1, -3));
+        test_ray_1 = Ray(Vec3(7, 2, 3), Vec3(8, 8, 8), 1.7);
+        test_ray_2 = Ray(Vec3(0, 0, 0), Vec3(-1, 2, -1), -0.8);
+        test_shower = Shower(2.7e19, 150000, Vec3(0, 0, 2000000), Vec3(1, -1, -3));
     }
 
     virtual void TearDown()
@@ -61,7 +61,7 @@ public:
     TEST_F(GeometricTest, DefaultPlane)
     {
         Plane plane = Plane();
-        ASSERT_EQ(plane.Normal(), TVector3(0, 0, 1));
+        ASSERT_EQ(plane.Normal(), Vec3(0, 0, 1));
         ASSERT_EQ(0, plane.Coefficient());
     }
 
@@ -70,8 +70,8 @@ public:
      */
     TEST_F(GeometricTest, PlaneUnitNormal)
     {
-        Plane plane = Plane(TVector3(0, 0, 12), TVector3(0, 0, 0));
-        ASSERT_EQ(TVector3(0, 0, 1), plane.Normal());
+        Plane plane = Plane(Vec3(0, 0, 12), Vec3(0, 0, 0));
+        ASSERT_EQ(Vec3(0, 0, 1), plane.Normal());
     }
 
     /*
@@ -79,7 +79,7 @@ public:
      */
     TEST_F(GeometricTest, PlaneCoefficient)
     {
-        Plane plane = Plane(TVector3(0, 0, 1), TVector3(45, -12, 33));
+        Plane plane = Plane(Vec3(0, 0, 1), Vec3(45, -12, 33));
         ASSERT_EQ(33, plane.Coefficient());
     }
 
@@ -88,8 +88,8 @@ public:
      */
     TEST_F(GeometricTest, SetPlaneNormal)
     {
-        Plane plane = Plane(TVector3(1, 1, 1), TVector3(45, -12, 33));
-        ASSERT_EQ(plane.Normal(), TVector3(1 / Sqrt(3), 1 / Sqrt(3), 1 / Sqrt(3)));
+        Plane plane = Plane(Vec3(1, 1, 1), Vec3(45, -12, 33));
+        ASSERT_EQ(plane.Normal(), Vec3(1 / Sqrt(3), 1 / Sqrt(3), 1 / Sqrt(3)));
         ASSERT_EQ(66, plane.Coefficient());
     }
 
@@ -100,7 +100,7 @@ public:
     {
         try
         {
-            Plane(TVector3(0, 0, 0), TVector3(10, 120, -11));
+            Plane(Vec3(0, 0, 0), Vec3(10, 120, -11));
             FAIL() << "Exception not thrown";
         }
         catch(invalid_argument& err)
@@ -114,12 +114,12 @@ public:
      */
     TEST_F(GeometricTest, InFrontOf)
     {
-        Plane front = Plane(TVector3(1, 0, 0), TVector3(10, 0, 0));
-        Plane origin = Plane(TVector3(1, 0, 0), TVector3(0, 0, 0));
-        Plane back = Plane(TVector3(1, 0, 0), TVector3(-10, 0, 0));
-        ASSERT_TRUE(front.InFrontOf(TVector3(1, 0, 0)));
-        ASSERT_FALSE(origin.InFrontOf(TVector3(1, 0, 0)));
-        ASSERT_FALSE(back.InFrontOf(TVector3(1, 0, 0)));
+        Plane front = Plane(Vec3(1, 0, 0), Vec3(10, 0, 0));
+        Plane origin = Plane(Vec3(1, 0, 0), Vec3(0, 0, 0));
+        Plane back = Plane(Vec3(1, 0, 0), Vec3(-10, 0, 0));
+        ASSERT_TRUE(front.InFrontOf(Vec3(1, 0, 0)));
+        ASSERT_FALSE(origin.InFrontOf(Vec3(1, 0, 0)));
+        ASSERT_FALSE(back.InFrontOf(Vec3(1, 0, 0)));
     }
 
     /*
@@ -128,8 +128,8 @@ public:
     TEST_F(GeometricTest, DefaultRay)
     {
         Ray ray = Ray();
-        ASSERT_EQ(TVector3(0, 0, 1), ray.Direction());
-        ASSERT_EQ(TVector3(0, 0, 0), ray.Position());
+        ASSERT_EQ(Vec3(0, 0, 1), ray.Direction());
+        ASSERT_EQ(Vec3(0, 0, 0), ray.Position());
         ASSERT_EQ(0, ray.Time());
     }
 
@@ -139,8 +139,8 @@ public:
     TEST_F(GeometricTest, UserRay)
     {
         Ray ray = CopyRay1();
-        ASSERT_EQ(TVector3(7, 2, 3), ray.Position());
-        ASSERT_TRUE(Helper::VectorsEqual(TVector3(1, 1, 1).Unit(), ray.Direction(), 1e-6));
+        ASSERT_EQ(Vec3(7, 2, 3), ray.Position());
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(1, 1, 1).Unit(), ray.Direction(), 1e-6));
         ASSERT_EQ(1.7, ray.Time());
     }
 
@@ -151,7 +151,7 @@ public:
     {
         try
         {
-            Ray(TVector3(1, 2, 3), TVector3(0, 0, 0), 0);
+            Ray(Vec3(1, 2, 3), Vec3(0, 0, 0), 0);
             FAIL() << "Exception not thrown";
         }
         catch(invalid_argument& err)
@@ -166,14 +166,14 @@ public:
     TEST_F(GeometricTest, TestPosition)
     {
         Ray ray = CopyRay1();
-        ASSERT_EQ(TVector3(7, 2, 3), ray.Position());
+        ASSERT_EQ(Vec3(7, 2, 3), ray.Position());
 
-        Plane plane = Plane(TVector3(1, 0, 0), TVector3(10, 0, 0));
+        Plane plane = Plane(Vec3(1, 0, 0), Vec3(10, 0, 0));
         ray.PropagateToPlane(plane);
-        ASSERT_EQ(TVector3(10, 5, 6), ray.Position());
+        ASSERT_EQ(Vec3(10, 5, 6), ray.Position());
 
-        ray.PropagateToPoint(TVector3(12, 7, 3));
-        ASSERT_EQ(TVector3(12, 7, 3), ray.Position());
+        ray.PropagateToPoint(Vec3(12, 7, 3));
+        ASSERT_EQ(Vec3(12, 7, 3), ray.Position());
     }
 
     /*
@@ -183,13 +183,13 @@ public:
     TEST_F(GeometricTest, TestVelocity)
     {
         Ray ray = CopyRay1();
-        ASSERT_EQ(TVector3(1, 1, 1).Unit() * c_cent, ray.Velocity());
+        ASSERT_EQ(Vec3(1, 1, 1).Unit() * c_cent, ray.Velocity());
 
-        ray.Reflect(TVector3(-1, 0, 0));
-        ASSERT_EQ(TVector3(-1, 1, 1).Unit() * c_cent, ray.Velocity());
+        ray.Reflect(Vec3(-1, 0, 0));
+        ASSERT_EQ(Vec3(-1, 1, 1).Unit() * c_cent, ray.Velocity());
 
-        ray.SetDirection(TVector3(-1, 2, 0));
-        ASSERT_EQ(TVector3(-1, 2, 0).Unit() * c_cent, ray.Velocity());
+        ray.SetDirection(Vec3(-1, 2, 0));
+        ASSERT_EQ(Vec3(-1, 2, 0).Unit() * c_cent, ray.Velocity());
     }
 
     /*
@@ -198,13 +198,13 @@ public:
     TEST_F(GeometricTest, TestDirection)
     {
         Ray ray = CopyRay1();
-        ASSERT_TRUE(Helper::VectorsEqual(TVector3(1, 1, 1).Unit(), ray.Direction(), 1e-6));
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(1, 1, 1).Unit(), ray.Direction(), 1e-6));
 
-        ray.Reflect(TVector3(-1, 0, 0));
-        ASSERT_TRUE(Helper::VectorsEqual(TVector3(-1, 1, 1).Unit(), ray.Direction(), 1e-6));
+        ray.Reflect(Vec3(-1, 0, 0));
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(-1, 1, 1).Unit(), ray.Direction(), 1e-6));
 
-        ray.SetDirection(TVector3(-1, 2, 0));
-        ASSERT_TRUE(Helper::VectorsEqual(TVector3(-1, 2, 0).Unit(), ray.Direction(), 1e-6));
+        ray.SetDirection(Vec3(-1, 2, 0));
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(-1, 2, 0).Unit(), ray.Direction(), 1e-6));
     }
 
     /*
@@ -215,7 +215,7 @@ public:
         Ray ray = CopyRay1();
         try
         {
-            ray.SetDirection(TVector3(0, 0, 0));
+            ray.SetDirection(Vec3(0, 0, 0));
             FAIL() << "Exception not thrown";
         }
         catch(invalid_argument& err)
@@ -232,13 +232,13 @@ public:
         Ray ray1 = CopyRay1();
         ASSERT_EQ(1.7, ray1.Time());
 
-        Plane plane = Plane(TVector3(1, 0, 0), TVector3(10, 0, 0));
+        Plane plane = Plane(Vec3(1, 0, 0), Vec3(10, 0, 0));
         ray1.PropagateToPlane(plane);
-        ASSERT_EQ(1.7 + TVector3(3, 3, 3).Mag() / c_cent, ray1.Time());
+        ASSERT_EQ(1.7 + Vec3(3, 3, 3).Mag() / c_cent, ray1.Time());
 
         Ray ray2 = CopyRay1();
-        ray2.PropagateToPoint(TVector3(-1, 7, 8));
-        ASSERT_EQ(1.7 + TVector3(-8, 5, 5).Mag() / c_cent, ray2.Time());
+        ray2.PropagateToPoint(Vec3(-1, 7, 8));
+        ASSERT_EQ(1.7 + Vec3(-8, 5, 5).Mag() / c_cent, ray2.Time());
     }
 
     /*
@@ -247,11 +247,11 @@ public:
     TEST_F(GeometricTest, PropagateToPoint)
     {
         Ray ray = CopyRay1();
-        TVector3 dir_init = ray.Direction();
-        ray.PropagateToPoint(TVector3(20, 15, 16));
-        ASSERT_EQ(TVector3(20, 15, 16), ray.Position());
+        Vec3 dir_init = ray.Direction();
+        ray.PropagateToPoint(Vec3(20, 15, 16));
+        ASSERT_EQ(Vec3(20, 15, 16), ray.Position());
         ASSERT_EQ(dir_init, ray.Direction());
-        ASSERT_EQ(1.7 + TVector3(13, 13, 13).Mag() / c_cent, ray.Time());
+        ASSERT_EQ(1.7 + Vec3(13, 13, 13).Mag() / c_cent, ray.Time());
     }
 
     /*
@@ -261,10 +261,10 @@ public:
     TEST_F(GeometricTest, PropagateToPointChange)
     {
         Ray ray = CopyRay1();
-        ray.PropagateToPoint(TVector3(-8, 97, 4));
-        ASSERT_TRUE(Helper::VectorsEqual(TVector3(-8, 97, 4), ray.Position(), 1e-6));
-        ASSERT_TRUE(Helper::VectorsEqual(TVector3(-15, 95, 1).Unit(), ray.Direction(), 1e-6));
-        ASSERT_EQ(1.7 + TVector3(-15, 95, 1).Mag() / c_cent, ray.Time());
+        ray.PropagateToPoint(Vec3(-8, 97, 4));
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(-8, 97, 4), ray.Position(), 1e-6));
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(-15, 95, 1).Unit(), ray.Direction(), 1e-6));
+        ASSERT_EQ(1.7 + Vec3(-15, 95, 1).Mag() / c_cent, ray.Time());
     }
 
     /*
@@ -273,19 +273,19 @@ public:
     TEST_F(GeometricTest, PropagateToPlane)
     {
         Ray ray1 = CopyRay1();
-        Plane plane1 = Plane(TVector3(1, 0, 0), TVector3(10, 0, 0));
+        Plane plane1 = Plane(Vec3(1, 0, 0), Vec3(10, 0, 0));
         double init1 = ray1.Time();
         ray1.PropagateToPlane(plane1);
         ASSERT_EQ(ray1.Position().Dot(plane1.Normal()), plane1.Coefficient());
-        ASSERT_EQ(TVector3(10, 5, 6), ray1.Position());
+        ASSERT_EQ(Vec3(10, 5, 6), ray1.Position());
         ASSERT_TRUE(ray1.Time() > init1);
 
         Ray ray2 = CopyRay2();
-        Plane plane2 = Plane(TVector3(0, 0, 1), TVector3(0, 0, 2));
+        Plane plane2 = Plane(Vec3(0, 0, 1), Vec3(0, 0, 2));
         double init2 = ray2.Time();
         ray2.PropagateToPlane(plane2);
         ASSERT_EQ(ray2.Position().Dot(plane2.Normal()), plane2.Coefficient());
-        ASSERT_EQ(TVector3(2, -4, 2), ray2.Position());
+        ASSERT_EQ(Vec3(2, -4, 2), ray2.Position());
         ASSERT_TRUE(ray2.Time() < init2);
     }
 
@@ -295,9 +295,9 @@ public:
     TEST_F(GeometricTest, PropagateToPlaneParallel)
     {
         Ray ray = CopyRay1();
-        Plane plane = Plane(TVector3(-2, 1, 1), TVector3(0, 0, 0));
-        TVector3 pos_init = ray.Position();
-        TVector3 dir_init = ray.Direction();
+        Plane plane = Plane(Vec3(-2, 1, 1), Vec3(0, 0, 0));
+        Vec3 pos_init = ray.Position();
+        Vec3 dir_init = ray.Direction();
         double time_init = ray.Time();
         ray.PropagateToPlane(plane);
         ASSERT_TRUE(Helper::VectorsEqual(pos_init, ray.Position(), 1e-6));
@@ -311,14 +311,14 @@ public:
     TEST_F(GeometricTest, PlaneImpact)
     {
         Ray ray1 = CopyRay1();
-        Plane plane1 = Plane(TVector3(1, 0, 0), TVector3(10, 0, 0));
+        Plane plane1 = Plane(Vec3(1, 0, 0), Vec3(10, 0, 0));
         ASSERT_EQ(ray1.PlaneImpact(plane1).Dot(plane1.Normal()), plane1.Coefficient());
-        ASSERT_EQ(TVector3(10, 5, 6), ray1.PlaneImpact(plane1));
+        ASSERT_EQ(Vec3(10, 5, 6), ray1.PlaneImpact(plane1));
 
         Ray ray2 = CopyRay2();
-        Plane plane2 = Plane(TVector3(0, 0, 1), TVector3(0, 0, 2));
+        Plane plane2 = Plane(Vec3(0, 0, 1), Vec3(0, 0, 2));
         ASSERT_EQ(ray2.PlaneImpact(plane2).Dot(plane2.Normal()), plane2.Coefficient());
-        ASSERT_EQ(TVector3(2, -4, 2), ray2.PlaneImpact(plane2));
+        ASSERT_EQ(Vec3(2, -4, 2), ray2.PlaneImpact(plane2));
     }
 
     /*
@@ -328,7 +328,7 @@ public:
     TEST_F(GeometricTest, PlaneImpactParallel)
     {
         Ray ray = CopyRay1();
-        Plane plane = Plane(TVector3(-2, 1, 1), TVector3(0, 0, 0));
+        Plane plane = Plane(Vec3(-2, 1, 1), Vec3(0, 0, 0));
         ASSERT_EQ(ray.Position(), ray.PlaneImpact(plane));
     }
 
@@ -338,12 +338,12 @@ public:
     TEST_F(GeometricTest, TimeToPlane)
     {
         Ray ray1 = CopyRay1();
-        Plane plane1 = Plane(TVector3(1, 0, 0), TVector3(10, 0, 0));
-        ASSERT_EQ(TVector3(3, 3, 3).Mag() / c_cent, ray1.TimeToPlane(plane1));
+        Plane plane1 = Plane(Vec3(1, 0, 0), Vec3(10, 0, 0));
+        ASSERT_EQ(Vec3(3, 3, 3).Mag() / c_cent, ray1.TimeToPlane(plane1));
 
         Ray ray2 = CopyRay2();
-        Plane plane2 = Plane(TVector3(0, 0, 1), TVector3(0, 0, 2));
-        ASSERT_EQ(- TVector3(2, -4, 2).Mag() / c_cent, ray2.TimeToPlane(plane2));
+        Plane plane2 = Plane(Vec3(0, 0, 1), Vec3(0, 0, 2));
+        ASSERT_EQ(- Vec3(2, -4, 2).Mag() / c_cent, ray2.TimeToPlane(plane2));
     }
 
     /*
@@ -352,7 +352,7 @@ public:
     TEST_F(GeometricTest, TimeToPlaneParallel)
     {
         Ray ray = CopyRay1();
-        Plane plane = Plane(TVector3(-2, 1, 1), TVector3(0, 0, 0));
+        Plane plane = Plane(Vec3(-2, 1, 1), Vec3(0, 0, 0));
         ASSERT_EQ(Infinity(), ray.TimeToPlane(plane));
     }
 
@@ -362,12 +362,12 @@ public:
     TEST_F(GeometricTest, Reflect)
     {
         Ray ray1 = CopyRay1();
-        ray1.Reflect(TVector3(-1, -1, 0));
-        ASSERT_TRUE(Helper::VectorsEqual(TVector3(-1, -1, 1).Unit() , ray1.Direction(), 1e-6));
+        ray1.Reflect(Vec3(-1, -1, 0));
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(-1, -1, 1).Unit() , ray1.Direction(), 1e-6));
 
         Ray ray2 = CopyRay2();
-        ray2.Reflect(TVector3(0, 1, 0));
-        ASSERT_TRUE(Helper::VectorsEqual(TVector3(-1, -2, -1).Unit() , ray2.Direction(), 1e-6));
+        ray2.Reflect(Vec3(0, 1, 0));
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(-1, -2, -1).Unit() , ray2.Direction(), 1e-6));
     }
 
     /*
@@ -377,7 +377,7 @@ public:
     {
         try
         {
-            CopyRay1().Reflect(TVector3(0, 0, 0));
+            CopyRay1().Reflect(Vec3(0, 0, 0));
             FAIL() << "Exception not thrown";
         }
         catch(invalid_argument& err)
@@ -391,19 +391,19 @@ public:
      */
     TEST_F(GeometricTest, Refract)
     {
-        Ray ray1 = Ray(TVector3(0, 0, 0), TVector3(1, -1, 0), 0.0);
-        ray1.Refract(TVector3(0, 1, 0), 1.0, 1.2);
+        Ray ray1 = Ray(Vec3(0, 0, 0), Vec3(1, -1, 0), 0.0);
+        ray1.Refract(Vec3(0, 1, 0), 1.0, 1.2);
         double theta_1 = ASin(Sin(Pi() / 4.0) / 1.2);
-        ASSERT_TRUE(Helper::VectorsEqual(TVector3(Tan(theta_1), -1, 0).Unit(), ray1.Direction(), 1e-6));
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(Tan(theta_1), -1, 0).Unit(), ray1.Direction(), 1e-6));
 
-        Ray ray2 = Ray(TVector3(0, 0, 0), TVector3(0, -1, 0), 0.0);
-        ray2.Refract(TVector3(0, 1, 0), 1.0, 1.7);
-        ASSERT_EQ(TVector3(0, -1, 0), ray2.Direction());
+        Ray ray2 = Ray(Vec3(0, 0, 0), Vec3(0, -1, 0), 0.0);
+        ray2.Refract(Vec3(0, 1, 0), 1.0, 1.7);
+        ASSERT_EQ(Vec3(0, -1, 0), ray2.Direction());
 
-        Ray ray3 = Ray(TVector3(0, 0, 0), TVector3(-1, 2, 0), 0.0);
-        ray3.Refract(TVector3(0, -1, 0), 1.3, 1.0);
+        Ray ray3 = Ray(Vec3(0, 0, 0), Vec3(-1, 2, 0), 0.0);
+        ray3.Refract(Vec3(0, -1, 0), 1.3, 1.0);
         double theta_3 = ASin(1.3 * Sin(ATan(0.5)));
-        ASSERT_TRUE(Helper::VectorsEqual(TVector3(-Tan(theta_3), 1, 0).Unit(), ray3.Direction(), 1e-6));
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(-Tan(theta_3), 1, 0).Unit(), ray3.Direction(), 1e-6));
     }
 
     /*
@@ -413,7 +413,7 @@ public:
     {
         try
         {
-            CopyRay1().Refract(TVector3(0, 0, 0), 1.0, 1.2);
+            CopyRay1().Refract(Vec3(0, 0, 0), 1.0, 1.2);
             FAIL() << "Exception not thrown";
         }
         catch(invalid_argument& err)
@@ -430,14 +430,14 @@ public:
         double n_in = 1.4;
         double theta_c = ASin(1.0 / n_in);
 
-        Ray ray1 = Ray(TVector3(0, 0, 0), TVector3(Tan(theta_c + 0.05), -1, 0), 0.0);
-        TVector3 init1 = ray1.Direction();
-        ASSERT_FALSE(ray1.Refract(TVector3(0, 1, 0), n_in, 1.0));
+        Ray ray1 = Ray(Vec3(0, 0, 0), Vec3(Tan(theta_c + 0.05), -1, 0), 0.0);
+        Vec3 init1 = ray1.Direction();
+        ASSERT_FALSE(ray1.Refract(Vec3(0, 1, 0), n_in, 1.0));
         ASSERT_TRUE(Helper::VectorsEqual(init1, ray1.Direction(), 1e-6));
 
-        Ray ray2 = Ray(TVector3(0, 0, 0), TVector3(Tan(theta_c - 0.05), -1, 0), 0.0);
-        TVector3 init2 = ray2.Direction();
-        ASSERT_TRUE(ray2.Refract(TVector3(0, 1, 0), n_in, 1.0));
+        Ray ray2 = Ray(Vec3(0, 0, 0), Vec3(Tan(theta_c - 0.05), -1, 0), 0.0);
+        Vec3 init2 = ray2.Direction();
+        ASSERT_TRUE(ray2.Refract(Vec3(0, 1, 0), n_in, 1.0));
         ASSERT_FALSE(Helper::VectorsEqual(init2, ray2.Direction(), 1e-6));
     }
 
@@ -448,7 +448,7 @@ public:
     {
         try
         {
-            CopyRay1().Refract(TVector3(-1, 0, 0), 0.9, 1.2);
+            CopyRay1().Refract(Vec3(-1, 0, 0), 0.9, 1.2);
             FAIL() << "Exception not thrown";
         }
         catch(invalid_argument& err)
@@ -457,7 +457,7 @@ public:
         }
         try
         {
-            CopyRay1().Refract(TVector3(0, -1, 0), 1.01, -0.8);
+            CopyRay1().Refract(Vec3(0, -1, 0), 1.01, -0.8);
             FAIL() << "Exception not thrown";
         }
         catch(invalid_argument& err)
@@ -472,20 +472,34 @@ public:
     TEST_F(GeometricTest, Transform)
     {
         Ray ray1 = CopyRay1();
-        TRotation rotation1 = TRotation();
+        Mat3 rotation1 = Mat3();
         rotation1.RotateZ(Pi() / 6.0);
         ray1.Transform(rotation1);
         double pos_ang = ATan(2.0 / 7.0) + Pi() / 6.0;
-        ASSERT_TRUE(Helper::VectorsEqual(TVector3(Sqrt(53.0) * Cos(pos_ang), Sqrt(53.0) * Sin(pos_ang), 3),
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(Sqrt(53.0) * Cos(pos_ang), Sqrt(53.0) * Sin(pos_ang), 3),
                                          ray1.Position(), 1e-6));
-        ASSERT_TRUE(Helper::VectorsEqual(TVector3(Sqrt(2.0) * Sin(Pi() / 12.0), Sqrt(2.0) * Cos(Pi() / 12.0), 1).Unit(),
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(Sqrt(2.0) * Sin(Pi() / 12.0), Sqrt(2.0) * Cos(Pi() / 12.0), 1).Unit(),
                                          ray1.Direction(), 1e-6));
 
         Ray ray2 = CopyRay2();
-        TRotation rotation2 = TRotation();
+        Mat3 rotation2 = Mat3();
         ray2.Transform(rotation2);
-        ASSERT_EQ(TVector3(0, 0, 0), ray2.Position());
-        ASSERT_TRUE(Helper::VectorsEqual(TVector3(-1, 2, -1).Unit(), ray2.Direction(), 1e-6));
+        ASSERT_EQ(Vec3(0, 0, 0), ray2.Position());
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(-1, 2, -1).Unit(), ray2.Direction(), 1e-6));
+    }
+
+    /*
+     * Test translating a ray to a frame with a different origin.
+     */
+    TEST_F(GeometricTest, Translate)
+    {
+        Ray ray = CopyRay1();
+        Vec3 direction = ray.Direction();
+        double time = ray.Time();
+        ray.Translate(Vec3(1, -2, 3));
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(8, 0, 6), ray.Position(), 1e-6));
+        ASSERT_EQ(direction, ray.Direction());
+        ASSERT_EQ(time, ray.Time());
     }
 
     /*
@@ -495,8 +509,8 @@ public:
     {
         Shower shower = CopyShower();
         ASSERT_EQ(2.7e19, shower.EnergyeV());
-        ASSERT_EQ(TVector3(0, 0, 2000000), shower.Position());
-        ASSERT_TRUE(Helper::VectorsEqual(TVector3(1, -1, -3).Unit(), shower.Direction(), 1e-6));
+        ASSERT_EQ(Vec3(0, 0, 2000000), shower.Position());
+        ASSERT_TRUE(Helper::VectorsEqual(Vec3(1, -1, -3).Unit(), shower.Direction(), 1e-6));
     }
 
     /*
@@ -506,7 +520,7 @@ public:
     {
         try
         {
-            Shower(-1.2e18, 150000, TVector3(), TVector3(1, 0, 0));
+            Shower(-1.2e18, 150000, Vec3(), Vec3(1, 0, 0));
             FAIL() << "Exception not thrown";
         }
         catch(invalid_argument& err)
@@ -562,7 +576,7 @@ public:
     TEST_F(GeometricTest, ImpactAngle)
     {
         Shower shower = CopyShower();
-        Plane horiz_plane = Plane(TVector3(0, 0, 1), TVector3());
+        Plane horiz_plane = Plane(Vec3(0, 0, 1), Vec3());
         ASSERT_EQ(shower.Direction().Angle(shower.PlaneImpact(horiz_plane)), shower.ImpactAngle());
     }
 
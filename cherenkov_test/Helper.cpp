@@ -4,6 +4,8 @@
 //
 // Implementation of Helper.h.
 
+#include <TMath.h>
+
 #include "Helper.h"
 #include "Utility.h"
 
@@ -11,7 +13,7 @@ using namespace TMath;
 
 namespace cherenkov_simulator
 {
-    bool Helper::VectorsEqual(TVector3 expected, TVector3 actual, double fractional_err)
+    bool Helper::VectorsEqual(Vec3 expected, Vec3 actual, double fractional_err)
     {
         bool x_equal = ValuesEqual(actual.X(), expected.X(), fractional_err);
         bool y_equal = ValuesEqual(actual.Y(), expected.Y(), fractional_err);
@@ -7,7 +7,7 @@
 #ifndef HELPER_H
 #define HELPER_H
 
-#include <TVector3.h>
+#include "Vec3.h"
 
 namespace cherenkov_simulator
 {
@@ -22,7 +22,7 @@ namespace cherenkov_simulator
          * A function which will check whether two vectors are equal within acceptable error. The allowable fractional
          * difference between each component is specified.
          */
-        static bool VectorsEqual(TVector3 actual, TVector3 expected, double fractional_err);
+        static bool VectorsEqual(Vec3 actual, Vec3 expected, double fractional_err);
 
         /*
          * Determines whether two decimals are equal within some acceptable fractional error.
@@ -0,0 +1,240 @@
+// OutputWriterTest.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of OutputWriter.h
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include <TFile.h>
+#include <TTree.h>
+
+#include "OutputWriter.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+    /*
+     * Makes a record with a row for the specified submission number. The row's ID is one more than the number.
+     */
+    static OutputRecord NumberedRecord(uint64_t number)
+    {
+        OutputRecord record = OutputRecord();
+        record.has_row = true;
+        record.id = number + 1;
+        record.attempt = number;
+        record.shower = Shower(1e19, 150000, Vec3(0, 0, 2000000), Vec3(1, -1, -3));
+        return record;
+    }
+
+    /*
+     * Reads the IDs of the rows in the CSV file and checks that the results tree has the same IDs in the same order.
+     */
+    static vector<uint64_t> ReadIDs(string output_file)
+    {
+        vector<uint64_t> csv_ids = vector<uint64_t>();
+        ifstream csv = ifstream(output_file + ".csv");
+        string line;
+        getline(csv, line);
+        while (getline(csv, line))
+        {
+            size_t begin = line.find(',') + 1;
+            csv_ids.push_back(stoull(line.substr(begin, line.find(',', begin) - begin)));
+        }
+
+        TFile root((output_file + ".root").c_str());
+        TTree* tree = root.Get<TTree>("results");
+        EXPECT_NE(nullptr, tree);
+        if (tree == nullptr) return csv_ids;
+        ULong64_t id;
+        tree->SetBranchAddress("id", &id);
+        EXPECT_EQ(csv_ids.size(), (size_t) tree->GetEntries());
+        for (Long64_t i = 0; i < tree->GetEntries() && i < (Long64_t) csv_ids.size(); i++)
+        {
+            tree->GetEntry(i);
+            EXPECT_EQ(csv_ids[i], id);
+        }
+        return csv_ids;
+    }
+
+    /*
+     * Returns the IDs 1 through n, which are the IDs of records 0 through n - 1.
+     */
+    static vector<uint64_t> FirstIDs(uint64_t n)
+    {
+        vector<uint64_t> ids = vector<uint64_t>();
+        for (uint64_t i = 1; i <= n; i++) ids.push_back(i);
+        return ids;
+    }
+
+    /*
+     * Records submitted out of order from a single thread should be written in order. Each group of four is submitted
+     * in reverse, which never gets further ahead than the capacity.
+     */
+    TEST(OutputWriterTest, OutOfOrder)
+    {
+        for (size_t capacity : {0, 4, 16})
+        {
+            {
+                OutputWriter writer("WriterOrder", Plane(Vec3(0, 0, 1), Vec3(0, 0, 0)), capacity);
+                for (uint64_t group = 0; group < 10; group++)
+                    for (uint64_t i = 4; i > 0; i--)
+                        writer.Submit(group * 4 + i - 1, NumberedRecord(group * 4 + i - 1));
+                writer.Close();
+            }
+            ASSERT_EQ(FirstIDs(40), ReadIDs("WriterOrder"));
+        }
+    }
+
+    /*
+     * Records submitted from several threads, each waiting on the others, should be written in order.
+     */
+    TEST(OutputWriterTest, Concurrent)
+    {
+        for (size_t capacity : {0, 1, 3})
+        {
+            {
+                OutputWriter writer("WriterConcurrent", Plane(Vec3(0, 0, 1), Vec3(0, 0, 0)), capacity);
+                vector<thread> threads = vector<thread>();
+                for (uint64_t t = 0; t < 4; t++)
+                {
+                    threads.emplace_back([&writer, t]()
+                    {
+                        for (uint64_t number = t; number < 100; number += 4)
+                            writer.Submit(number, NumberedRecord(number));
+                    });
+                }
+                for (thread& submitter : threads) submitter.join();
+                writer.Close();
+            }
+            ASSERT_EQ(FirstIDs(100), ReadIDs("WriterConcurrent"));
+        }
+    }
+
+    /*
+     * A record capacity or more ahead of the next one to write should block until the records before it are submitted.
+     * With a capacity of zero, records are held until they can be written, and Submit() never blocks.
+     */
+    TEST(OutputWriterTest, BackPressure)
+    {
+        for (size_t capacity : {1, 2, 5})
+        {
+            {
+                OutputWriter writer("WriterPressure", Plane(Vec3(0, 0, 1), Vec3(0, 0, 0)), capacity);
+                atomic<bool> submitted(false);
+                thread ahead = thread([&writer, &submitted, capacity]()
+                {
+                    writer.Submit(capacity, NumberedRecord(capacity));
+                    submitted = true;
+                });
+                this_thread::sleep_for(chrono::milliseconds(100));
+                EXPECT_FALSE(submitted);
+                for (uint64_t number = 0; number < capacity; number++)
+                    writer.Submit(number, NumberedRecord(number));
+                ahead.join();
+                EXPECT_TRUE(submitted);
+                writer.Close();
+            }
+            ASSERT_EQ(FirstIDs(capacity + 1), ReadIDs("WriterPressure"));
+        }
+
+        {
+            OutputWriter writer("WriterPressure", Plane(Vec3(0, 0, 1), Vec3(0, 0, 0)), 0);
+            for (uint64_t number = 20; number > 0; number--)
+                writer.Submit(number, NumberedRecord(number));
+            writer.Submit(0, NumberedRecord(0));
+            writer.Close();
+        }
+        ASSERT_EQ(FirstIDs(21), ReadIDs("WriterPressure"));
+    }
+
+    /*
+     * A writer with its own result header should write it to the CSV header, and a record's result fields should
+     * replace the columns of its Reconstructor::Result.
+     */
+    TEST(OutputWriterTest, ResultFields)
+    {
+        {
+            OutputWriter writer("WriterFields", Plane(Vec3(0, 0, 1), Vec3(0, 0, 0)), 0, nullptr, "First,Second");
+            OutputRecord record = NumberedRecord(0);
+            record.result_fields = "1.5,2.5";
+            record.weight = 4.0;
+            writer.Submit(0, move(record));
+            writer.Close();
+        }
+        ifstream csv = ifstream("WriterFields.csv");
+        string header, row;
+        getline(csv, header);
+        getline(csv, row);
+        string header_end = ", First,Second,Weight";
+        string row_end = ",1.5,2.5,4";
+        ASSERT_LT(header_end.size(), header.size());
+        ASSERT_EQ(header_end, header.substr(header.size() - header_end.size()));
+        ASSERT_LT(row_end.size(), row.size());
+        ASSERT_EQ(row_end, row.substr(row.size() - row_end.size()));
+    }
+
+    /*
+     * An error opening the files should be thrown by the constructor in the synchronous mode, and by Submit() or
+     * Close() in the asynchronous mode.
+     */
+    TEST(OutputWriterTest, OpenError)
+    {
+        Plane plane = Plane(Vec3(0, 0, 1), Vec3(0, 0, 0));
+        ASSERT_THROW(OutputWriter("NoSuchDirectory/WriterError", plane, 0), runtime_error);
+        for (size_t capacity : {1, 4})
+        {
+            OutputWriter writer("NoSuchDirectory/WriterError", plane, capacity);
+            ASSERT_THROW(
+                {
+                    for (uint64_t number = 0; number < 10; number++)
+                        writer.Submit(number, NumberedRecord(number));
+                    writer.Close();
+                }, runtime_error);
+        }
+    }
+
+    /*
+     * An error while writing a record, here from a checkpoint which can't replace the directory in its place, should
+     * be thrown by a later Submit() or Close(). The rows before the failed record should still be written.
+     */
+    TEST(OutputWriterTest, WriteError)
+    {
+        remove("WriterError.chk");
+        ASSERT_EQ(0, mkdir("WriterError.chk", 0755));
+        Plane plane = Plane(Vec3(0, 0, 1), Vec3(0, 0, 0));
+        for (size_t capacity : {0, 1, 4})
+        {
+            {
+                OutputWriter writer("WriterError", plane, capacity);
+                ASSERT_THROW(
+                    {
+                        for (uint64_t number = 0; number < 10; number++)
+                        {
+                            OutputRecord record = NumberedRecord(number);
+                            record.checkpoint = number == 3;
+                            writer.Submit(number, move(record));
+                        }
+                        writer.Close();
+                    }, runtime_error);
+            }
+
+            // The CSV rows up to the checkpoint were flushed before it failed.
+            ifstream csv = ifstream("WriterError.csv");
+            string line;
+            int n_lines = 0;
+            while (getline(csv, line)) n_lines++;
+            ASSERT_LE(5, n_lines);
+        }
+        rmdir("WriterError.chk");
+        remove("WriterError.chk.tmp");
+    }
+}
@@ -0,0 +1,81 @@
+// ParameterScanTest.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of ParameterScan.h
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <gtest/gtest.h>
+
+#include "ParameterScan.h"
+#include "Utility.h"
+
+using namespace std;
+using namespace boost::property_tree;
+
+namespace cherenkov_simulator
+{
+    /*
+     * Points should be read in order, with grids expanded and untagged points named by their overrides.
+     */
+    TEST(ParameterScanTest, Load)
+    {
+        {
+            ofstream file = ofstream("ScanLoad.xml");
+            file << "<scan>" << endl;
+            file << "<point tag=\"low\"><set key=\"elevation\"> 0 </set></point>" << endl;
+            file << "<grid><axis key=\"trigr_thresh\">5.0 6.0</axis>" << endl;
+            file << "<axis key=\"detector.n_pixels\">200 300 400</axis></grid>" << endl;
+            file << "</scan>" << endl;
+        }
+        vector<ParameterScan::Point> points = ParameterScan::Load("ScanLoad.xml");
+        ASSERT_EQ(7, points.size());
+        ASSERT_EQ("low", points[0].tag);
+        ASSERT_EQ(1, points[0].overrides.size());
+        ASSERT_EQ("0", points[0].overrides[0].second);
+        ASSERT_EQ("trigr_thresh_5.0_n_pixels_200", points[1].tag);
+        ASSERT_EQ("trigr_thresh_5.0_n_pixels_300", points[2].tag);
+        ASSERT_EQ("trigr_thresh_6.0_n_pixels_400", points[6].tag);
+        ASSERT_EQ("400", points[6].overrides[1].second);
+    }
+
+    /*
+     * Overrides should replace values by parameter name or full path, and unknown keys should be rejected.
+     */
+    TEST(ParameterScanTest, Apply)
+    {
+        ptree config = Utility::ParseXMLFile("../Config.xml").get_child("config");
+        ParameterScan::Point point = ParameterScan::Point();
+        point.overrides = {{"elevation", "0"}, {"detector.n_pixels", "200"}};
+        ptree applied = ParameterScan::Apply(config, point);
+        ASSERT_EQ(0.0, applied.get<double>("surroundings.elevation"));
+        ASSERT_EQ(200, applied.get<int>("detector.n_pixels"));
+        ASSERT_EQ(config.get<double>("triggering.trigr_thresh"), applied.get<double>("triggering.trigr_thresh"));
+
+        point.overrides = {{"not_a_parameter", "0"}};
+        ASSERT_THROW(ParameterScan::Apply(config, point), runtime_error);
+        point.overrides = {{"detector.not_a_parameter", "0"}};
+        ASSERT_THROW(ParameterScan::Apply(config, point), runtime_error);
+    }
+
+    /*
+     * A bad value in any point should be reported before the first point is run.
+     */
+    TEST(ParameterScanTest, BadValue)
+    {
+        ptree config = Utility::ParseXMLFile("../Config.xml").get_child("config");
+        ParameterScan::Point good = ParameterScan::Point();
+        good.tag = "good";
+        good.overrides = {{"trigr_thresh", "5.0"}};
+        ParameterScan::Point bad = ParameterScan::Point();
+        bad.tag = "bad";
+        bad.overrides = {{"trigr_thresh", "five"}};
+        remove("ScanBad_good.csv");
+        remove("ScanBad_scan.csv");
+        ASSERT_THROW(ParameterScan::Run(config, {good, bad}, "ScanBad"), runtime_error);
+        ASSERT_FALSE(ifstream("ScanBad_good.csv").good());
+        ASSERT_FALSE(ifstream("ScanBad_scan.csv").good());
+    }
+}
@@ -0,0 +1,174 @@
+// ProfileFitterTest.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of ProfileFitter.h
+
+#include <gtest/gtest.h>
+#include <TMath.h>
+#include <TRandom3.h>
+
+#include "ProfileFitter.h"
+
+using namespace std;
+using namespace TMath;
+
+namespace cherenkov_simulator
+{
+
+/*
+ * Note: this class will be able to access private members of the ProfileFitter class.
+ */
+class ProfileFitterTest : public ::testing::Test
+{
+public:
+
+    /*
+     * Generates points along the time profile with the specified parameters, with Gaussian errors of the specified
+     * size added to each time.
+     */
+    static FitPoints MakePoints(double t_0, double r_p, double psi, double error, int n_points, TRandom& random)
+    {
+        FitPoints points = FitPoints();
+        for (int i = 0; i < n_points; i++)
+        {
+            double angle = 0.1 + 1.2 * i / (n_points - 1.0);
+            points.angles.push_back(angle);
+            points.times.push_back(ProfileFitter::ProfileTime(angle, t_0, r_p, psi) + random.Gaus(0, error));
+            points.time_err.push_back(error);
+        }
+        return points;
+    }
+
+    /*
+     * Returns the chi-square of the points about the fit result.
+     */
+    static double ChiSquare(const FitPoints& points, const FitResult& result)
+    {
+        double chi2 = 0;
+        for (size_t i = 0; i < points.angles.size(); i++)
+        {
+            double model = ProfileFitter::ProfileTime(points.angles[i], result.t_0, result.r_p, result.psi);
+            chi2 += Sq((points.times[i] - model) / points.time_err[i]);
+        }
+        return chi2;
+    }
+
+    /*
+     * Returns the chi-square at the best r_p and t_0 for a fixed psi.
+     */
+    static double ProfiledChiSquare(const FitPoints& points, double psi)
+    {
+        ProfileFitter::Problem problem = ProfileFitter::MakeProblem(points, false, 0, 0);
+        double chi2, t_0;
+        ProfileFitter::Evaluate(problem, ProfileFitter::BestImpactParam(problem, psi), psi, chi2, t_0);
+        return chi2;
+    }
+};
+
+    /*
+     * Check that noiseless monocular data is fit exactly.
+     */
+    TEST_F(ProfileFitterTest, ExactMonocular)
+    {
+        TRandom3 random = TRandom3(1);
+        FitPoints points = MakePoints(3e-6, 1.5e6, 1.1, 1e-8, 30, random);
+        for (size_t i = 0; i < points.angles.size(); i++)
+            points.times[i] = ProfileFitter::ProfileTime(points.angles[i], 3e-6, 1.5e6, 1.1);
+        FitResult result = ProfileFitter::FitMonocular(points);
+        ASSERT_TRUE(result.converged);
+        ASSERT_NEAR(3e-6, result.t_0, 1e-12);
+        ASSERT_NEAR(1.5e6, result.r_p, 1.0);
+        ASSERT_NEAR(1.1, result.psi, 1e-6);
+    }
+
+    /*
+     * Check that noisy monocular fits reach the minimum chi-square, which is reported correctly, and that psi is a
+     * stationary point of the profiled chi-square.
+     */
+    TEST_F(ProfileFitterTest, NoisyMonocular)
+    {
+        TRandom3 random = TRandom3(2);
+        for (int i = 0; i < 50; i++)
+        {
+            FitPoints points = MakePoints(random.Uniform(1e-5), random.Uniform(5e5, 3e6), random.Uniform(0.5, 2.5), 5e-8,
+                                          40, random);
+            FitResult result = ProfileFitter::FitMonocular(points);
+            ASSERT_TRUE(result.converged);
+            ASSERT_NEAR(result.chi2, ChiSquare(points, result), 1e-6 * result.chi2);
+            ASSERT_LE(result.chi2, ProfiledChiSquare(points, result.psi - 1e-4) * (1 + 1e-9));
+            ASSERT_LE(result.chi2, ProfiledChiSquare(points, result.psi + 1e-4) * (1 + 1e-9));
+        }
+    }
+
+    /*
+     * Check that a hybrid fit recovers psi and keeps r_p on the constraint.
+     */
+    TEST_F(ProfileFitterTest, Hybrid)
+    {
+        TRandom3 random = TRandom3(3);
+        double psi = 0.9;
+        double alpha = 0.3;
+        double impact_distance = 2e6;
+        double r_p = impact_distance * Sin(psi + alpha);
+        FitPoints points = MakePoints(1e-6, r_p, psi, 1e-8, 30, random);
+        FitResult result = ProfileFitter::FitHybrid(points, impact_distance, alpha);
+        ASSERT_TRUE(result.converged);
+        ASSERT_NEAR(psi, result.psi, 1e-3);
+        ASSERT_NEAR(impact_distance * Sin(result.psi + alpha), result.r_p, 1e-6 * r_p);
+    }
+
+    /*
+     * Check that points with zero error are ignored, and that a fit with too few points doesn't converge.
+     */
+    TEST_F(ProfileFitterTest, UnusablePoints)
+    {
+        TRandom3 random = TRandom3(4);
+        FitPoints points = MakePoints(0, 1e6, 1.5, 1e-8, 20, random);
+        FitResult clean = ProfileFitter::FitMonocular(points);
+        points.angles.push_back(0.5);
+        points.times.push_back(1.0);
+        points.time_err.push_back(0.0);
+        FitResult extra = ProfileFitter::FitMonocular(points);
+        ASSERT_DOUBLE_EQ(clean.psi, extra.psi);
+
+        FitPoints few = FitPoints();
+        few.angles = {0.2, 0.4};
+        few.times = {1e-6, 2e-6};
+        few.time_err = {1e-8, 1e-8};
+        ASSERT_FALSE(ProfileFitter::FitMonocular(few).converged);
+    }
+
+    /*
+     * Check that a batch of mixed monocular and hybrid fits gives the same results as fitting each one separately.
+     */
+    TEST_F(ProfileFitterTest, BatchMatchesSingle)
+    {
+        TRandom3 random = TRandom3(5);
+        vector<FitRequest> requests = vector<FitRequest>();
+        for (int i = 0; i < 40; i++)
+        {
+            FitRequest request = FitRequest();
+            double psi = random.Uniform(0.5, 2.5);
+            request.hybrid = i % 2 == 1;
+            request.alpha = 0.2;
+            request.impact_distance = 1e6 / Sin(psi + request.alpha);
+            request.points = MakePoints(random.Uniform(1e-5), 1e6, psi, 5e-8, 10 + i, random);
+            requests.push_back(request);
+        }
+        vector<FitResult> results = ProfileFitter::FitBatch(requests);
+        ASSERT_EQ(requests.size(), results.size());
+        for (size_t i = 0; i < requests.size(); i++)
+        {
+            const FitRequest& request = requests[i];
+            FitResult single = request.hybrid ?
+                               ProfileFitter::FitHybrid(request.points, request.impact_distance, request.alpha) :
+                               ProfileFitter::FitMonocular(request.points);
+            ASSERT_EQ(single.converged, results[i].converged);
+            ASSERT_EQ(single.psi, results[i].psi);
+            ASSERT_EQ(single.r_p, results[i].r_p);
+            ASSERT_EQ(single.t_0, results[i].t_0);
+            ASSERT_EQ(single.chi2, results[i].chi2);
+        }
+    }
+}
@@ -0,0 +1,122 @@
+// RandomTest.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of Random.h
+
+#include <thread>
+#include <gtest/gtest.h>
+#include <TMath.h>
+#include <TRandom3.h>
+
+#include "Random.h"
+
+using namespace std;
+using namespace TMath;
+
+namespace cherenkov_simulator
+{
+    /*
+     * For the same seed, the uniform, exponential, integer, and small-mean Poisson numbers should be identical to those
+     * of TRandom3.
+     */
+    TEST(RandomTest, MatchesTRandom3)
+    {
+        unsigned int seeds[3] = {1, 4357, 3000000000u};
+        for (unsigned int seed : seeds)
+        {
+            TRandom3 root_random = TRandom3(seed);
+            Random random = Random(seed);
+            for (int i = 0; i < 2000; i++)
+            {
+                ASSERT_EQ(root_random.Rndm(), random.Rndm());
+                ASSERT_EQ(root_random.Uniform(-3.0, 5.0), random.Uniform(-3.0, 5.0));
+                ASSERT_EQ(root_random.Exp(2.5), random.Exp(2.5));
+                ASSERT_EQ(root_random.Integer(1000), random.Integer(1000));
+                ASSERT_EQ(root_random.Poisson(7.3), random.Poisson(7.3));
+            }
+
+            double root_array[700], array[700];
+            root_random.RndmArray(700, root_array);
+            random.RndmArray(700, array);
+            for (int i = 0; i < 700; i++) ASSERT_EQ(root_array[i], array[i]);
+        }
+        ASSERT_EQ(4357u, Random().GetSeed());
+    }
+
+    /*
+     * Reseeding should restart the stream, and a zero seed should be replaced by a nonzero one.
+     */
+    TEST(RandomTest, Seeding)
+    {
+        Random random = Random(7);
+        double first = random.Rndm();
+        random.Rndm();
+        random.SetSeed(7);
+        ASSERT_EQ(first, random.Rndm());
+        ASSERT_EQ(7u, random.GetSeed());
+        random.SetSeed(0);
+        ASSERT_NE(0u, random.GetSeed());
+    }
+
+    /*
+     * Inside a scope, Shared() should return the scope's generator on the calling thread only, and the previous
+     * generator should be restored when the scope ends.
+     */
+    TEST(RandomTest, Scope)
+    {
+        Random& shared = Random::Shared();
+        Random outer = Random(1);
+        Random inner = Random(2);
+        {
+            Random::Scope outer_scope(outer);
+            ASSERT_EQ(&outer, &Random::Shared());
+            {
+                Random::Scope inner_scope(inner);
+                ASSERT_EQ(&inner, &Random::Shared());
+                Random* other_thread = nullptr;
+                thread([&other_thread]() { other_thread = &Random::Shared(); }).join();
+                ASSERT_EQ(&shared, other_thread);
+            }
+            ASSERT_EQ(&outer, &Random::Shared());
+        }
+        ASSERT_EQ(&shared, &Random::Shared());
+    }
+
+    /*
+     * The Poisson numbers from the rejection and Gaussian methods, and the Gaussian numbers, should have the right
+     * mean and variance.
+     */
+    TEST(RandomTest, Moments)
+    {
+        Random random = Random(1);
+        double means[3] = {30.0, 1e5, 2e9};
+        for (double mean : means)
+        {
+            // Deviations from the mean are summed, so the sums don't lose precision for large means.
+            double sum = 0.0;
+            double sum_sq = 0.0;
+            int n_draws = 100000;
+            for (int i = 0; i < n_draws; i++)
+            {
+                double deviation = random.Poisson(mean) - mean;
+                sum += deviation;
+                sum_sq += deviation * deviation;
+            }
+            double variance = sum_sq / n_draws - Sq(sum / n_draws);
+            ASSERT_NEAR(0.0, sum / n_draws, 5.0 * Sqrt(mean / n_draws));
+            ASSERT_NEAR(mean, variance, 0.05 * mean);
+        }
+
+        double sum = 0.0;
+        double sum_sq = 0.0;
+        for (int i = 0; i < 100000; i++)
+        {
+            double value = random.Gaus(1.0, 2.0);
+            sum += value;
+            sum_sq += value * value;
+        }
+        ASSERT_NEAR(1.0, sum / 100000, 0.03);
+        ASSERT_NEAR(4.0, sum_sq / 100000 - 1.0, 0.1);
+    }
+}
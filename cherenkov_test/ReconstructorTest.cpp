@@ -0,0 +1,54 @@
+// ReconstructorTest.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of Reconstructor.h
+
+#include <gtest/gtest.h>
+
+#include "Random.h"
+#include "Reconstructor.h"
+#include "Simulator.h"
+
+using namespace std;
+using namespace boost::property_tree;
+
+namespace cherenkov_simulator
+{
+    /*
+     * Batched reconstruction of stored events should give exactly the same results as reconstructing each event on its
+     * own, including events which don't trigger.
+     */
+    TEST(ReconstructorTest, ReconstructBatch)
+    {
+        ptree config = Utility::ParseXMLFile("../Config.xml").get_child("config");
+        config.put("detector.n_pixels", 60);
+        Simulator simulator = Simulator(config);
+        Reconstructor reconstructor = Reconstructor(config);
+
+        vector<Reconstructor::Result> expected = vector<Reconstructor::Result>();
+        vector<Reconstructor::FitInput> inputs = vector<Reconstructor::FitInput>();
+        Random::Shared().SetSeed(11);
+        for (double energy : {1e20, 1e17, 3e19, 1e20})
+        {
+            Vec3 direction = Vec3(0.2, 0.1, -1).Unit();
+            Shower shower = Shower(energy, config.get<double>("surroundings.elevation"),
+                                   Vec3(1e5, 1.4e6, -2e4) - direction * 8e5, direction);
+            PhotonCount data = simulator.SimulateShower(shower);
+            reconstructor.AddNoise(data);
+            bool triggered = reconstructor.ClearNoise(data);
+            expected.push_back(reconstructor.Reconstruct(data, triggered));
+            inputs.push_back(reconstructor.PrepareFits(data, triggered));
+        }
+
+        vector<Reconstructor::Result> results = reconstructor.ReconstructBatch(inputs);
+        ASSERT_EQ(expected.size(), results.size());
+        ASSERT_TRUE(expected[0].triggered);
+        ASSERT_FALSE(expected[1].triggered);
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            ASSERT_EQ(expected[i].triggered, results[i].triggered);
+            ASSERT_EQ(expected[i].ToString(simulator.GroundPlane()), results[i].ToString(simulator.GroundPlane()));
+        }
+    }
+}
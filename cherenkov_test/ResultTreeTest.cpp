@@ -0,0 +1,71 @@
+// ResultTreeTest.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of ResultTree.h
+
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include <TFile.h>
+#include <TList.h>
+#include <TTree.h>
+
+#include "ResultTree.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+    /*
+     * Resuming should keep the first rows of the saved tree, drop the rest, and append new rows after them. The file
+     * should then hold a single tree with every kept and appended row.
+     */
+    TEST(ResultTreeTest, Resume)
+    {
+        Plane plane = Plane(Vec3(0, 0, 1), Vec3(0, 0, 0));
+        Shower shower = Shower(1e19, 150000, Vec3(0, 0, 2000000), Vec3(1, -1, -3));
+        Reconstructor::Result result = Reconstructor::Result();
+        {
+            TFile file("ResultResume.root", "RECREATE");
+            ResultTree results(plane);
+            for (uint64_t id = 1; id <= 10; id++)
+            {
+                results.Fill(0, id, id - 1, 1.0, shower, result);
+                if (id % 4 == 0) results.Save();
+            }
+            results.Write();
+        }
+
+        {
+            TFile file("ResultResume.root", "UPDATE");
+            ASSERT_THROW(ResultTree(plane, 11), runtime_error);
+        }
+
+        {
+            TFile file("ResultResume.root", "UPDATE");
+            ResultTree results(plane, 6);
+            ASSERT_EQ(6, results.NRows());
+            for (uint64_t id = 100; id < 103; id++)
+                results.Fill(0, id, id, 2.0, shower, result);
+            ASSERT_EQ(9, results.NRows());
+            results.Write();
+        }
+
+        TFile file("ResultResume.root");
+        ASSERT_EQ(1, file.GetListOfKeys()->GetSize());
+        TTree* tree = file.Get<TTree>("results");
+        ASSERT_NE(nullptr, tree);
+        ASSERT_EQ(9, tree->GetEntries());
+        ULong64_t id;
+        double weight;
+        tree->SetBranchAddress("id", &id);
+        tree->SetBranchAddress("weight", &weight);
+        vector<uint64_t> expected = {1, 2, 3, 4, 5, 6, 100, 101, 102};
+        for (Long64_t i = 0; i < tree->GetEntries(); i++)
+        {
+            tree->GetEntry(i);
+            ASSERT_EQ(expected[i], id);
+            ASSERT_EQ(i < 6 ? 1.0 : 2.0, weight);
+        }
+    }
+}
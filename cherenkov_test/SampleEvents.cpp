@@ -6,11 +6,13 @@
 
 #include <gtest/gtest.h>
 #include <TFile.h>
+#include <TMath.h>
 
 #include "Reconstructor.h"
 #include "Simulator.h"
 #include "MonteCarlo.h"
 #include "Analysis.h"
+#include "Equivalence.h"
 
 using namespace boost::property_tree;
 using namespace std;
@@ -23,11 +25,14 @@ namespace cherenkov_simulator
     protected:
 
         MonteCarlo* monte_carlo;
+        double stop_diameter;
 
         virtual void SetUp()
         {
             ptree config = Utility::ParseXMLFile("../Config.xml").get_child("config");
             monte_carlo = new MonteCarlo(config);
+            double f_number = config.get<double>("detector.f_number");
+            stop_diameter = config.get<double>("detector.mirror_radius") / (2.0 * f_number);
         }
 
         virtual void TearDown()
@@ -39,6 +44,49 @@ namespace cherenkov_simulator
         {
             return monte_carlo->simulator.GroundPlane();
         }
+
+        const Simulator& FriendSimulator()
+        {
+            return monte_carlo->simulator;
+        }
+
+        double FriendAcceptAngle()
+        {
+            return ACos(monte_carlo->simulator.accept_cos);
+        }
+
+        double FriendAngularSize()
+        {
+            return monte_carlo->simulator.count_params.ang_size;
+        }
+
+        double FriendPrefilterThreshold(const MonteCarlo& other)
+        {
+            return other.prefl_thresh;
+        }
+
+        double FriendPeakSignalToNoise(const MonteCarlo& other, Shower shower)
+        {
+            return other.simulator.PeakSignalToNoise(shower);
+        }
+
+        bool FriendTriggers(const MonteCarlo& other, Shower shower)
+        {
+            PhotonCount data = other.simulator.SimulateShower(shower);
+            other.reconstructor.AddNoise(data);
+            return other.reconstructor.ClearNoise(data);
+        }
+
+        bool FriendTraceOptics(double angle)
+        {
+            const Simulator& simulator = monte_carlo->simulator;
+            Vec3 direction = Vec3(0, 0, -1);
+            direction.Rotate(angle, Vec3(0, 1, 0));
+            direction.Rotate(Random::Shared().Uniform(TwoPi()), Vec3(0, 0, 1));
+            Ray photon = Ray(simulator.RandomStopImpact(), direction, 0);
+            Vec3 camera_impact;
+            return simulator.TraceOptics(photon, camera_impact);
+        }
     };
 
     /*
@@ -47,7 +95,7 @@ namespace cherenkov_simulator
     TEST_F(SampleEvents, StraightShower)
     {
         TFile file("StraightShower.root", "RECREATE");
-        Shower shower = monte_carlo->GenerateShower(TVector3(0, 0, -1), 1e6, 0, 1e19);
+        Shower shower = monte_carlo->GenerateShower(Vec3(0, 0, -1), 1e6, 0, 1e19);
         Reconstructor::Result result = monte_carlo->RunSingleShower(shower, "straight_shower");
         cout << "Energy, " << shower.Header() << ", " << result.Header() << endl;
         cout << shower.EnergyeV() << ", " << shower.ToString(FriendGroundPlane()) << ", "
@@ -60,7 +108,7 @@ namespace cherenkov_simulator
     TEST_F(SampleEvents, TypicalShower)
     {
         TFile file("TypicalShower.root", "RECREATE");
-        Shower shower = monte_carlo->GenerateShower(TVector3(1, 1, -3), 1e6, -0.1, 1e19);
+        Shower shower = monte_carlo->GenerateShower(Vec3(1, 1, -3), 1e6, -0.1, 1e19);
         Reconstructor::Result result = monte_carlo->RunSingleShower(shower, "typical_shower");
         cout << "Energy, " << shower.Header() << ", " << result.Header() << endl;
         cout << shower.EnergyeV() << ", " << shower.ToString(FriendGroundPlane()) << ", "
@@ -73,10 +121,106 @@ namespace cherenkov_simulator
     TEST_F(SampleEvents, DistantShower)
     {
         TFile file("DistantShower.root", "RECREATE");
-        Shower shower = monte_carlo->GenerateShower(TVector3(0, 0, -1), 3e6, 0, 1e19);
+        Shower shower = monte_carlo->GenerateShower(Vec3(0, 0, -1), 3e6, 0, 1e19);
         Reconstructor::Result result = monte_carlo->RunSingleShower(shower, "distant_shower");
         cout <<  endl << "Energy," << shower.Header() << "," << result.Header() << endl;
         cout << shower.EnergyeV() << "," << shower.ToString(FriendGroundPlane()) << ","
              << result.ToString(FriendGroundPlane()) << endl;
     }
-}
\ No newline at end of file
+
+    /*
+     * Checks that the analytic pre-filter estimate bounds the brightest pixel and time bin of the noise-free
+     * simulation for the sample showers above.
+     */
+    TEST_F(SampleEvents, PrefilterBound)
+    {
+        Random::Shared().SetSeed(1);
+        vector<Shower> showers = {
+                monte_carlo->GenerateShower(Vec3(0, 0, -1), 1e6, 0, 1e19),
+                monte_carlo->GenerateShower(Vec3(1, 1, -3), 1e6, -0.1, 1e19),
+                monte_carlo->GenerateShower(Vec3(0, 0, -1), 3e6, 0, 1e19)};
+        for (const Shower& shower : showers)
+        {
+            PhotonCount data = FriendSimulator().SimulateShower(shower);
+            double peak = 0.0;
+            PhotonCount::Iterator iter = data.GetIterator();
+            while (iter.Next())
+                for (short count : data.Signal(iter))
+                    peak = Max(peak, (double) count);
+            double sigma = Sqrt(data.RealNoiseRate(Sq(stop_diameter / 2.0) * Pi() * glob_sky_noise));
+            EXPECT_LE(peak / sigma, FriendSimulator().PeakSignalToNoise(shower));
+        }
+    }
+
+    /*
+     * Checks that no shower near the triggering threshold which actually triggers would have been rejected by the
+     * pre-filter. Low-energy showers at large impact parameters are drawn, and those with a peak signal-to-noise bound
+     * below 2000 are simulated with noise. About one in ten of these triggers.
+     */
+    TEST_F(SampleEvents, PrefilterNearThreshold)
+    {
+        ptree config = Utility::ParseXMLFile("../Config.xml").get_child("config");
+        config.put("monte_carlo.energy_min", 1e18);
+        config.put("monte_carlo.energy_max", 3e19);
+        config.put("monte_carlo.impact_min", 1e6);
+        config.put("monte_carlo.impact_max", 4e6);
+        MonteCarlo faint(config);
+        double prefl_thresh = FriendPrefilterThreshold(faint);
+
+        Random::Shared().SetSeed(1);
+        int n_simulated = 0;
+        int n_triggered = 0;
+        while (n_simulated < 30)
+        {
+            Shower shower = faint.GenerateShower();
+            double bound = FriendPeakSignalToNoise(faint, shower);
+            if (bound <= 0.0 || bound >= 2000.0) continue;
+            n_simulated++;
+            if (!FriendTriggers(faint, shower)) continue;
+            n_triggered++;
+            EXPECT_GE(bound, prefl_thresh);
+        }
+        cout << n_triggered << " of " << n_simulated << " showers triggered" << endl;
+        EXPECT_GT(n_triggered, 0);
+    }
+
+    /*
+     * Noise drawn from pre-generated banks should be statistically equivalent to noise drawn directly from a Poisson
+     * distribution. Both configurations have the same Simulator, so the noise checks are the ones which compare the
+     * two paths. The timing of each path is printed with the report.
+     */
+    TEST_F(SampleEvents, NoiseBankEquivalence)
+    {
+        ptree reference = Utility::ParseXMLFile("../Config.xml").get_child("config");
+        reference.put("simulation.noise_bank", false);
+        ptree candidate = reference;
+        candidate.put("simulation.noise_bank", true);
+
+        vector<Shower> showers = {
+                monte_carlo->GenerateShower(Vec3(0, 0, -1), 1e6, 0, 1e19),
+                monte_carlo->GenerateShower(Vec3(1, 1, -3), 1e6, -0.1, 1e19)};
+        Equivalence::Report report = Equivalence(reference, candidate).Compare(showers, 10);
+        cout << report.ToString();
+        EXPECT_TRUE(report.Passed());
+    }
+
+    /*
+     * Checks that no photon outside the acceptance cone reaches the camera, and that the cone is not much wider than
+     * the field of view. Most of the photons outside are traced within a pixel of the edge of the cone, where the
+     * margin of AcceptanceAngle() is all that keeps them out, from random points on the stop.
+     */
+    TEST_F(SampleEvents, AcceptanceCone)
+    {
+        Random::Shared().SetSeed(1);
+        double angle = FriendAcceptAngle();
+        double pixel = FriendAngularSize();
+        int n_inside = 0;
+        for (int i = 0; i < 100000; i++)
+        {
+            ASSERT_FALSE(FriendTraceOptics(Random::Shared().Uniform(angle, angle + pixel)));
+            ASSERT_FALSE(FriendTraceOptics(Random::Shared().Uniform(angle, angle + 0.02)));
+            n_inside += FriendTraceOptics(Random::Shared().Uniform(angle - 0.02, angle));
+        }
+        EXPECT_GT(n_inside, 0);
+    }
+}
@@ -0,0 +1,112 @@
+// ShardMergerTest.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of ShardMerger.h
+
+#include <fstream>
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include <TFile.h>
+#include <TH1D.h>
+#include <TTree.h>
+
+#include "OutputWriter.h"
+#include "ShardMerger.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+    /*
+     * Writes the outputs of a shard whose showers triggered at the specified stream positions. Each shower's weight and
+     * the content of its product are its position, so merged rows can be traced back to the shard row they came from.
+     */
+    static void WriteShard(string output_file, unsigned int shard, unsigned int seed, vector<uint64_t> attempts)
+    {
+        OutputWriter writer(ShardMerger::ShardName(output_file, shard), Plane(Vec3(0, 0, 1), Vec3(0, 0, 0)), 0);
+        for (uint64_t i = 0; i < attempts.size(); i++)
+        {
+            OutputRecord record = OutputRecord();
+            record.has_row = true;
+            record.seed = seed;
+            record.id = i + 1;
+            record.attempt = attempts[i];
+            record.weight = attempts[i];
+            record.shower = Shower(1e19, 150000, Vec3(0, 0, 2000000), Vec3(1, -1, -3));
+            TH1D* histo = new TH1D("histo", "Attempt", 1, 0, 1);
+            histo->SetBinContent(1, attempts[i]);
+            record.products.emplace_back(to_string(i + 1) + "_after_clear_time", histo);
+            writer.Submit(i, move(record));
+        }
+        writer.Close();
+    }
+
+    /*
+     * The merged rows should be in stream order and numbered from one, with products renamed to match, and the CSV
+     * file and results tree should hold the same rows.
+     */
+    TEST(ShardMergerTest, Merge)
+    {
+        WriteShard("MergeTest", 0, 7, {0, 6, 9});
+        WriteShard("MergeTest", 1, 7, {1, 4, 13, 16});
+        WriteShard("MergeTest", 2, 7, {8});
+        ShardMerger::Merge("MergeTest", 3);
+        vector<uint64_t> expected = {0, 1, 4, 6, 8, 9, 13, 16};
+
+        ifstream csv = ifstream("MergeTest.csv");
+        string line;
+        getline(csv, line);
+        vector<string> lines = vector<string>();
+        while (getline(csv, line)) lines.push_back(line);
+        ASSERT_EQ(expected.size(), lines.size());
+
+        TFile root("MergeTest.root");
+        TTree* tree = root.Get<TTree>("results");
+        ASSERT_NE(nullptr, tree);
+        ASSERT_EQ((Long64_t) expected.size(), tree->GetEntries());
+        UInt_t seed;
+        ULong64_t id, attempt;
+        double weight;
+        tree->SetBranchAddress("seed", &seed);
+        tree->SetBranchAddress("id", &id);
+        tree->SetBranchAddress("attempt", &attempt);
+        tree->SetBranchAddress("weight", &weight);
+        for (uint64_t i = 0; i < expected.size(); i++)
+        {
+            tree->GetEntry((Long64_t) i);
+            ASSERT_EQ(7u, seed);
+            ASSERT_EQ(i + 1, id);
+            ASSERT_EQ(expected[i], attempt);
+            ASSERT_EQ((double) expected[i], weight);
+
+            // The seed, ID, and weight are the first, second, and last fields of the CSV row.
+            string prefix = "7," + to_string(i + 1) + ",";
+            ASSERT_EQ(prefix, lines[i].substr(0, prefix.size()));
+            ASSERT_EQ((double) expected[i], stod(lines[i].substr(lines[i].rfind(',') + 1)));
+
+            TH1D* histo = root.Get<TH1D>((to_string(i + 1) + "_after_clear_time").c_str());
+            ASSERT_NE(nullptr, histo);
+            ASSERT_EQ((double) expected[i], histo->GetBinContent(1));
+        }
+    }
+
+    /*
+     * Shards run with different seeds or written with different CSV headers should be rejected.
+     */
+    TEST(ShardMergerTest, Mismatch)
+    {
+        WriteShard("MergeSeed", 0, 7, {0, 2});
+        WriteShard("MergeSeed", 1, 8, {1});
+        ASSERT_THROW(ShardMerger::Merge("MergeSeed", 2), runtime_error);
+
+        WriteShard("MergeHeader", 0, 7, {0, 2});
+        WriteShard("MergeHeader", 1, 7, {1});
+        {
+            ofstream csv = ofstream(ShardMerger::ShardName("MergeHeader", 1) + ".csv");
+            csv << "Seed,ID,Energy\n" << "7,1,1e+19\n";
+        }
+        ASSERT_THROW(ShardMerger::Merge("MergeHeader", 2), runtime_error);
+        ASSERT_THROW(ShardMerger::Merge("MergeMissing", 2), runtime_error);
+    }
+}
@@ -0,0 +1,108 @@
+// StationTest.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of Station.h
+
+#include <gtest/gtest.h>
+
+#include "Random.h"
+#include "Station.h"
+
+using namespace std;
+using namespace boost::property_tree;
+
+namespace cherenkov_simulator
+{
+    /*
+     * Note: this class is a friend of Station, so it can access private methods.
+     */
+    class StationTest : public testing::Test
+    {
+    protected:
+
+        ptree config;
+
+        virtual void SetUp()
+        {
+            config = Utility::ParseXMLFile("../Config.xml").get_child("config");
+            config.put("detector.n_pixels", 60);
+        }
+
+        vector<size_t> FriendRoute(const Station& station, Vec3 direction)
+        {
+            vector<size_t> units;
+            station.Route(direction, units);
+            return units;
+        }
+
+        /*
+         * Checks every unit without the index.
+         */
+        vector<size_t> BruteForceRoute(const Station& station, Vec3 direction)
+        {
+            vector<size_t> units;
+            for (size_t i = 0; i < station.NUnits(); i++)
+                if (direction.Unit().Dot(station.unit_axes[i]) > station.route_cos[i]) units.push_back(i);
+            return units;
+        }
+    };
+
+    /*
+     * The angular index should never leave out a unit which can see a direction, at any resolution.
+     */
+    TEST_F(StationTest, Routing)
+    {
+        Random::Shared().SetSeed(1);
+        for (int bins : {1, 7, 180})
+        {
+            config.put("station.index_bins", bins);
+            Station station = Station(config);
+            for (int i = 0; i < 20000; i++)
+            {
+                Vec3 direction = Vec3(Random::Shared().Gaus(), Random::Shared().Gaus(), Random::Shared().Gaus());
+                ASSERT_EQ(BruteForceRoute(station, direction), FriendRoute(station, direction));
+            }
+        }
+        Station station = Station(config);
+        ASSERT_EQ(vector<size_t>({1}), FriendRoute(station, Vec3(0, 1, 0.045)));
+        ASSERT_EQ(vector<size_t>(), FriendRoute(station, Vec3(0, -1, 0)));
+
+        config.put("station.unit_azims", "0.0");
+        ASSERT_THROW(Station bad_station = Station(config), invalid_argument);
+    }
+
+    /*
+     * A station with a single unit, routing light in every direction, should give exactly the same photons, photon
+     * tallies, and reconstruction as the monocular Simulator and Reconstructor.
+     */
+    TEST_F(StationTest, SingleUnit)
+    {
+        config.put("station.unit_elevs", config.get<string>("surroundings.elevation_angle"));
+        config.put("station.unit_azims", config.get<string>("surroundings.azimuth_angle"));
+        config.put("station.route_margin", 4.0);
+        Station station = Station(config);
+        Simulator simulator = Simulator(config);
+        Reconstructor reconstructor = Reconstructor(config);
+
+        Vec3 direction = Vec3(0.2, 0.1, -1).Unit();
+        Shower shower = Shower(1e20, config.get<double>("surroundings.elevation"),
+                               Vec3(1e5, 1.4e6, -2e4) - direction * 8e5, direction);
+        Random::Shared().SetSeed(5);
+        vector<PhotonCount> station_data = station.SimulateShower(shower);
+        Reconstructor::Result station_result = station.Reconstruct(station_data);
+        Random::Shared().SetSeed(5);
+        PhotonCount data = simulator.SimulateShower(shower);
+        reconstructor.AddNoise(data);
+        Reconstructor::Result result = Reconstructor::Result();
+        if (reconstructor.ClearNoise(data)) result = reconstructor.Reconstruct(data, true);
+
+        ASSERT_EQ(1, station_data.size());
+        ASSERT_EQ(data.PixelSums(), station_data[0].PixelSums());
+        ASSERT_LT(0, data.GetTally().accepted);
+        ASSERT_EQ(data.GetTally().culled, PhotonCount::SumTallies(station_data).culled);
+        ASSERT_EQ(data.GetTally().accepted, PhotonCount::SumTallies(station_data).accepted);
+        ASSERT_TRUE(result.triggered);
+        ASSERT_EQ(result.ToString(simulator.GroundPlane()), station_result.ToString(station.GroundPlane()));
+    }
+}
@@ -0,0 +1,93 @@
+// StereoTest.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of Stereo.h
+
+#include <gtest/gtest.h>
+
+#include "Stereo.h"
+
+using namespace std;
+using namespace boost::property_tree;
+
+namespace cherenkov_simulator
+{
+    /*
+     * Note: this class is a friend of Stereo, so it can access private methods.
+     */
+    class StereoTest : public testing::Test
+    {
+    protected:
+
+        ptree config;
+
+        virtual void SetUp()
+        {
+            config = Utility::ParseXMLFile("../Config.xml").get_child("config");
+        }
+
+        Shower FriendIntersectPlanes(const Stereo& stereo, const Shower& mono_1, Vec3 site_1, const Shower& mono_2,
+                                     Vec3 site_2)
+        {
+            return stereo.IntersectPlanes(mono_1, site_1, mono_2, site_2);
+        }
+    };
+
+    /*
+     * The site lists should be split on semicolons, and lists of different lengths should be rejected.
+     */
+    TEST_F(StereoTest, SiteLists)
+    {
+        vector<string> items = Utility::SplitList("(0, 1, 2); (3, 4, 5);");
+        ASSERT_EQ(2, items.size());
+        ASSERT_EQ(Vec3(3, 4, 5), Utility::ToVector(items[1]));
+
+        config.put("stereo.site_posns", "(0, 3.0e6, 0); (3.0e6, 0, 0)");
+        config.put("stereo.site_azims", "3.14159265; -1.57079633");
+        ASSERT_EQ(3, Stereo(config).NSites());
+        config.put("stereo.site_azims", "3.14159265");
+        ASSERT_THROW(Stereo stereo = Stereo(config), invalid_argument);
+    }
+
+    /*
+     * Shower-detector planes containing the true axis, seen from two sites, should intersect along the true axis. The
+     * reconstructed shower should pass through the point closest to the origin.
+     */
+    TEST_F(StereoTest, IntersectPlanes)
+    {
+        Stereo stereo = Stereo(config);
+        Vec3 site_1 = Vec3(0, 0, 0);
+        Vec3 site_2 = Vec3(0, 3.0e6, 0);
+        Vec3 position = Vec3(2.0e5, 1.5e6, 1.0e6);
+        Vec3 direction = Vec3(0.3, -0.2, -1).Unit();
+        Shower shower = Shower(1e19, 141400, position, direction, 1e-4);
+
+        // Each monocular fit is taken to lie somewhere else along the axis.
+        Shower mono_1 = Shower(1.0, 1.0, position + direction * (5e-6 * c_cent), direction, 1e-4 + 5e-6);
+        Shower mono_2 = Shower(1.0, 1.0, position - direction * (2e-6 * c_cent), direction, 1e-4 - 2e-6);
+        Shower stereo_recon = FriendIntersectPlanes(stereo, mono_1, site_1, mono_2, site_2);
+
+        ASSERT_NEAR(0.0, stereo_recon.Direction().Angle(shower.Direction()), 1e-9);
+        ASSERT_NEAR(shower.ImpactParam(), stereo_recon.ImpactParam(), 1e-3);
+        ASSERT_NEAR(0.0, stereo_recon.Position().Dot(shower.Direction()), 1e-3);
+        Vec3 offset = stereo_recon.Position() - shower.Position();
+        ASSERT_NEAR(shower.Time() + offset.Dot(shower.Direction()) / c_cent, stereo_recon.Time(), 1e-12);
+    }
+
+    /*
+     * Without two triggered sites there is no pair of planes to intersect, so no stereo reconstruction should be made,
+     * even if any opening angle is allowed.
+     */
+    TEST_F(StereoTest, NoPair)
+    {
+        config.put("stereo.min_angle", 0.0);
+        Stereo stereo = Stereo(config);
+        vector<PhotonCount> data = vector<PhotonCount>(stereo.NSites());
+        Stereo::Result result = stereo.Reconstruct(data);
+        ASSERT_FALSE(result.reconstructed);
+        ASSERT_EQ(0.0, result.open_angle);
+        for (const Reconstructor::Result& site : result.sites)
+            ASSERT_FALSE(site.triggered);
+    }
+}
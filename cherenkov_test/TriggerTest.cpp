@@ -0,0 +1,145 @@
+// TriggerTest.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of Trigger.h
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+#include "Trigger.h"
+
+using namespace std;
+
+namespace cherenkov_simulator
+{
+
+/*
+ * Note: this class will be able to access private members of the TriggerEngine class.
+ */
+class TriggerTest : public ::testing::Test
+{
+public:
+
+    /*
+     * Shifts a single-row frame through the engine's private helper and returns the result as a frame.
+     */
+    static BitFrame ShiftRow(const BitFrame& frame, int shift)
+    {
+        TriggerEngine engine = TriggerEngine(1, frame.NCols(), TriggerEngine::line, 1);
+        BitFrame output = BitFrame(1, frame.NCols());
+        engine.Shift(frame.Row(0), shift, output.Row(0));
+        return output;
+    }
+};
+
+    /*
+     * Check that pattern names are parsed and that unknown names are rejected.
+     */
+    TEST_F(TriggerTest, ParsePattern)
+    {
+        ASSERT_EQ(TriggerEngine::cluster, TriggerEngine::ParsePattern("cluster"));
+        ASSERT_EQ(TriggerEngine::line, TriggerEngine::ParsePattern("line"));
+        ASSERT_THROW(TriggerEngine::ParsePattern("square"), runtime_error);
+    }
+
+    /*
+     * Check that shifts carry bits across word boundaries and drop bits past the end of the row.
+     */
+    TEST_F(TriggerTest, ShiftAcrossWords)
+    {
+        BitFrame frame = BitFrame(1, 100);
+        frame.Set(0, 64);
+        frame.Set(0, 99);
+        BitFrame lower = ShiftRow(frame, 1);
+        ASSERT_TRUE(lower.Get(0, 63));
+        ASSERT_TRUE(lower.Get(0, 98));
+        BitFrame upper = ShiftRow(frame, -1);
+        ASSERT_TRUE(upper.Get(0, 65));
+        ASSERT_EQ(uint64_t(1) << 1, upper.Row(0)[1]);
+    }
+
+    /*
+     * Check that a diagonal cluster triggers the cluster pattern only once it reaches the pattern size.
+     */
+    TEST_F(TriggerTest, ClusterPattern)
+    {
+        TriggerEngine engine = TriggerEngine(5, 5, TriggerEngine::cluster, 4);
+        BitFrame frame = BitFrame(5, 5);
+        frame.Set(0, 0);
+        frame.Set(1, 1);
+        frame.Set(2, 2);
+        frame.Set(4, 4);
+        ASSERT_FALSE(engine.Push(frame));
+        frame.Set(3, 2);
+        ASSERT_TRUE(engine.Push(frame));
+    }
+
+    /*
+     * Check that a single pixel doesn't trigger the cluster pattern, even with a pattern size of one. This matches the
+     * breadth-first search which the engine replaced.
+     */
+    TEST_F(TriggerTest, SinglePixelCluster)
+    {
+        TriggerEngine engine = TriggerEngine(5, 5, TriggerEngine::cluster, 1);
+        BitFrame frame = BitFrame(5, 5);
+        frame.Set(2, 2);
+        frame.Set(4, 0);
+        ASSERT_FALSE(engine.Push(frame));
+        frame.Set(3, 1);
+        ASSERT_TRUE(engine.Push(frame));
+    }
+
+    /*
+     * Check that the line pattern finds rows, columns, and diagonals, but not bent shapes.
+     */
+    TEST_F(TriggerTest, LinePattern)
+    {
+        TriggerEngine engine = TriggerEngine(6, 70, TriggerEngine::line, 3);
+        BitFrame bent = BitFrame(6, 70);
+        bent.Set(0, 0);
+        bent.Set(1, 0);
+        bent.Set(1, 1);
+        ASSERT_FALSE(engine.Push(bent));
+
+        BitFrame row = BitFrame(6, 70);
+        row.Set(2, 62);
+        row.Set(2, 63);
+        row.Set(2, 64);
+        ASSERT_TRUE(engine.Push(row));
+
+        BitFrame column = BitFrame(6, 70);
+        column.Set(3, 5);
+        column.Set(4, 5);
+        column.Set(5, 5);
+        ASSERT_TRUE(engine.Push(column));
+
+        BitFrame diagonal = BitFrame(6, 70);
+        diagonal.Set(0, 66);
+        diagonal.Set(1, 65);
+        diagonal.Set(2, 64);
+        ASSERT_TRUE(engine.Push(diagonal));
+    }
+
+    /*
+     * Check that decisions are recorded for every frame and that trigger times mark the start of each triggered run.
+     */
+    TEST_F(TriggerTest, TriggerTimes)
+    {
+        TriggerEngine engine = TriggerEngine(2, 2, TriggerEngine::cluster, 1);
+        BitFrame empty = BitFrame(2, 2);
+        BitFrame full = BitFrame(2, 2);
+        full.Set(0, 0);
+        full.Set(1, 1);
+        for (const BitFrame* frame : {&empty, &full, &full, &empty, &full})
+            engine.Push(*frame);
+        ASSERT_EQ(5, engine.NFrames());
+        ASSERT_TRUE(engine.Triggered());
+        ASSERT_EQ(vector<size_t>({1, 4}), engine.TriggerTimes());
+        ASSERT_FALSE(engine.Decisions()[3]);
+        ASSERT_THROW(engine.Push(BitFrame(3, 2)), invalid_argument);
+        engine.Reset();
+        ASSERT_EQ(0, engine.NFrames());
+        ASSERT_FALSE(engine.Triggered());
+    }
+}
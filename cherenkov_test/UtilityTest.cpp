@@ -4,16 +4,19 @@
 //
 // Tests of Utility.h
 
+#include <set>
 #include <gtest/gtest.h>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 #include <TFile.h>
 #include <TH1I.h>
+#include <TMath.h>
 
 #include "MonteCarlo.h"
 
 using namespace std;
 using namespace boost::property_tree;
+using namespace TMath;
 
 namespace cherenkov_simulator
 {
@@ -31,4 +34,98 @@ namespace cherenkov_simulator
         }
         power_histo.Write("power_histo");
     }
-}
\ No newline at end of file
+
+    TEST(MiscellaneousTest, MinEigenvector)
+    {
+        /*
+         * Build symmetric matrices from known eigenvectors and check that the one with the smallest eigenvalue is
+         * recovered, including when the other two eigenvalues are repeated.
+         */
+        Vec3 basis[3] = {Vec3(1, 2, 2).Unit(), Vec3(2, 1, -2).Unit(), Vec3(2, -2, 1).Unit()};
+        double values[2][3] = {{3.0, 1e-4, 7.5}, {2.0, 2.0, 0.5}};
+        int min_index[2] = {1, 2};
+        for (int n = 0; n < 2; n++)
+        {
+            double matrix[3][3] = {};
+            for (int k = 0; k < 3; k++)
+                for (int i = 0; i < 3; i++)
+                    for (int j = 0; j < 3; j++)
+                        matrix[i][j] += values[n][k] * basis[k][i] * basis[k][j];
+            Vec3 vec = Utility::MinEigenvector(matrix);
+            ASSERT_NEAR(1.0, vec.Mag(), 1e-12);
+            ASSERT_NEAR(1.0, Abs(vec.Dot(basis[min_index[n]])), 1e-9);
+        }
+
+        // A diagonal matrix should return the axis with the smallest entry.
+        double diagonal[3][3] = {{4, 0, 0}, {0, 9, 0}, {0, 0, -1}};
+        ASSERT_NEAR(1.0, Abs(Utility::MinEigenvector(diagonal).Z()), 1e-12);
+    }
+
+    TEST(MiscellaneousTest, StreamSeed)
+    {
+        /*
+         * Seeds should be reproducible, nonzero, and different for neighboring positions and runs.
+         */
+        ASSERT_EQ(Utility::StreamSeed(12345, 7), Utility::StreamSeed(12345, 7));
+        set<unsigned int> seeds = set<unsigned int>();
+        for (unsigned int run_seed = 0; run_seed < 4; run_seed++)
+        {
+            for (uint64_t position = 0; position < 1000; position++)
+            {
+                unsigned int seed = Utility::StreamSeed(run_seed, position);
+                ASSERT_NE(0, seed);
+                seeds.insert(seed);
+            }
+        }
+        ASSERT_EQ(4000, seeds.size());
+    }
+
+    TEST(MiscellaneousTest, PowerDensity)
+    {
+        /*
+         * The densities should integrate to one, and reweighting draws from one power law by the ratio of densities
+         * should reproduce the mean of another.
+         */
+        double pows[3] = {-1.0, 0.5, 1.0};
+        for (double pow : pows)
+        {
+            double integral = 0.0;
+            int n_steps = 100000;
+            double step = Log(1e3) / n_steps;
+            for (int i = 0; i < n_steps; i++)
+            {
+                double x = Exp((i + 0.5) * step);
+                integral += Utility::PowerDensity(x, 1.0, 1e3, pow) * x * step;
+            }
+            ASSERT_NEAR(1.0, integral, 1e-6);
+        }
+        ASSERT_EQ(0.0, Utility::PowerDensity(0.5, 1.0, 1e3, 1.0));
+
+        Random::Shared().SetSeed(1);
+        double weight_sum = 0.0;
+        double value_sum = 0.0;
+        int n_draws = 1000000;
+        for (int i = 0; i < n_draws; i++)
+        {
+            double x = Utility::RandPower(1.0, 10.0, 0.0);
+            double weight = Utility::PowerDensity(x, 1.0, 10.0, 1.0) / Utility::PowerDensity(x, 1.0, 10.0, 0.0);
+            weight_sum += weight;
+            value_sum += weight * x;
+        }
+        ASSERT_NEAR(1.0, weight_sum / n_draws, 1e-2);
+        ASSERT_NEAR(2.0 / 3.0 * (1e3 - 1.0) / (1e2 - 1.0), value_sum / n_draws, 1e-2);
+    }
+
+    TEST(MiscellaneousTest, Integrate)
+    {
+        /*
+         * Polynomials of low degree should be integrated exactly, and smooth functions, including sharply peaked
+         * ones, to the requested tolerance.
+         */
+        ASSERT_NEAR(2.0 / 3.0, Utility::Integrate([](double x) { return x * x; }, -1.0, 1.0), 1e-15);
+        ASSERT_NEAR(Exp(3.0) - 1.0, Utility::Integrate([](double x) { return Exp(x); }, 0.0, 3.0), 1e-11);
+        double peaked = Utility::Integrate([](double x) { return 1.0 / (1e-4 + Sq(x)); }, -1.0, 1.0);
+        ASSERT_NEAR(2.0 * ATan(1e2) / 1e-2, peaked, 1e-10 * peaked);
+        ASSERT_NEAR(0.0, Utility::Integrate([](double x) { return x; }, -1.0, 1.0), 1e-15);
+    }
+}
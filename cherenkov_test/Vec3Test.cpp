@@ -0,0 +1,100 @@
+// Vec3Test.cpp
+//
+// Author: Matthew Dutson
+//
+// Tests of Vec3.h
+
+#include <gtest/gtest.h>
+#include <TMath.h>
+#include <TRotation.h>
+#include <TVector3.h>
+
+#include "Random.h"
+#include "Vec3.h"
+
+using namespace std;
+using namespace TMath;
+
+namespace cherenkov_simulator
+{
+    /*
+     * Checks that a Vec3 and a TVector3 have the same components.
+     */
+    static void ExpectSame(const TVector3& expected, const Vec3& actual)
+    {
+        EXPECT_NEAR(expected.X(), actual.X(), 1e-12 * (1.0 + expected.Mag()));
+        EXPECT_NEAR(expected.Y(), actual.Y(), 1e-12 * (1.0 + expected.Mag()));
+        EXPECT_NEAR(expected.Z(), actual.Z(), 1e-12 * (1.0 + expected.Mag()));
+    }
+
+    /*
+     * The Vec3 methods which share names with TVector3 methods should give the same results on random vectors.
+     */
+    TEST(Vec3Test, MatchesTVector3)
+    {
+        Random::Shared().SetSeed(1);
+        for (int i = 0; i < 1000; i++)
+        {
+            double a[3], b[3];
+            for (int j = 0; j < 3; j++)
+            {
+                a[j] = Random::Shared().Uniform(-10, 10);
+                b[j] = Random::Shared().Uniform(-10, 10);
+            }
+            TVector3 root_a = TVector3(a[0], a[1], a[2]);
+            TVector3 root_b = TVector3(b[0], b[1], b[2]);
+            Vec3 vec_a = Vec3(a[0], a[1], a[2]);
+            Vec3 vec_b = Vec3(b[0], b[1], b[2]);
+
+            ExpectSame(root_a.Unit(), vec_a.Unit());
+            ExpectSame(root_a.Cross(root_b), vec_a.Cross(vec_b));
+            ExpectSame(root_a.Orthogonal(), vec_a.Orthogonal());
+            EXPECT_NEAR(root_a.Dot(root_b), vec_a.Dot(vec_b), 1e-12);
+            EXPECT_NEAR(root_a.Mag(), vec_a.Mag(), 1e-12);
+            EXPECT_NEAR(root_a.Angle(root_b), vec_a.Angle(vec_b), 1e-12);
+            EXPECT_NEAR(root_a.Phi(), vec_a.Phi(), 1e-12);
+            EXPECT_NEAR(root_a.Theta(), vec_a.Theta(), 1e-12);
+            EXPECT_NEAR(root_a.CosTheta(), vec_a.CosTheta(), 1e-12);
+
+            double angle = Random::Shared().Uniform(-Pi(), Pi());
+            root_a.Rotate(angle, root_b);
+            vec_a.Rotate(angle, vec_b);
+            ExpectSame(root_a, vec_a);
+            root_a.RotateX(angle);
+            vec_a.RotateX(angle);
+            root_a.RotateY(angle);
+            vec_a.RotateY(angle);
+            root_a.RotateZ(angle);
+            vec_a.RotateZ(angle);
+            ExpectSame(root_a, vec_a);
+        }
+        ASSERT_EQ(0.0, Vec3().Angle(Vec3(1, 0, 0)));
+        ASSERT_EQ(1.0, Vec3().CosTheta());
+    }
+
+    /*
+     * Mat3 rotations should compose in the same order as TRotation, and Inverse() should undo them.
+     */
+    TEST(Vec3Test, MatchesTRotation)
+    {
+        TRotation root_rot = TRotation();
+        root_rot.RotateX(0.3);
+        root_rot.RotateY(-1.1);
+        root_rot.RotateZ(2.0);
+        root_rot.Rotate(0.7, TVector3(1, 2, 3));
+        root_rot.RotateAxes(TVector3(0, 1, 0), TVector3(0, 0, 1), TVector3(1, 0, 0));
+        Mat3 mat = Mat3();
+        mat.RotateX(0.3);
+        mat.RotateY(-1.1);
+        mat.RotateZ(2.0);
+        mat.Rotate(0.7, Vec3(1, 2, 3));
+        mat.RotateAxes(Vec3(0, 1, 0), Vec3(0, 0, 1), Vec3(1, 0, 0));
+
+        TVector3 root_vec = TVector3(4, -5, 6);
+        Vec3 vec = Vec3(4, -5, 6);
+        ExpectSame(root_rot * root_vec, mat * vec);
+        ExpectSame(root_rot.Inverse() * root_vec, mat.Inverse() * vec);
+        ExpectSame(root_vec, mat.Inverse() * (mat * vec));
+        ExpectSame(root_rot * root_rot * root_vec, (mat * mat) * vec);
+    }
+}
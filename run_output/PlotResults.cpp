@@ -75,14 +75,41 @@ void MakeDoubleProfile(TTree& tree, Params par, const char* x_lab, const char* y
 
 }
 
-void PlotResults(const char* csv_file)
+void PlotResults(const char* input_file)
 {
-    TTree tree;
-    const char* branch_desc = "seed:id:energy:psi:im:gnd:trig:mono_psi:mono_im:mono_gnd:chkv:chkv_psi:chkv_im:chkv_gnd";
-    tree.ReadFile(csv_file, branch_desc, ',');
+    // Results are read directly from the tree in the simulation's ROOT file, or parsed from its CSV file.
+    // The input file owns its tree, so it stays open until the plots are written.
+    string input = input_file;
+    TTree csv_tree;
+    TTree* tree_ptr = &csv_tree;
+    unique_ptr<TFile> input_root;
+    if (input.size() > 5 && input.substr(input.size() - 5) == ".root")
+    {
+        input_root.reset(TFile::Open(input_file));
+        tree_ptr = input_root && !input_root->IsZombie() ? (TTree*) input_root->Get("results") : nullptr;
+        if (tree_ptr == nullptr)
+        {
+            cout << "No results tree found in " << input << endl;
+            return;
+        }
+    }
+    else
+    {
+        // Older CSV files have no weight column.
+        ifstream csv(input_file);
+        string header;
+        getline(csv, header);
+        string branch_desc = "seed:id:energy:psi:im:gnd:trig:mono_psi:mono_im:mono_gnd:chkv:chkv_psi:chkv_im:chkv_gnd";
+        if (header.find("Weight") != string::npos) branch_desc += ":weight";
+        csv_tree.ReadFile(input_file, branch_desc.c_str(), ',');
+    }
+    TTree& tree = *tree_ptr;
     TFile file("Results.root", "RECREATE");
     Params par;
 
+    // Importance-sampled runs are aggregated with their weights, so the plots describe the prior distributions.
+    if (tree.GetBranch("weight") != nullptr) par.filter = "weight * (chkv > 0)";
+
     par.mono_name = "mono_im_err";
     par.chkv_name = "chkv_im_err";
     par.mono_strn = "(mono_im - im) / im";